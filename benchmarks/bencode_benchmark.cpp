@@ -0,0 +1,252 @@
+#include <benchmark/benchmark.h>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include "bittorrent/bencode.hpp"
+
+using namespace bittorrent::bencode;
+
+namespace {
+
+// Non-compact announce reply: a list of peer dictionaries, as returned by trackers that ignore `compact=1`.
+std::string make_announce_response(int peer_count) {
+    std::string out = "d8:completei1200e10:incompletei800e8:intervali1800e5:peersl";
+    for (int i = 0; i < peer_count; ++i) {
+        std::string ip = "10." + std::to_string(i / 65536 % 256) + "." + std::to_string(i / 256 % 256) + "." +
+                         std::to_string(i % 256);
+        std::string peer_id = "-BT0001-" + std::string(12, static_cast<char>('a' + i % 26));
+        out += "d2:ip" + std::to_string(ip.size()) + ":" + ip;
+        out += "7:peer id20:" + peer_id;
+        out += "4:porti" + std::to_string(6881 + i % 1000) + "ee";
+    }
+    out += "ee";
+    return out;
+}
+
+// Multi-file torrent with many small path components and a large `pieces` blob.
+std::string make_torrent(int file_count, int piece_count) {
+    std::string files = "l";
+    for (int i = 0; i < file_count; ++i) {
+        std::string dir = "dir" + std::to_string(i / 100);
+        std::string name = "file-" + std::to_string(i) + ".bin";
+        files += "d6:lengthi" + std::to_string(1000 + i * 37) + "e4:pathl";
+        files += std::to_string(dir.size()) + ":" + dir + std::to_string(name.size()) + ":" + name + "ee";
+    }
+    files += "e";
+
+    std::string pieces(static_cast<std::size_t>(piece_count) * 20, '\0');
+    for (std::size_t i = 0; i < pieces.size(); ++i) {
+        pieces[i] = static_cast<char>(i * 131 % 251);
+    }
+
+    std::string out = "d8:announce41:http://bttracker.debian.org:6969/announce4:infod";
+    out += "5:files" + files;
+    out += "4:name7:dataset12:piece lengthi262144e";
+    out += "6:pieces" + std::to_string(pieces.size()) + ":" + pieces;
+    out += "ee";
+    return out;
+}
+
+const std::string& announce_input() {
+    static const std::string input = make_announce_response(5000);
+    return input;
+}
+
+const std::string& torrent_input() {
+    static const std::string input = make_torrent(20000, 100000);
+    return input;
+}
+
+template <typename Fn>
+void run_with_kernel(benchmark::State& state, const std::string& input, Fn&& parse) {
+    const auto kernel = static_cast<ScanKernel>(state.range(0));
+    if (!force_scan_kernel(kernel)) {
+        state.SkipWithError("scan kernel not supported on this CPU");
+        return;
+    }
+    state.SetLabel(std::string(to_string(kernel)));
+
+    for (auto _ : state) {
+        auto result = parse(input);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * input.size()));
+}
+
+void BM_ParseAnnounce(benchmark::State& state) {
+    run_with_kernel(state, announce_input(), [](std::string_view data) { return Parser::parse(data); });
+}
+
+void BM_ParseViewAnnounce(benchmark::State& state) {
+    run_with_kernel(state, announce_input(), [](std::string_view data) { return Parser::parse_view(data); });
+}
+
+void BM_TapeAnnounce(benchmark::State& state) {
+    run_with_kernel(state, announce_input(), [](std::string_view data) { return Tape::parse(data); });
+}
+
+void BM_ParseTorrent(benchmark::State& state) {
+    run_with_kernel(state, torrent_input(), [](std::string_view data) { return Parser::parse(data); });
+}
+
+void BM_ParseViewTorrent(benchmark::State& state) {
+    run_with_kernel(state, torrent_input(), [](std::string_view data) { return Parser::parse_view(data); });
+}
+
+void BM_TapeTorrent(benchmark::State& state) {
+    run_with_kernel(state, torrent_input(), [](std::string_view data) { return Tape::parse(data); });
+}
+
+void kernel_args(benchmark::internal::Benchmark* bench) {
+    for (auto kernel : {ScanKernel::Scalar, ScanKernel::Sse2, ScanKernel::Avx2}) {
+        bench->Arg(static_cast<int>(kernel));
+    }
+}
+
+}  // anonymous namespace
+
+BENCHMARK(BM_ParseAnnounce)->Apply(kernel_args);
+BENCHMARK(BM_ParseViewAnnounce)->Apply(kernel_args);
+BENCHMARK(BM_TapeAnnounce)->Apply(kernel_args);
+BENCHMARK(BM_ParseTorrent)->Apply(kernel_args);
+BENCHMARK(BM_ParseViewTorrent)->Apply(kernel_args);
+BENCHMARK(BM_TapeTorrent)->Apply(kernel_args);
+
+namespace {
+
+// Kernel throughput in isolation, on runs long enough for the vector width to matter.
+void BM_ScanDigits(benchmark::State& state) {
+    static const std::string input = std::string(64 * 1024, '7') + ":";
+    run_with_kernel(state, input, [](std::string_view data) { return scan_digits(data, 0); });
+}
+
+void BM_ScanFor(benchmark::State& state) {
+    static const std::string input = std::string(64 * 1024, 'x') + "e";
+    run_with_kernel(state, input, [](std::string_view data) { return scan_for(data, 0, 'e'); });
+}
+
+}  // anonymous namespace
+
+BENCHMARK(BM_ScanDigits)->Apply(kernel_args);
+BENCHMARK(BM_ScanFor)->Apply(kernel_args);
+
+namespace {
+
+// Lookups of the keys TorrentInfo reads from every `info` dictionary.
+template <typename Dict>
+void run_info_lookups(benchmark::State& state, const Dict& info) {
+    static constexpr std::string_view keys[] = {"files", "length", "name", "piece length", "pieces", "private"};
+    for (auto _ : state) {
+        for (auto key : keys) {
+            benchmark::DoNotOptimize(info.find(key));
+        }
+    }
+}
+
+void BM_FlatDictionaryLookup(benchmark::State& state) {
+    Dictionary info;
+    for (auto key : {"files", "name", "piece length", "pieces", "source"}) {
+        info[key] = Value{Integer{1}};
+    }
+    run_info_lookups(state, info);
+}
+
+void BM_MapDictionaryLookup(benchmark::State& state) {
+    std::map<std::string, Value, std::less<>> info;
+    for (auto key : {"files", "name", "piece length", "pieces", "source"}) {
+        info[key] = Value{Integer{1}};
+    }
+    run_info_lookups(state, info);
+}
+
+}  // anonymous namespace
+
+BENCHMARK(BM_FlatDictionaryLookup);
+BENCHMARK(BM_MapDictionaryLookup);
+
+namespace {
+
+void BM_EncodeTorrent(benchmark::State& state) {
+    auto value = Parser::parse(torrent_input());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Encoder::encode(*value));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * torrent_input().size()));
+}
+
+void BM_EncodeTorrentIntoBuffer(benchmark::State& state) {
+    auto value = Parser::parse(torrent_input());
+    std::vector<char> buffer(Encoder::encoded_size(*value));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Encoder::encode_to(std::span<char>(buffer), *value));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * torrent_input().size()));
+}
+
+}  // anonymous namespace
+
+BENCHMARK(BM_EncodeTorrent);
+BENCHMARK(BM_EncodeTorrentIntoBuffer);
+
+namespace {
+
+struct BenchFile {
+    Integer length{0};
+    std::vector<std::string_view> path;
+};
+
+struct BenchInfo {
+    std::vector<BenchFile> files;
+    std::string_view name;
+    Integer piece_length{0};
+    std::string_view pieces;
+};
+
+struct BenchTorrent {
+    std::string_view announce;
+    BenchInfo info;
+};
+
+}  // anonymous namespace
+
+template <>
+struct bittorrent::bencode::Schema<BenchFile> {
+    static constexpr auto fields = std::tuple{
+        required_field("length", &BenchFile::length),
+        required_field("path", &BenchFile::path),
+    };
+};
+
+template <>
+struct bittorrent::bencode::Schema<BenchInfo> {
+    static constexpr auto fields = std::tuple{
+        field("files", &BenchInfo::files),
+        required_field("name", &BenchInfo::name),
+        required_field("piece length", &BenchInfo::piece_length),
+        required_field("pieces", &BenchInfo::pieces),
+    };
+};
+
+template <>
+struct bittorrent::bencode::Schema<BenchTorrent> {
+    static constexpr auto fields = std::tuple{
+        required_field("announce", &BenchTorrent::announce),
+        required_field("info", &BenchTorrent::info),
+    };
+};
+
+namespace {
+
+void BM_DecodeTorrent(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(decode<BenchTorrent>(torrent_input()));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * torrent_input().size()));
+}
+
+}  // anonymous namespace
+
+BENCHMARK(BM_DecodeTorrent);
@@ -0,0 +1,55 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "bittorrent/utils/crypto.hpp"
+
+using namespace bittorrent;
+
+namespace {
+
+constexpr std::size_t kBatchSize = 8;
+
+// Eight distinct pieces of `piece_size` bytes, as a recheck would hand them to the hasher.
+const std::vector<std::string>& pieces(std::size_t piece_size) {
+    static std::vector<std::string> cache;
+    if (cache.empty() || cache.front().size() != piece_size) {
+        cache.assign(kBatchSize, std::string(piece_size, '\0'));
+        for (std::size_t p = 0; p < kBatchSize; ++p) {
+            for (std::size_t i = 0; i < piece_size; ++i) {
+                cache[p][i] = static_cast<char>((i * 131 + p) % 251);
+            }
+        }
+    }
+    return cache;
+}
+
+void BM_Sha1Batch(benchmark::State& state) {
+    const auto kernel = static_cast<utils::Sha1Kernel>(state.range(0));
+    if (!utils::force_sha1_kernel(kernel)) {
+        state.SkipWithError("sha1 kernel not supported on this CPU");
+        return;
+    }
+    state.SetLabel(std::string(utils::to_string(kernel)));
+
+    const auto& buffers = pieces(static_cast<std::size_t>(state.range(1)));
+    const std::vector<std::string_view> inputs(buffers.begin(), buffers.end());
+    std::vector<core::SHA1Hash> digests(inputs.size());
+    for (auto _ : state) {
+        utils::sha1_batch(inputs, digests);
+        benchmark::DoNotOptimize(digests.data());
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * inputs.size() * buffers.front().size()));
+}
+
+void kernel_and_piece_size_args(benchmark::internal::Benchmark* bench) {
+    for (auto kernel : {utils::Sha1Kernel::OpenSsl, utils::Sha1Kernel::ShaNi, utils::Sha1Kernel::Avx2}) {
+        for (std::int64_t piece_size : {16 * 1024, 256 * 1024, 4 * 1024 * 1024}) {
+            bench->Args({static_cast<std::int64_t>(kernel), piece_size});
+        }
+    }
+}
+
+}  // anonymous namespace
+
+BENCHMARK(BM_Sha1Batch)->Apply(kernel_and_piece_size_args);
@@ -0,0 +1,88 @@
+#include <benchmark/benchmark.h>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <spdlog/spdlog.h>
+#include <string>
+#include "bittorrent/core.hpp"
+#include "bittorrent/network.hpp"
+
+using namespace bittorrent;
+
+namespace {
+
+namespace asio = boost::asio;
+namespace http = boost::beast::http;
+using tcp = asio::ip::tcp;
+
+// Keep-alive HTTP tracker on 127.0.0.1 answering every announce with a 50-peer compact reply.
+asio::awaitable<void> serve(tcp::socket socket) {
+    std::string body = "d8:intervali1800e5:peers300:" + std::string(300, '\x01') + "e";
+    boost::beast::flat_buffer buffer;
+    for (;;) {
+        http::request<http::empty_body> req;
+        boost::system::error_code ec;
+        co_await http::async_read(socket, buffer, req, asio::redirect_error(asio::use_awaitable, ec));
+        if (ec) {
+            co_return;
+        }
+        http::response<http::string_body> res{http::status::ok, 11};
+        res.body() = body;
+        res.keep_alive(req.keep_alive());
+        res.prepare_payload();
+        co_await http::async_write(socket, res, asio::redirect_error(asio::use_awaitable, ec));
+        if (ec || !req.keep_alive()) {
+            co_return;
+        }
+    }
+}
+
+asio::awaitable<void> accept_loop(tcp::acceptor& acceptor) {
+    for (;;) {
+        auto socket = co_await acceptor.async_accept(asio::use_awaitable);
+        asio::co_spawn(acceptor.get_executor(), serve(std::move(socket)), asio::detached);
+    }
+}
+
+// Sequential announces to one tracker; range(0) is 1 with the connection pool and 0 with pooling disabled, which
+// pays for a TCP handshake (and teardown) per announce as the tracker did before pooling.
+void BM_HttpAnnounce(benchmark::State& state) {
+    spdlog::set_level(spdlog::level::warn);
+    asio::io_context io_context;
+    tcp::acceptor acceptor(io_context, {asio::ip::address_v4::loopback(), 0});
+    asio::co_spawn(io_context, accept_loop(acceptor), asio::detached);
+
+    auto options = network::ConnectionPool::kDefaultOptions;
+    options.max_idle_per_host = state.range(0) ? options.max_idle_per_host : 0;
+    network::HttpTracker tracker(io_context, options);
+    const auto url = "http://127.0.0.1:" + std::to_string(acceptor.local_endpoint().port()) + "/announce";
+
+    core::InfoHash info_hash{};
+    core::PeerID peer_id{};
+    for (auto _ : state) {
+        asio::co_spawn(
+            io_context,
+            [&]() -> asio::awaitable<void> {
+                auto result = co_await tracker.announce(url, info_hash, peer_id, 6881, 0, 0, 1000);
+                if (!result) {
+                    state.SkipWithError("announce failed");
+                }
+                io_context.stop();
+            },
+            asio::detached
+        );
+        io_context.restart();
+        io_context.run();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["connections"] = static_cast<double>(tracker.connection_pool().connections_opened());
+}
+
+}  // anonymous namespace
+
+BENCHMARK(BM_HttpAnnounce)->ArgName("pooled")->Arg(0)->Arg(1);
@@ -1,6 +1,11 @@
 #pragma once
 
+#include "bencode/decode.hpp"
 #include "bencode/encoder.hpp"
 #include "bencode/errors.hpp"
+#include "bencode/flat_dictionary.hpp"
 #include "bencode/parser.hpp"
+#include "bencode/scan.hpp"
+#include "bencode/stream_parser.hpp"
+#include "bencode/tape.hpp"
 #include "bencode/value.hpp"
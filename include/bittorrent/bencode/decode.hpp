@@ -0,0 +1,410 @@
+#pragma once
+
+#include "errors.hpp"
+#include "tape.hpp"
+#include "value.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace bittorrent::bencode {
+
+struct DecodeError {
+    enum class Kind {
+        Syntax,
+        TypeMismatch,
+        MissingField,
+        InvalidValue,
+    };
+
+    Kind kind;
+    std::size_t offset{0};       // input position of the offending value
+    std::string_view field{};    // innermost schema key involved, empty at the top level
+    ParseError syntax{ParseError::InvalidFormat};  // Syntax only
+    TokenType expected{};        // TypeMismatch only
+    TokenType actual{};          // TypeMismatch only
+};
+
+std::string to_string(const DecodeError& error);
+
+// Pull-style single-pass reader over an encoded document. Values are consumed strictly in order; nothing is
+// materialised beyond the string views handed to the caller, which point into the input.
+class Reader {
+public:
+    static constexpr std::size_t kMaxDepth = 64;
+
+    explicit Reader(std::string_view data) noexcept : data_(data) {}
+
+    std::size_t position() const noexcept { return pos_; }
+
+    std::string_view data() const noexcept { return data_; }
+
+    std::expected<TokenType, DecodeError> peek() const;
+
+    std::expected<Integer, DecodeError> read_integer();
+
+    std::expected<std::string_view, DecodeError> read_string();
+
+    // Calls `on_item()` once per element; it must consume exactly one value from the reader.
+    template <typename Fn>
+    std::expected<void, DecodeError> read_list(Fn&& on_item);
+
+    // Calls `on_entry(key)` once per entry; it must consume exactly the value. Keys must be strictly increasing,
+    // as Parser requires.
+    template <typename Fn>
+    std::expected<void, DecodeError> read_dictionary(Fn&& on_entry);
+
+    // Validates and skips one value.
+    std::expected<void, DecodeError> skip();
+
+    // Validates one value and returns its exact encoded bytes.
+    std::expected<std::string_view, DecodeError> read_raw();
+
+    DecodeError syntax_error(ParseError error) const noexcept { return {DecodeError::Kind::Syntax, pos_, {}, error}; }
+
+    // Reports why the next value is not of type `expected`: a TypeMismatch, or a Syntax error if it is not a value.
+    DecodeError type_error(TokenType expected) const noexcept;
+
+private:
+    std::expected<void, DecodeError> enter(char opener);
+
+    std::string_view data_;
+    std::size_t pos_{0};
+    std::size_t depth_{0};
+};
+
+template <typename Fn>
+std::expected<void, DecodeError> Reader::read_list(Fn&& on_item) {
+    if (auto entered = enter('l'); !entered) {
+        return entered;
+    }
+    while (pos_ < data_.size() && data_[pos_] != 'e') {
+        if (auto result = on_item(); !result) {
+            return result;
+        }
+    }
+    if (pos_ == data_.size()) {
+        return std::unexpected(syntax_error(ParseError::UnexpectedEnd));
+    }
+    ++pos_;
+    --depth_;
+    return {};
+}
+
+template <typename Fn>
+std::expected<void, DecodeError> Reader::read_dictionary(Fn&& on_entry) {
+    if (auto entered = enter('d'); !entered) {
+        return entered;
+    }
+    std::optional<std::string_view> last_key;
+    while (pos_ < data_.size() && data_[pos_] != 'e') {
+        if (static_cast<unsigned char>(data_[pos_] - '0') > 9) {
+            return std::unexpected(syntax_error(ParseError::InvalidFormat));
+        }
+        const std::size_t key_offset = pos_;
+        auto key = read_string();
+        if (!key) {
+            return std::unexpected(key.error());
+        }
+        if (last_key && *key <= *last_key) {
+            return std::unexpected(DecodeError{DecodeError::Kind::Syntax, key_offset, {}, ParseError::InvalidFormat});
+        }
+        last_key = *key;
+        if (auto result = on_entry(*key); !result) {
+            return result;
+        }
+    }
+    if (pos_ == data_.size()) {
+        return std::unexpected(syntax_error(ParseError::UnexpectedEnd));
+    }
+    ++pos_;
+    --depth_;
+    return {};
+}
+
+// Specialise to decode a struct from a dictionary:
+//
+//     template <>
+//     struct Schema<Peer> {
+//         static constexpr auto fields = std::tuple{required_field("ip", &Peer::ip), field("port", &Peer::port)};
+//     };
+//
+// Unknown keys are skipped; absent optional fields keep their default value.
+template <typename T>
+struct Schema;
+
+template <typename T>
+concept HasSchema = requires { Schema<T>::fields; };
+
+// Describes how one dictionary key maps to a member. `Decode` is either std::nullptr_t, meaning the member type's
+// Decoder, or a callable `std::expected<void, DecodeError>(Reader&, Member&)`.
+template <typename Class, typename Member, typename Decode = std::nullptr_t>
+struct Field {
+    std::string_view key;
+    Member Class::* member;
+    bool required;
+    Decode decode;
+};
+
+template <typename Class, typename Member>
+constexpr Field<Class, Member> field(std::string_view key, Member Class::* member) {
+    return {key, member, false, nullptr};
+}
+
+template <typename Class, typename Member, typename Decode>
+constexpr Field<Class, Member, Decode> field(std::string_view key, Member Class::* member, Decode decode) {
+    return {key, member, false, decode};
+}
+
+template <typename Class, typename Member>
+constexpr Field<Class, Member> required_field(std::string_view key, Member Class::* member) {
+    return {key, member, true, nullptr};
+}
+
+template <typename Class, typename Member, typename Decode>
+constexpr Field<Class, Member, Decode> required_field(std::string_view key, Member Class::* member, Decode decode) {
+    return {key, member, true, decode};
+}
+
+// Specialise to decode a type from a single value: `static std::expected<void, DecodeError> decode(Reader&, T&)`.
+template <typename T>
+struct Decoder;
+
+template <typename T>
+concept Decodable = requires(Reader& reader, T& value) {
+    { Decoder<T>::decode(reader, value) } -> std::same_as<std::expected<void, DecodeError>>;
+};
+
+template <std::integral T>
+    requires(!std::same_as<T, bool>)
+struct Decoder<T> {
+    static std::expected<void, DecodeError> decode(Reader& reader, T& value) {
+        const std::size_t offset = reader.position();
+        auto integer = reader.read_integer();
+        if (!integer) {
+            return std::unexpected(integer.error());
+        }
+        if (!std::in_range<T>(*integer)) {
+            return std::unexpected(DecodeError{DecodeError::Kind::InvalidValue, offset});
+        }
+        value = static_cast<T>(*integer);
+        return {};
+    }
+};
+
+template <typename Rep, typename Period>
+struct Decoder<std::chrono::duration<Rep, Period>> {
+    static std::expected<void, DecodeError> decode(Reader& reader, std::chrono::duration<Rep, Period>& value) {
+        Rep count{};
+        auto result = Decoder<Rep>::decode(reader, count);
+        if (result) {
+            value = std::chrono::duration<Rep, Period>(count);
+        }
+        return result;
+    }
+};
+
+template <>
+struct Decoder<std::string_view> {
+    static std::expected<void, DecodeError> decode(Reader& reader, std::string_view& value) {
+        auto string = reader.read_string();
+        if (!string) {
+            return std::unexpected(string.error());
+        }
+        value = *string;
+        return {};
+    }
+};
+
+template <>
+struct Decoder<std::string> {
+    static std::expected<void, DecodeError> decode(Reader& reader, std::string& value) {
+        auto string = reader.read_string();
+        if (!string) {
+            return std::unexpected(string.error());
+        }
+        value.assign(*string);
+        return {};
+    }
+};
+
+template <Decodable T>
+struct Decoder<std::optional<T>> {
+    static std::expected<void, DecodeError> decode(Reader& reader, std::optional<T>& value) {
+        return Decoder<T>::decode(reader, value.emplace());
+    }
+};
+
+template <Decodable T, typename Allocator>
+struct Decoder<std::vector<T, Allocator>> {
+    static std::expected<void, DecodeError> decode(Reader& reader, std::vector<T, Allocator>& value) {
+        value.clear();
+        return reader.read_list([&] { return Decoder<T>::decode(reader, value.emplace_back()); });
+    }
+};
+
+// Decode function for informational fields: a value of the wrong type is skipped and the member keeps what it had,
+// rather than failing the whole dictionary. Pass as `field("comment", &T::comment, &decode_lenient<...>)`.
+template <Decodable T>
+std::expected<void, DecodeError> decode_lenient(Reader& reader, T& value) {
+    T decoded{};
+    auto result = Decoder<T>::decode(reader, decoded);
+    if (result) {
+        value = std::move(decoded);
+        return result;
+    }
+    if (result.error().kind == DecodeError::Kind::TypeMismatch && result.error().offset == reader.position()) {
+        return reader.skip();
+    }
+    return result;
+}
+
+// A decoded value together with the exact bytes it was decoded from, e.g. the `info` dictionary whose SHA-1 is the
+// info hash. The bytes point into the input.
+template <typename T>
+struct Encoded {
+    T value{};
+    std::string_view bytes;
+};
+
+template <Decodable T>
+struct Decoder<Encoded<T>> {
+    static std::expected<void, DecodeError> decode(Reader& reader, Encoded<T>& encoded) {
+        const std::size_t start = reader.position();
+        auto result = Decoder<T>::decode(reader, encoded.value);
+        if (result) {
+            encoded.bytes = reader.data().substr(start, reader.position() - start);
+        }
+        return result;
+    }
+};
+
+namespace detail {
+
+template <typename T>
+constexpr std::size_t field_count = std::tuple_size_v<std::remove_cvref_t<decltype(Schema<T>::fields)>>;
+
+struct SchemaKey {
+    std::string_view key;
+    std::size_t index;
+};
+
+// Schema keys in bencode (byte-wise) order, computed at compile time.
+template <typename T>
+constexpr auto sorted_schema_keys() {
+    std::array<SchemaKey, field_count<T>> keys{};
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+        ((keys[I] = {std::get<I>(Schema<T>::fields).key, I}), ...);
+    }(std::make_index_sequence<field_count<T>>{});
+    std::ranges::sort(keys, {}, &SchemaKey::key);
+    return keys;
+}
+
+template <typename T>
+constexpr bool has_unique_keys() {
+    constexpr auto keys = sorted_schema_keys<T>();
+    return std::ranges::adjacent_find(keys, {}, &SchemaKey::key) == keys.end();
+}
+
+template <typename T, typename F>
+std::expected<void, DecodeError> decode_field(const F& field, Reader& reader, T& object) {
+    auto& target = object.*field.member;
+    std::expected<void, DecodeError> result;
+    if constexpr (std::is_null_pointer_v<decltype(field.decode)>) {
+        result = Decoder<std::remove_cvref_t<decltype(target)>>::decode(reader, target);
+    } else {
+        result = field.decode(reader, target);
+    }
+    if (!result && result.error().field.empty()) {
+        result.error().field = field.key;
+    }
+    return result;
+}
+
+// Compiles to a jump table over the schema's fields.
+template <typename T, std::size_t... I>
+std::expected<void, DecodeError>
+dispatch_field(std::size_t index, Reader& reader, T& object, std::index_sequence<I...>) {
+    std::expected<void, DecodeError> result;
+    static_cast<void>(((index == I && (result = decode_field(std::get<I>(Schema<T>::fields), reader, object), true)) ||
+                       ...));
+    return result;
+}
+
+}  // namespace detail
+
+// Decodes a dictionary into `object` by merging its (sorted) keys against the schema's keys sorted at compile
+// time, so each key costs a short forward scan and an indexed jump rather than a lookup.
+template <HasSchema T>
+struct Decoder<T> {
+    static std::expected<void, DecodeError> decode(Reader& reader, T& object) {
+        constexpr std::size_t count = detail::field_count<T>;
+        static_assert(count <= 64, "Schema supports at most 64 fields");
+        static_assert(detail::has_unique_keys<T>(), "Schema keys must be unique");
+        static constexpr auto keys = detail::sorted_schema_keys<T>();
+
+        std::uint64_t seen = 0;
+        std::size_t next = 0;
+        auto result = reader.read_dictionary([&](std::string_view key) -> std::expected<void, DecodeError> {
+            while (next < count && keys[next].key < key) {
+                ++next;
+            }
+            if (next == count || keys[next].key != key) {
+                return reader.skip();
+            }
+            const std::size_t index = keys[next++].index;
+            seen |= std::uint64_t{1} << index;
+            return detail::dispatch_field(index, reader, object, std::make_index_sequence<count>{});
+        });
+        if (!result) {
+            return result;
+        }
+
+        std::optional<std::string_view> missing;
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            static_cast<void>(
+                ((std::get<I>(Schema<T>::fields).required && !(seen & (std::uint64_t{1} << I)) &&
+                  (missing = std::get<I>(Schema<T>::fields).key, true)) ||
+                 ...)
+            );
+        }(std::make_index_sequence<count>{});
+        if (missing) {
+            return std::unexpected(DecodeError{DecodeError::Kind::MissingField, reader.position(), *missing});
+        }
+        return {};
+    }
+};
+
+// Decodes `data` in a single pass, with no intermediate Value tree. On failure, members decoded before the error
+// keep their new values. Trailing bytes after the top-level value are ignored, as in Parser.
+template <Decodable T>
+std::expected<void, DecodeError> decode(std::string_view data, T& out) {
+    Reader reader(data);
+    return Decoder<T>::decode(reader, out);
+}
+
+template <Decodable T>
+    requires std::default_initializable<T>
+std::expected<T, DecodeError> decode(std::string_view data) {
+    T out{};
+    auto result = decode(data, out);
+    if (!result) {
+        return std::unexpected(result.error());
+    }
+    return out;
+}
+
+}  // namespace bittorrent::bencode
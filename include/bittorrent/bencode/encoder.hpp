@@ -1,22 +1,240 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <expected>
+#include <iterator>
+#include <ostream>
+#include <span>
 #include <string>
+#include <string_view>
+#include "errors.hpp"
 #include "value.hpp"
 
 namespace bittorrent::bencode {
 
+template <typename T>
+struct is_basic_value : std::false_type {};
+
+template <typename StringT, typename Allocator>
+struct is_basic_value<BasicValue<StringT, Allocator>> : std::true_type {};
+
+template <typename T>
+concept EncodableValue = is_basic_value<T>::value;
+
+// Every encode path first measures the exact output size, then writes each token once with std::to_chars, so
+// output buffers are allocated exactly once and no temporary strings are created.
 class Encoder {
 public:
     [[nodiscard]] static std::string encode(const Value& value);
 
+    [[nodiscard]] static std::string encode(const ValueView& value);
+
+    [[nodiscard]] static std::string encode(const pmr::Value& value);
+
+    [[nodiscard]] static std::string encode(const pmr::ValueView& value);
+
+    template <EncodableValue V>
+    [[nodiscard]] static std::size_t encoded_size(const V& value);
+
+    // Appends to `output` after a single reserve.
+    template <EncodableValue V>
+    static void encode_to(std::string& output, const V& value);
+
+    // Returns the number of bytes written; nothing is written if `buffer` is too small.
+    template <EncodableValue V>
+    [[nodiscard]] static std::expected<std::size_t, EncodeError> encode_to(std::span<char> buffer, const V& value);
+
+    template <EncodableValue V, std::output_iterator<char> Out>
+    static Out encode_to(Out out, const V& value);
+
+    // Streams through a small fixed buffer; large strings go to `stream` without an intermediate copy.
+    template <EncodableValue V>
+    static void encode_to(std::ostream& stream, const V& value);
+
 private:
     explicit Encoder() = default;
 
-    static void encode_value(std::string& output, const Value& value);
-    static void encode_integer(std::string& output, Integer value);
-    static void encode_string(std::string& output, const String& value);
-    static void encode_list(std::string& output, const List& value);
-    static void encode_dictionary(std::string& output, const Dictionary& value);
+    // Longest decimal Integer, sign included.
+    static constexpr std::size_t kMaxIntegerSize = 20;
+
+    struct PointerSink;
+
+    template <typename Out>
+    struct IteratorSink;
+
+    static std::size_t decimal_size(std::size_t value) noexcept {
+        std::size_t digits = 1;
+        for (; value >= 10; value /= 10) {
+            ++digits;
+        }
+        return digits;
+    }
+
+    static std::size_t string_size(std::string_view value) noexcept {
+        return decimal_size(value.size()) + 1 + value.size();
+    }
+
+    template <typename Sink, typename V>
+    static void write_value(Sink& sink, const V& value);
+
+    template <typename Sink>
+    static void write_number(Sink& sink, char prefix, Integer value, char suffix);
+
+    template <typename Sink>
+    static void write_string(Sink& sink, std::string_view value);
 };
 
+template <EncodableValue V>
+std::size_t Encoder::encoded_size(const V& value) {
+    if (value.is_integer()) {
+        std::array<char, kMaxIntegerSize> digits;
+        auto result = std::to_chars(digits.data(), digits.data() + digits.size(), value.as_integer());
+        return static_cast<std::size_t>(result.ptr - digits.data()) + 2;
+    }
+    if (value.is_string()) {
+        return string_size(value.as_string());
+    }
+
+    std::size_t size = 2;
+    if (value.is_list()) {
+        for (const auto& item : value.as_list()) {
+            size += encoded_size(item);
+        }
+    } else {
+        for (const auto& [key, item] : value.as_dictionary()) {
+            size += string_size(key) + encoded_size(item);
+        }
+    }
+    return size;
+}
+
+template <typename Sink, typename V>
+void Encoder::write_value(Sink& sink, const V& value) {
+    if (value.is_integer()) {
+        write_number(sink, 'i', value.as_integer(), 'e');
+    } else if (value.is_string()) {
+        write_string(sink, value.as_string());
+    } else if (value.is_list()) {
+        sink.put('l');
+        for (const auto& item : value.as_list()) {
+            write_value(sink, item);
+        }
+        sink.put('e');
+    } else if (value.is_dictionary()) {
+        sink.put('d');
+        for (const auto& [key, item] : value.as_dictionary()) {
+            write_string(sink, key);
+            write_value(sink, item);
+        }
+        sink.put('e');
+    }
+}
+
+template <typename Sink>
+void Encoder::write_number(Sink& sink, char prefix, Integer value, char suffix) {
+    std::array<char, kMaxIntegerSize + 2> buffer;
+    char* out = buffer.data();
+    if (prefix != '\0') {
+        *out++ = prefix;
+    }
+    out = std::to_chars(out, buffer.data() + buffer.size() - 1, value).ptr;
+    *out++ = suffix;
+    sink.write(std::string_view(buffer.data(), static_cast<std::size_t>(out - buffer.data())));
+}
+
+template <typename Sink>
+void Encoder::write_string(Sink& sink, std::string_view value) {
+    write_number(sink, '\0', static_cast<Integer>(value.size()), ':');
+    sink.write(value);
+}
+
+struct Encoder::PointerSink {
+    char* out;
+
+    void put(char c) noexcept { *out++ = c; }
+
+    void write(std::string_view bytes) noexcept {
+        std::memcpy(out, bytes.data(), bytes.size());
+        out += bytes.size();
+    }
+};
+
+template <typename Out>
+struct Encoder::IteratorSink {
+    Out out;
+
+    void put(char c) { *out++ = c; }
+
+    void write(std::string_view bytes) { out = std::ranges::copy(bytes, std::move(out)).out; }
+};
+
+template <EncodableValue V>
+void Encoder::encode_to(std::string& output, const V& value) {
+    const std::size_t offset = output.size();
+    const std::size_t size = offset + encoded_size(value);
+    output.resize_and_overwrite(size, [&](char* data, std::size_t) {
+        PointerSink sink{data + offset};
+        write_value(sink, value);
+        return size;
+    });
+}
+
+template <EncodableValue V>
+std::expected<std::size_t, EncodeError> Encoder::encode_to(std::span<char> buffer, const V& value) {
+    const std::size_t size = encoded_size(value);
+    if (size > buffer.size()) {
+        return std::unexpected(EncodeError::BufferTooSmall);
+    }
+    PointerSink sink{buffer.data()};
+    write_value(sink, value);
+    return size;
+}
+
+template <EncodableValue V, std::output_iterator<char> Out>
+Out Encoder::encode_to(Out out, const V& value) {
+    IteratorSink<Out> sink{std::move(out)};
+    write_value(sink, value);
+    return std::move(sink.out);
+}
+
+template <EncodableValue V>
+void Encoder::encode_to(std::ostream& stream, const V& value) {
+    struct Buffered {
+        std::ostream& stream;
+        std::array<char, 4096> buffer{};
+        std::size_t used{0};
+
+        void flush() {
+            stream.write(buffer.data(), static_cast<std::streamsize>(used));
+            used = 0;
+        }
+
+        void put(char c) {
+            if (used == buffer.size()) {
+                flush();
+            }
+            buffer[used++] = c;
+        }
+
+        void write(std::string_view bytes) {
+            if (bytes.size() > buffer.size() - used) {
+                flush();
+                if (bytes.size() >= buffer.size()) {
+                    stream.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+                    return;
+                }
+            }
+            std::memcpy(buffer.data() + used, bytes.data(), bytes.size());
+            used += bytes.size();
+        }
+    } sink{stream};
+
+    write_value(sink, value);
+    sink.flush();
+}
+
 }  // namespace bittorrent::bencode
@@ -11,6 +11,7 @@ enum class ParseError {
     InvalidLength,
     InvalidFormat,
     UnexpectedCharacter,
+    NestingTooDeep,
 };
 
 constexpr std::string_view to_string(ParseError error) noexcept {
@@ -27,6 +28,20 @@ constexpr std::string_view to_string(ParseError error) noexcept {
             return "Invalid bencode format";
         case ParseError::UnexpectedCharacter:
             return "Unexpected character";
+        case ParseError::NestingTooDeep:
+            return "Nesting too deep";
+    }
+    return "Unknown error";
+}
+
+enum class EncodeError {
+    BufferTooSmall,
+};
+
+constexpr std::string_view to_string(EncodeError error) noexcept {
+    switch (error) {
+        case EncodeError::BufferTooSmall:
+            return "Output buffer too small";
     }
     return "Unknown error";
 }
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace bittorrent::bencode {
+
+// Sorted-vector dictionary with the subset of the std::map interface the code base uses. Bencode dictionaries
+// arrive with strictly increasing keys, so the parser fills it by appending; out-of-order inserts still work but
+// shift the tail. Keys must not be modified through iterators.
+template <typename Key, typename T, typename Allocator = std::allocator<std::pair<Key, T>>>
+class FlatDictionary {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key, T>;
+    using allocator_type = Allocator;
+    using container_type = std::vector<value_type, Allocator>;
+    using size_type = typename container_type::size_type;
+    using iterator = typename container_type::iterator;
+    using const_iterator = typename container_type::const_iterator;
+
+    FlatDictionary() = default;
+
+    explicit FlatDictionary(const allocator_type& alloc) : entries_(alloc) {}
+
+    allocator_type get_allocator() const noexcept { return entries_.get_allocator(); }
+
+    iterator begin() noexcept { return entries_.begin(); }
+    const_iterator begin() const noexcept { return entries_.begin(); }
+    iterator end() noexcept { return entries_.end(); }
+    const_iterator end() const noexcept { return entries_.end(); }
+
+    size_type size() const noexcept { return entries_.size(); }
+
+    bool empty() const noexcept { return entries_.empty(); }
+
+    void reserve(size_type count) { entries_.reserve(count); }
+
+    void clear() noexcept { entries_.clear(); }
+
+    iterator find(std::string_view key) {
+        auto it = lower_bound(key);
+        return it != end() && std::string_view(it->first) == key ? it : end();
+    }
+
+    const_iterator find(std::string_view key) const {
+        auto it = lower_bound(key);
+        return it != end() && std::string_view(it->first) == key ? it : end();
+    }
+
+    bool contains(std::string_view key) const { return find(key) != end(); }
+
+    T& at(std::string_view key) {
+        auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("FlatDictionary::at: key not found");
+        }
+        return it->second;
+    }
+
+    const T& at(std::string_view key) const {
+        auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("FlatDictionary::at: key not found");
+        }
+        return it->second;
+    }
+
+    template <typename K>
+    T& operator[](K&& key) {
+        return try_emplace(std::forward<K>(key)).first->second;
+    }
+
+    // Appending in key order, as the parser does, costs one comparison against the last key.
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+        const std::string_view key_view(key);
+        auto pos = end();
+        if (!entries_.empty() && key_view <= std::string_view(entries_.back().first)) {
+            pos = lower_bound(key_view);
+            if (pos != end() && std::string_view(pos->first) == key_view) {
+                return {pos, false};
+            }
+        }
+        pos = entries_.emplace(
+            pos,
+            std::piecewise_construct,
+            std::forward_as_tuple(std::forward<K>(key)),
+            std::forward_as_tuple(std::forward<Args>(args)...)
+        );
+        return {pos, true};
+    }
+
+    template <typename K, typename V>
+    std::pair<iterator, bool> emplace(K&& key, V&& value) {
+        return try_emplace(std::forward<K>(key), std::forward<V>(value));
+    }
+
+    size_type erase(std::string_view key) {
+        auto it = find(key);
+        if (it == end()) {
+            return 0;
+        }
+        entries_.erase(it);
+        return 1;
+    }
+
+private:
+    // Most bencode dictionaries have a handful of keys, where a linear scan beats binary search.
+    static constexpr size_type kLinearSearchLimit = 8;
+
+    iterator lower_bound(std::string_view key) {
+        return begin() + (std::as_const(*this).lower_bound(key) - begin());
+    }
+
+    const_iterator lower_bound(std::string_view key) const {
+        if (entries_.size() <= kLinearSearchLimit) {
+            auto it = entries_.begin();
+            while (it != entries_.end() && std::string_view(it->first) < key) {
+                ++it;
+            }
+            return it;
+        }
+        return std::ranges::lower_bound(entries_, key, {}, [](const value_type& entry) {
+            return std::string_view(entry.first);
+        });
+    }
+
+    container_type entries_;
+};
+
+}  // namespace bittorrent::bencode
@@ -4,6 +4,7 @@
 #include "value.hpp"
 
 #include <expected>
+#include <memory_resource>
 #include <string>
 #include <string_view>
 
@@ -13,15 +14,34 @@ class Parser {
 public:
     [[nodiscard]] static std::expected<Value, ParseError> parse(std::string_view data);
 
+    // Zero-copy variant: strings and dictionary keys in the result point into `data`, so `data` must outlive it.
+    [[nodiscard]] static std::expected<ValueView, ParseError> parse_view(std::string_view data);
+
+    // Arena variants: every string, list and dictionary node is allocated from `resource`, so a
+    // std::pmr::monotonic_buffer_resource turns a whole parse into a few block allocations and one release.
+    [[nodiscard]] static std::expected<pmr::Value, ParseError>
+    parse(std::string_view data, std::pmr::memory_resource* resource);
+
+    [[nodiscard]] static std::expected<pmr::ValueView, ParseError>
+    parse_view(std::string_view data, std::pmr::memory_resource* resource);
+
 private:
     explicit Parser(std::string_view data) : data_(data), pos_(0) {}
 
-    std::expected<Value, ParseError> parse_value();
+    template <typename V>
+    using allocator_for = typename V::list_type::allocator_type;
+
+    template <typename V>
+    std::expected<V, ParseError> parse_value(const allocator_for<V>& alloc);
 
     std::expected<Integer, ParseError> parse_integer();
-    std::expected<String, ParseError> parse_string();
-    std::expected<List, ParseError> parse_list();
-    std::expected<Dictionary, ParseError> parse_dictionary();
+    std::expected<std::string_view, ParseError> parse_string();
+
+    template <typename V>
+    std::expected<typename V::list_type, ParseError> parse_list(const allocator_for<V>& alloc);
+
+    template <typename V>
+    std::expected<typename V::dictionary_type, ParseError> parse_dictionary(const allocator_for<V>& alloc);
 
     bool has_more() const noexcept { return pos_ < data_.size(); }
 
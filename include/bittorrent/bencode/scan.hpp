@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace bittorrent::bencode {
+
+// Structural scanning primitives shared by Parser and Tape. The implementation is chosen once at runtime from the
+// best instruction set the CPU supports; `force_scan_kernel` exists for tests and benchmarks.
+enum class ScanKernel {
+    Scalar,
+    Sse2,
+    Avx2,
+};
+
+constexpr std::string_view to_string(ScanKernel kernel) noexcept {
+    switch (kernel) {
+        case ScanKernel::Scalar:
+            return "scalar";
+        case ScanKernel::Sse2:
+            return "sse2";
+        case ScanKernel::Avx2:
+            return "avx2";
+    }
+    return "unknown";
+}
+
+// Index of the first byte at or after `pos` that is not an ASCII digit, or `data.size()`.
+std::size_t scan_digits(std::string_view data, std::size_t pos) noexcept;
+
+// Index of the first `c` at or after `pos`, or `data.size()`.
+std::size_t scan_for(std::string_view data, std::size_t pos, char c) noexcept;
+
+ScanKernel active_scan_kernel() noexcept;
+
+bool is_scan_kernel_supported(ScanKernel kernel) noexcept;
+
+// Returns false and leaves the active kernel unchanged if the CPU lacks `kernel`.
+bool force_scan_kernel(ScanKernel kernel) noexcept;
+
+}  // namespace bittorrent::bencode
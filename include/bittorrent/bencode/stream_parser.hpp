@@ -0,0 +1,262 @@
+#pragma once
+
+#include "errors.hpp"
+#include "value.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <expected>
+#include <string_view>
+
+namespace bittorrent::bencode {
+
+// Receives the events of a StreamParser. String payloads (keys included) arrive as one or more `on_string_data`
+// slices of the caller's chunk, bracketed by `on_string_begin` and `on_string_end`.
+template <typename H>
+concept StreamHandler = requires(H& handler, Integer integer, std::size_t length, std::string_view bytes) {
+    handler.on_integer(integer);
+    handler.on_string_begin(length, bool{});
+    handler.on_string_data(bytes);
+    handler.on_string_end();
+    handler.on_list_begin();
+    handler.on_list_end();
+    handler.on_dictionary_begin();
+    handler.on_dictionary_end();
+};
+
+// Resumable push parser: feed() accepts the document in arbitrary chunks and keeps only a fixed-size state between
+// calls, so memory use does not depend on the document or chunk size. Unlike Parser it does not check that
+// dictionary keys are sorted, which would require remembering the previous key.
+template <StreamHandler Handler>
+class StreamParser {
+public:
+    static constexpr std::size_t kMaxDepth = 64;
+
+    explicit StreamParser(Handler& handler) : handler_(handler) {}
+
+    // Consumes all of `chunk`. Bytes after the end of the top-level value are ignored. Once an error is returned the
+    // parser stays failed.
+    std::expected<void, ParseError> feed(std::string_view chunk);
+
+    // Reports UnexpectedEnd if the top-level value is still incomplete.
+    std::expected<void, ParseError> finish() const;
+
+    bool done() const noexcept { return state_ == State::Done; }
+
+private:
+    enum class State {
+        Value,
+        Integer,
+        Length,
+        StringData,
+        Done,
+        Failed,
+    };
+
+    struct Frame {
+        bool is_dictionary;
+        bool expect_key;
+    };
+
+    // Long enough for any Integer and, zero padding aside, any length prefix.
+    static constexpr std::size_t kMaxNumberSize = 20;
+
+    std::expected<void, ParseError> fail(ParseError error) {
+        state_ = State::Failed;
+        error_ = error;
+        return std::unexpected(error);
+    }
+
+    bool expecting_key() const noexcept {
+        return depth_ > 0 && stack_[depth_ - 1].is_dictionary && stack_[depth_ - 1].expect_key;
+    }
+
+    void value_completed() noexcept;
+    std::expected<void, ParseError> begin_value(char c);
+    std::expected<void, ParseError> end_integer();
+    std::expected<void, ParseError> end_length();
+
+    Handler& handler_;
+    State state_{State::Value};
+    ParseError error_{ParseError::InvalidFormat};
+
+    std::array<Frame, kMaxDepth> stack_{};
+    std::size_t depth_{0};
+
+    std::array<char, kMaxNumberSize + 1> number_{};
+    std::size_t number_size_{0};
+
+    std::size_t string_remaining_{0};
+};
+
+template <StreamHandler Handler>
+std::expected<void, ParseError> StreamParser<Handler>::feed(std::string_view chunk) {
+    std::size_t pos = 0;
+    while (pos < chunk.size()) {
+        switch (state_) {
+            case State::Done:
+                return {};
+
+            case State::Failed:
+                return std::unexpected(error_);
+
+            case State::Value: {
+                auto result = begin_value(chunk[pos++]);
+                if (!result) {
+                    return result;
+                }
+                break;
+            }
+
+            case State::Integer:
+            case State::Length: {
+                const char terminator = state_ == State::Integer ? 'e' : ':';
+                const char c = chunk[pos++];
+                if (c == terminator) {
+                    auto result = state_ == State::Integer ? end_integer() : end_length();
+                    if (!result) {
+                        return result;
+                    }
+                    break;
+                }
+                if (number_size_ == number_.size()) {
+                    return fail(state_ == State::Integer ? ParseError::InvalidInteger : ParseError::InvalidLength);
+                }
+                if (state_ == State::Length && static_cast<unsigned char>(c - '0') > 9) {
+                    return fail(ParseError::InvalidString);
+                }
+                number_[number_size_++] = c;
+                break;
+            }
+
+            case State::StringData: {
+                const std::size_t take = std::min(string_remaining_, chunk.size() - pos);
+                handler_.on_string_data(chunk.substr(pos, take));
+                pos += take;
+                string_remaining_ -= take;
+                if (string_remaining_ == 0) {
+                    handler_.on_string_end();
+                    value_completed();
+                }
+                break;
+            }
+        }
+    }
+    return state_ == State::Failed ? std::unexpected(error_) : std::expected<void, ParseError>{};
+}
+
+template <StreamHandler Handler>
+std::expected<void, ParseError> StreamParser<Handler>::finish() const {
+    if (state_ == State::Failed) {
+        return std::unexpected(error_);
+    }
+    if (state_ != State::Done) {
+        return std::unexpected(ParseError::UnexpectedEnd);
+    }
+    return {};
+}
+
+template <StreamHandler Handler>
+void StreamParser<Handler>::value_completed() noexcept {
+    if (depth_ == 0) {
+        state_ = State::Done;
+        return;
+    }
+    auto& parent = stack_[depth_ - 1];
+    if (parent.is_dictionary) {
+        parent.expect_key = !parent.expect_key;
+    }
+    state_ = State::Value;
+}
+
+template <StreamHandler Handler>
+std::expected<void, ParseError> StreamParser<Handler>::begin_value(char c) {
+    const bool is_key = expecting_key();
+
+    if (c == 'e') {
+        if (depth_ == 0 || (stack_[depth_ - 1].is_dictionary && !stack_[depth_ - 1].expect_key)) {
+            return fail(ParseError::UnexpectedCharacter);
+        }
+        if (stack_[--depth_].is_dictionary) {
+            handler_.on_dictionary_end();
+        } else {
+            handler_.on_list_end();
+        }
+        value_completed();
+        return {};
+    }
+
+    if (static_cast<unsigned char>(c - '0') <= 9) {
+        number_[0] = c;
+        number_size_ = 1;
+        state_ = State::Length;
+        return {};
+    }
+
+    if (is_key) {
+        return fail(ParseError::InvalidFormat);
+    }
+
+    if (c == 'i') {
+        number_size_ = 0;
+        state_ = State::Integer;
+        return {};
+    }
+
+    if (c == 'l' || c == 'd') {
+        if (depth_ == kMaxDepth) {
+            return fail(ParseError::NestingTooDeep);
+        }
+        stack_[depth_++] = {c == 'd', true};
+        if (c == 'd') {
+            handler_.on_dictionary_begin();
+        } else {
+            handler_.on_list_begin();
+        }
+        return {};
+    }
+
+    return fail(ParseError::UnexpectedCharacter);
+}
+
+template <StreamHandler Handler>
+std::expected<void, ParseError> StreamParser<Handler>::end_integer() {
+    std::string_view digits(number_.data(), number_size_);
+    if ((digits.size() > 1 && digits[0] == '0') || digits == "-0") {
+        return fail(ParseError::InvalidInteger);
+    }
+
+    Integer value;
+    auto [ptr, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+    if (ec != std::errc{} || ptr != digits.data() + digits.size()) {
+        return fail(ParseError::InvalidInteger);
+    }
+
+    handler_.on_integer(value);
+    value_completed();
+    return {};
+}
+
+template <StreamHandler Handler>
+std::expected<void, ParseError> StreamParser<Handler>::end_length() {
+    std::size_t length;
+    auto [ptr, ec] = std::from_chars(number_.data(), number_.data() + number_size_, length);
+    if (ec != std::errc{}) {
+        return fail(ParseError::InvalidLength);
+    }
+
+    handler_.on_string_begin(length, expecting_key());
+    if (length == 0) {
+        handler_.on_string_end();
+        value_completed();
+        return {};
+    }
+
+    string_remaining_ = length;
+    state_ = State::StringData;
+    return {};
+}
+
+}  // namespace bittorrent::bencode
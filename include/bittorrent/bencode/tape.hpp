@@ -0,0 +1,182 @@
+#pragma once
+
+#include "errors.hpp"
+#include "value.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace bittorrent::bencode {
+
+enum class TokenType : std::uint8_t {
+    Integer,
+    String,
+    List,
+    Dictionary,
+};
+
+constexpr std::string_view to_string(TokenType type) noexcept {
+    switch (type) {
+        case TokenType::Integer:
+            return "integer";
+        case TokenType::String:
+            return "string";
+        case TokenType::List:
+            return "list";
+        case TokenType::Dictionary:
+            return "dictionary";
+    }
+    return "unknown";
+}
+
+// One entry per bencode value, in document order. A container is followed by its children; `next` is the index of
+// the first token after the value, so a whole subtree is skipped in O(1).
+struct Token {
+    TokenType type;
+    std::uint8_t header;  // encoded bytes preceding `offset` ("i", "<length>:"), zero for containers
+    std::uint32_t next;
+    std::uint32_t offset;  // string: payload start; others: first encoded byte
+    std::uint32_t length;  // string: payload size; integer: digit count; containers: encoded size
+};
+
+class Tape;
+
+// Lightweight handle to a single token on a Tape. Accessors mirror Value and throw std::bad_variant_access on a
+// type mismatch.
+class TapeCursor {
+public:
+    template <typename T>
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+        Iterator(const Tape* tape, std::uint32_t index) : tape_(tape), index_(index) {}
+
+        T operator*() const;
+        Iterator& operator++();
+
+        Iterator operator++(int) {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        bool operator==(const Iterator& other) const noexcept { return index_ == other.index_; }
+
+    private:
+        const Tape* tape_{nullptr};
+        std::uint32_t index_{0};
+    };
+
+    template <typename T>
+    struct Range {
+        Iterator<T> first;
+        Iterator<T> last;
+
+        Iterator<T> begin() const noexcept { return first; }
+        Iterator<T> end() const noexcept { return last; }
+    };
+
+    using ListRange = Range<TapeCursor>;
+    using DictionaryRange = Range<std::pair<std::string_view, TapeCursor>>;
+
+    TapeCursor(const Tape* tape, std::uint32_t index) : tape_(tape), index_(index) {}
+
+    TokenType type() const noexcept;
+
+    bool is_integer() const noexcept { return type() == TokenType::Integer; }
+
+    bool is_string() const noexcept { return type() == TokenType::String; }
+
+    bool is_list() const noexcept { return type() == TokenType::List; }
+
+    bool is_dictionary() const noexcept { return type() == TokenType::Dictionary; }
+
+    Integer as_integer() const;
+
+    std::string_view as_string() const;
+
+    ListRange as_list() const;
+
+    DictionaryRange as_dictionary() const;
+
+    // Number of list items or dictionary entries; walks the direct children only.
+    std::size_t size() const;
+
+    // Dictionary lookup; skips every non-matching value without visiting its children.
+    std::optional<TapeCursor> find(std::string_view key) const;
+
+    // The exact input bytes this value was parsed from.
+    std::string_view encoded() const noexcept;
+
+    std::uint32_t index() const noexcept { return index_; }
+
+private:
+    const Token& token() const noexcept;
+
+    const Tape* tape_;
+    std::uint32_t index_;
+};
+
+class Tape {
+public:
+    // Parses `data` in a single iterative pass. The tape borrows `data`, which must outlive it and every cursor.
+    [[nodiscard]] static std::expected<Tape, ParseError> parse(std::string_view data);
+
+    TapeCursor root() const noexcept { return TapeCursor(this, 0); }
+
+    std::span<const Token> tokens() const noexcept { return tokens_; }
+
+    std::string_view data() const noexcept { return data_; }
+
+private:
+    explicit Tape(std::string_view data) : data_(data) {}
+
+    std::string_view data_;
+    std::vector<Token> tokens_;
+};
+
+inline const Token& TapeCursor::token() const noexcept {
+    return tape_->tokens()[index_];
+}
+
+inline TokenType TapeCursor::type() const noexcept {
+    return token().type;
+}
+
+template <>
+inline TapeCursor TapeCursor::Iterator<TapeCursor>::operator*() const {
+    return TapeCursor(tape_, index_);
+}
+
+template <>
+inline std::pair<std::string_view, TapeCursor>
+TapeCursor::Iterator<std::pair<std::string_view, TapeCursor>>::operator*() const {
+    return {TapeCursor(tape_, index_).as_string(), TapeCursor(tape_, index_ + 1)};
+}
+
+template <>
+inline TapeCursor::Iterator<TapeCursor>& TapeCursor::Iterator<TapeCursor>::operator++() {
+    index_ = tape_->tokens()[index_].next;
+    return *this;
+}
+
+template <>
+inline TapeCursor::Iterator<std::pair<std::string_view, TapeCursor>>&
+TapeCursor::Iterator<std::pair<std::string_view, TapeCursor>>::operator++() {
+    // A key is a string with no children, so its value is the very next token.
+    index_ = tape_->tokens()[index_ + 1].next;
+    return *this;
+}
+
+}  // namespace bittorrent::bencode
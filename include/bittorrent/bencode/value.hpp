@@ -1,51 +1,63 @@
 #pragma once
 
+#include <concepts>
 #include <cstdint>
 #include <expected>
-#include <map>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <variant>
 #include <vector>
+#include "flat_dictionary.hpp"
 
 namespace bittorrent::bencode {
 
-struct Value;
-
 using Integer = std::int64_t;
-using String = std::string;
-using List = std::vector<Value>;
-using Dictionary = std::map<std::string, Value>;
 
-class Value {
+// A bencode value parameterised on its byte-string representation and allocator. `Value` owns its strings,
+// `ValueView` borrows them from the buffer it was parsed from; both share the same accessors. The `pmr` aliases
+// allocate every node from a caller-supplied std::pmr::memory_resource.
+template <typename StringT, typename Allocator = std::allocator<std::byte>>
+class BasicValue {
+    template <typename T>
+    using rebind_alloc = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+
 public:
-    Value() : data_(Integer{0}) {}
+    using string_type = StringT;
+    using list_type = std::vector<BasicValue, rebind_alloc<BasicValue>>;
+    using dictionary_type = FlatDictionary<StringT, BasicValue, rebind_alloc<std::pair<StringT, BasicValue>>>;
+
+    BasicValue() : data_(Integer{0}) {}
 
     template <typename T>
-    Value(T&& value) : data_(std::forward<T>(value)) {}
+        requires(!std::same_as<std::remove_cvref_t<T>, BasicValue>)
+    BasicValue(T&& value) : data_(std::forward<T>(value)) {}
 
     bool is_integer() const noexcept { return std::holds_alternative<Integer>(data_); }
 
-    bool is_string() const noexcept { return std::holds_alternative<String>(data_); }
+    bool is_string() const noexcept { return std::holds_alternative<string_type>(data_); }
 
-    bool is_list() const noexcept { return std::holds_alternative<List>(data_); }
+    bool is_list() const noexcept { return std::holds_alternative<list_type>(data_); }
 
-    bool is_dictionary() const noexcept { return std::holds_alternative<Dictionary>(data_); }
+    bool is_dictionary() const noexcept { return std::holds_alternative<dictionary_type>(data_); }
 
     Integer& as_integer() { return std::get<Integer>(data_); }
 
     const Integer& as_integer() const { return std::get<Integer>(data_); }
 
-    String& as_string() { return std::get<String>(data_); }
+    string_type& as_string() { return std::get<string_type>(data_); }
 
-    const String& as_string() const { return std::get<String>(data_); }
+    const string_type& as_string() const { return std::get<string_type>(data_); }
 
-    List& as_list() { return std::get<List>(data_); }
+    list_type& as_list() { return std::get<list_type>(data_); }
 
-    const List& as_list() const { return std::get<List>(data_); }
+    const list_type& as_list() const { return std::get<list_type>(data_); }
 
-    Dictionary& as_dictionary() { return std::get<Dictionary>(data_); }
+    dictionary_type& as_dictionary() { return std::get<dictionary_type>(data_); }
 
-    const Dictionary& as_dictionary() const { return std::get<Dictionary>(data_); }
+    const dictionary_type& as_dictionary() const { return std::get<dictionary_type>(data_); }
 
     template <typename T>
     std::expected<T*, std::string> get_if() noexcept {
@@ -64,7 +76,31 @@ public:
     }
 
 private:
-    std::variant<Integer, String, List, Dictionary> data_;
+    std::variant<Integer, string_type, list_type, dictionary_type> data_;
 };
 
+using Value = BasicValue<std::string>;
+using String = Value::string_type;
+using List = Value::list_type;
+using Dictionary = Value::dictionary_type;
+
+// Strings are views into the parsed buffer, which must outlive the ValueView.
+using ValueView = BasicValue<std::string_view>;
+using StringView = ValueView::string_type;
+using ListView = ValueView::list_type;
+using DictionaryView = ValueView::dictionary_type;
+
+namespace pmr {
+
+using Value = BasicValue<std::pmr::string, std::pmr::polymorphic_allocator<std::byte>>;
+using String = Value::string_type;
+using List = Value::list_type;
+using Dictionary = Value::dictionary_type;
+
+using ValueView = BasicValue<std::string_view, std::pmr::polymorphic_allocator<std::byte>>;
+using ListView = ValueView::list_type;
+using DictionaryView = ValueView::dictionary_type;
+
+}  // namespace pmr
+
 }  // namespace bittorrent::bencode
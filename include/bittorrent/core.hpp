@@ -1,5 +1,12 @@
 #pragma once
 
+#include "core/bitfield.hpp"
 #include "core/file_info.hpp"
+#include "core/file_storage.hpp"
+#include "core/merkle.hpp"
+#include "core/metadata_cache.hpp"
+#include "core/piece_map.hpp"
+#include "core/recheck.hpp"
+#include "core/torrent_builder.hpp"
 #include "core/torrent_info.hpp"
 #include "core/types.hpp"
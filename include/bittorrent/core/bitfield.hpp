@@ -0,0 +1,52 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace bittorrent::core {
+
+// One bit per piece, packed as in the peer wire protocol: piece 0 is the high bit of the first byte and the spare
+// bits of the last byte stay clear.
+// https://www.bittorrent.org/beps/bep_0003.html#peer-messages
+class Bitfield {
+public:
+    Bitfield() = default;
+
+    explicit Bitfield(std::size_t size) : size_(size), bytes_((size + 7) / 8) {}
+
+    std::size_t size() const noexcept { return size_; }
+
+    bool test(std::size_t index) const noexcept {
+        return (std::to_integer<unsigned>(bytes_[index / 8]) >> (7 - index % 8) & 1) != 0;
+    }
+
+    void set(std::size_t index, bool value = true) noexcept {
+        const auto mask = std::byte{0x80} >> (index % 8);
+        bytes_[index / 8] = value ? bytes_[index / 8] | mask : bytes_[index / 8] & ~mask;
+    }
+
+    std::size_t count() const noexcept {
+        std::size_t total = 0;
+        for (auto byte : bytes_) {
+            total += static_cast<std::size_t>(std::popcount(std::to_integer<std::uint8_t>(byte)));
+        }
+        return total;
+    }
+
+    bool all() const noexcept { return count() == size_; }
+
+    bool none() const noexcept { return count() == 0; }
+
+    std::span<const std::byte> bytes() const noexcept { return bytes_; }
+
+    bool operator==(const Bitfield&) const = default;
+
+private:
+    std::size_t size_{0};
+    std::vector<std::byte> bytes_;
+};
+
+}  // namespace bittorrent::core
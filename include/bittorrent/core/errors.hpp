@@ -10,6 +10,8 @@ enum class TorrentError {
     InvalidFieldType,
     InvalidPieceLength,
     InvalidPieceHash,
+    InvalidFileTree,
+    InvalidPieceLayer,
 };
 
 constexpr std::string_view to_string(TorrentError error) noexcept {
@@ -24,6 +26,10 @@ constexpr std::string_view to_string(TorrentError error) noexcept {
             return "Invalid piece length";
         case TorrentError::InvalidPieceHash:
             return "Invalid piece hash";
+        case TorrentError::InvalidFileTree:
+            return "Invalid file tree";
+        case TorrentError::InvalidPieceLayer:
+            return "Invalid piece layer";
     }
     return "Unknown error";
 }
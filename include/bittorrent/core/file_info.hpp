@@ -1,7 +1,10 @@
 #pragma once
 
+#include "types.hpp"
+
 #include <cstdint>
 #include <filesystem>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -13,4 +16,13 @@ struct FileInfo {
     std::int64_t offset{0};
 };
 
+// A file of the v2 file tree. Each v2 file starts on a piece boundary and has its own Merkle tree; empty files have
+// neither a root nor a piece layer.
+struct V2FileInfo {
+    std::filesystem::path path;
+    std::int64_t length;
+    std::optional<SHA256Hash> pieces_root;
+    std::vector<SHA256Hash> piece_layer;  // one hash per piece; empty for files of at most one piece
+};
+
 }  // namespace bittorrent::core
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "file_info.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iterator>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace bittorrent::core {
+
+// The files of a torrent, laid out for torrents with hundreds of thousands of them. Every distinct path component
+// is stored once, directories form a trie of (parent, name) nodes, and lengths and offsets live in arrays of their
+// own, so a file costs 24 bytes plus whatever new names it brings. Paths are built only when asked for.
+//
+// Indexing and iteration yield FileInfo values, so code written against a vector of FileInfo keeps working; loops
+// over many files should prefer `length`, `offset` and `file_name`, which do not allocate.
+class FileStorage {
+public:
+    static constexpr std::uint32_t kNoParent = 0xFFFFFFFF;
+
+    class Builder;
+
+    class Iterator {
+    public:
+        using iterator_concept = std::random_access_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = FileInfo;
+        using difference_type = std::ptrdiff_t;
+        using reference = FileInfo;
+
+        Iterator() = default;
+
+        FileInfo operator*() const { return (*storage_)[index_]; }
+
+        FileInfo operator[](difference_type n) const { return (*storage_)[index_ + n]; }
+
+        Iterator& operator++() noexcept {
+            ++index_;
+            return *this;
+        }
+
+        Iterator operator++(int) noexcept {
+            auto copy = *this;
+            ++index_;
+            return copy;
+        }
+
+        Iterator& operator--() noexcept {
+            --index_;
+            return *this;
+        }
+
+        Iterator operator--(int) noexcept {
+            auto copy = *this;
+            --index_;
+            return copy;
+        }
+
+        Iterator& operator+=(difference_type n) noexcept {
+            index_ += n;
+            return *this;
+        }
+
+        Iterator& operator-=(difference_type n) noexcept {
+            index_ -= n;
+            return *this;
+        }
+
+        friend Iterator operator+(Iterator it, difference_type n) noexcept { return it += n; }
+
+        friend Iterator operator+(difference_type n, Iterator it) noexcept { return it += n; }
+
+        friend Iterator operator-(Iterator it, difference_type n) noexcept { return it -= n; }
+
+        friend difference_type operator-(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs) noexcept { return lhs.index_ == rhs.index_; }
+
+        friend auto operator<=>(const Iterator& lhs, const Iterator& rhs) noexcept { return lhs.index_ <=> rhs.index_; }
+
+    private:
+        friend class FileStorage;
+
+        Iterator(const FileStorage* storage, std::size_t index) noexcept : storage_(storage), index_(index) {}
+
+        const FileStorage* storage_{nullptr};
+        std::size_t index_{0};
+    };
+
+    FileStorage() = default;
+
+    std::size_t size() const noexcept { return lengths_.size(); }
+
+    bool empty() const noexcept { return lengths_.empty(); }
+
+    std::int64_t length(std::size_t index) const noexcept { return lengths_[index]; }
+
+    std::int64_t offset(std::size_t index) const noexcept { return offsets_[index]; }
+
+    // The last component of the file's path.
+    std::string_view file_name(std::size_t index) const noexcept { return name(file_names_[index]); }
+
+    std::filesystem::path path(std::size_t index) const;
+
+    FileInfo operator[](std::size_t index) const { return {path(index), lengths_[index], offsets_[index]}; }
+
+    FileInfo front() const { return (*this)[0]; }
+
+    FileInfo back() const { return (*this)[size() - 1]; }
+
+    Iterator begin() const noexcept { return {this, 0}; }
+
+    Iterator end() const noexcept { return {this, size()}; }
+
+    std::size_t directory_count() const noexcept { return directories_.size(); }
+
+    // Distinct path components across all files and directories.
+    std::size_t name_count() const noexcept { return name_offsets_.size() - 1; }
+
+private:
+    friend class MetadataCache;
+
+    struct Directory {
+        std::uint32_t parent;
+        std::uint32_t name;
+    };
+
+    std::string_view name(std::uint32_t id) const noexcept {
+        return std::string_view(names_).substr(name_offsets_[id], name_offsets_[id + 1] - name_offsets_[id]);
+    }
+
+    std::string names_;                           // interned components back to back
+    std::vector<std::uint32_t> name_offsets_{0};  // start of each name in names_, then the end of the last
+    std::vector<Directory> directories_;
+    std::vector<std::uint32_t> file_parents_;     // kNoParent for a file at the top
+    std::vector<std::uint32_t> file_names_;
+    std::vector<std::int64_t> lengths_;
+    std::vector<std::int64_t> offsets_;
+};
+
+// Collects files in torrent order. The lookup tables that deduplicate names and directories live only here, so a
+// finished FileStorage carries none of them.
+class FileStorage::Builder {
+public:
+    void reserve(std::size_t files);
+
+    // `components` is the whole path, directories first; the file starts where the previous one ended.
+    Builder& add_file(std::span<const std::string_view> components, std::int64_t length);
+
+    [[nodiscard]] FileStorage finish();
+
+private:
+    struct NameHash {
+        using is_transparent = void;
+
+        std::size_t operator()(std::string_view name) const noexcept { return std::hash<std::string_view>{}(name); }
+    };
+
+    std::uint32_t intern(std::string_view name);
+
+    std::uint32_t directory(std::uint32_t parent, std::uint32_t name);
+
+    FileStorage storage_;
+    std::int64_t next_offset_{0};
+    std::unordered_map<std::string, std::uint32_t, NameHash, std::equal_to<>> name_ids_;
+    std::unordered_map<std::uint64_t, std::uint32_t> directory_ids_;  // (parent << 32 | name) to directory index
+};
+
+}  // namespace bittorrent::core
@@ -6,6 +6,7 @@
 #include <optional>
 #include <vector>
 #include "file_info.hpp"
+#include "file_storage.hpp"
 #include "torrent_info.hpp"
 #include "types.hpp"
 
@@ -87,6 +88,26 @@ struct fmt::formatter<bittorrent::core::FileInfo> {
     }
 };
 
+template <>
+struct fmt::formatter<bittorrent::core::FileStorage> {
+    constexpr auto parse(format_parse_context& ctx) -> decltype(ctx.begin()) { return ctx.begin(); }
+
+    template <typename FormatContext>
+    auto format(const bittorrent::core::FileStorage& files, FormatContext& ctx) const -> decltype(ctx.out()) {
+        auto out = ctx.out();
+        *out++ = '[';
+        for (size_t i = 0; i < files.size(); ++i) {
+            if (i > 0) {
+                *out++ = ',';
+                *out++ = ' ';
+            }
+            out = fmt::format_to(out, "{}", files[i]);
+        }
+        *out++ = ']';
+        return out;
+    }
+};
+
 template <>
 struct fmt::formatter<bittorrent::core::TorrentInfo> {
     constexpr auto parse(format_parse_context& ctx) -> decltype(ctx.begin()) { return ctx.begin(); }
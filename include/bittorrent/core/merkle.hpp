@@ -0,0 +1,68 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace bittorrent::core {
+
+// SHA-256 Merkle tree of BitTorrent v2 (BEP 52). A file is cut into 16 KiB blocks whose hashes are the leaves; the
+// leaf count is padded to a power of two with zero hashes, and each interior node is the hash of its two children
+// concatenated. Only nodes that cover real leaves are stored: a padding subtree is always the same hash, so its value
+// is computed rather than kept, and a tree over a few blocks of a large width stays small.
+class MerkleTree {
+public:
+    static constexpr std::int64_t kBlockSize = 16 * 1024;
+
+    // Builds the tree over `leaves` padded to `width` leaves, a power of two no smaller than the leaf count; zero
+    // picks the smallest such width.
+    explicit MerkleTree(std::span<const SHA256Hash> leaves, std::size_t width = 0);
+
+    // Hashes `data` block by block and builds the tree over the block hashes.
+    static MerkleTree from_data(std::string_view data);
+
+    const SHA256Hash& root() const noexcept { return layers_.back().front(); }
+
+    std::size_t leaf_count() const noexcept { return leaf_count_; }
+
+    std::size_t width() const noexcept { return width_; }
+
+    // Levels between the leaves and the root.
+    std::size_t depth() const noexcept { return layers_.size() - 1; }
+
+    // The nodes that each cover `leaves_per_node` leaves (a power of two no larger than the width), trimmed to those
+    // covering real leaves. With the blocks per piece this is the file's piece layer.
+    std::vector<SHA256Hash> layer(std::size_t leaves_per_node) const;
+
+    // Sibling hashes on the path from leaf `index` up `levels` levels (to the root when zero), bottom first.
+    std::vector<SHA256Hash> proof(std::size_t index, std::size_t levels = 0) const;
+
+    // Blocks needed to hold `length` bytes.
+    static std::size_t block_count(std::int64_t length) noexcept;
+
+    // The hash of each 16 KiB block of `data`, in order; the last block may be short. `out` must hold
+    // `block_count(data.size())` hashes.
+    static void hash_blocks(std::string_view data, std::span<SHA256Hash> out);
+
+    // Root of a subtree of `leaves` zero leaves, `leaves` being a power of two.
+    static SHA256Hash pad_hash(std::size_t leaves);
+
+    // Root over `leaves` padded to `width` with copies of `pad`, the root of one padding leaf, without keeping the
+    // inner layers. Piece layers go up to their file's root this way, with the pad of a piece-sized subtree.
+    static SHA256Hash root_of(std::span<const SHA256Hash> leaves, std::size_t width, const SHA256Hash& pad = {});
+
+    // Root implied by `leaf` sitting at `index` with the sibling hashes `proof`.
+    static SHA256Hash
+    root_from_proof(const SHA256Hash& leaf, std::size_t index, std::span<const SHA256Hash> proof) noexcept;
+
+private:
+    std::vector<std::vector<SHA256Hash>> layers_;  // layers_[0] holds the real leaves, layers_.back() the root
+    std::size_t leaf_count_{0};
+    std::size_t width_{1};
+};
+
+}  // namespace bittorrent::core
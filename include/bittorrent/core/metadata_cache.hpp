@@ -0,0 +1,59 @@
+#pragma once
+
+#include "torrent_info.hpp"
+#include "types.hpp"
+
+#include <expected>
+#include <filesystem>
+#include <optional>
+#include <system_error>
+
+namespace bittorrent::core {
+
+// On-disk cache of decoded torrents, so a restart does not decode and hash every .torrent again. Each TorrentInfo is
+// stored as a flat, checksummed binary snapshot named after its info hash; loading one maps the file and copies
+// the sections out, with no bencode involved. A small per-source index entry records the size and modification
+// time of the .torrent file a snapshot came from, and `lookup` only trusts it while both still match.
+//
+// Snapshots use the host's byte order and are not meant to move between machines. Corrupt, truncated or
+// outdated-version files are treated as misses. All methods are safe to call concurrently.
+class MetadataCache {
+public:
+    static constexpr std::uint32_t kFormatVersion = 4;
+
+    // Size and modification time of a .torrent file.
+    struct SourceStamp {
+        std::uint64_t size;
+        std::int64_t mtime;  // nanoseconds since the file clock's epoch
+
+        bool operator==(const SourceStamp&) const = default;
+    };
+
+    explicit MetadataCache(std::filesystem::path directory);
+
+    const std::filesystem::path& directory() const noexcept { return directory_; }
+
+    [[nodiscard]] std::optional<TorrentInfo> load(const InfoHash& info_hash) const;
+
+    // Snapshot for the torrent last stored from `source`, if that file's size and mtime are unchanged.
+    [[nodiscard]] std::optional<TorrentInfo> lookup(const std::filesystem::path& source) const;
+
+    // Atomically writes the snapshot of `info`.
+    std::expected<void, std::error_code> store(const TorrentInfo& info);
+
+    // Also writes the index entry tying the snapshot to `source`, whose stamp was `read_stamp` before it was read. If
+    // the file has changed since, the entry is left out, so a rewrite between reading and storing cannot index stale
+    // metadata under the new file's stamp.
+    std::expected<void, std::error_code>
+    store(const TorrentInfo& info, const std::filesystem::path& source, const SourceStamp& read_stamp);
+
+    static std::expected<SourceStamp, std::error_code> stamp(const std::filesystem::path& source);
+
+private:
+    std::filesystem::path snapshot_path(const InfoHash& info_hash) const;
+    std::filesystem::path index_path(const std::filesystem::path& source) const;
+
+    std::filesystem::path directory_;
+};
+
+}  // namespace bittorrent::core
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "torrent_info.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <vector>
+
+namespace bittorrent::core {
+
+// The part of one file that a piece or block covers.
+struct FileSlice {
+    std::size_t file_index;
+    std::int64_t file_offset;
+    std::int64_t length;
+
+    bool operator==(const FileSlice&) const = default;
+};
+
+// Maps piece-relative byte ranges onto the files of a torrent. The file start offsets are kept in one array, and a
+// per-piece table records the file each piece starts in, so a lookup binary-searches only the files that piece
+// spans. Empty files never appear in the result. The map copies what it needs and does not refer to the
+// TorrentInfo it was built from.
+class PieceMap {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = FileSlice;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+        Iterator(const PieceMap* map, std::size_t file, std::int64_t position, std::int64_t end) noexcept
+            : map_(map), file_(file), position_(position), end_(end) {}
+
+        FileSlice operator*() const noexcept;
+        Iterator& operator++() noexcept;
+
+        Iterator operator++(int) noexcept {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        bool operator==(const Iterator& other) const noexcept { return position_ == other.position_; }
+
+    private:
+        const PieceMap* map_{nullptr};
+        std::size_t file_{0};
+        std::int64_t position_{0};  // absolute torrent offset
+        std::int64_t end_{0};
+    };
+
+    struct Range {
+        Iterator first;
+        Iterator last;
+
+        Iterator begin() const noexcept { return first; }
+        Iterator end() const noexcept { return last; }
+        bool empty() const noexcept { return first == last; }
+    };
+
+    explicit PieceMap(const TorrentInfo& info);
+
+    std::size_t piece_count() const noexcept { return piece_first_file_.empty() ? 0 : piece_first_file_.size() - 1; }
+
+    std::size_t file_count() const noexcept { return file_starts_.size() - 1; }
+
+    // Index of the file holding the first byte of `piece`.
+    std::size_t first_file(std::size_t piece) const noexcept { return piece_first_file_[piece]; }
+
+    // Slices covering `length` bytes at `offset` within `piece`, in torrent order. The range is clipped to the end
+    // of the piece; an unknown piece yields nothing.
+    Range slices(std::size_t piece, std::int64_t offset, std::int64_t length) const noexcept;
+
+    Range slices(std::size_t piece) const noexcept { return slices(piece, 0, piece_length_); }
+
+    // Appends the slices of every piece in `pieces` to `out`, piece by piece. Returns the number appended.
+    std::size_t append_slices(std::span<const std::size_t> pieces, std::vector<FileSlice>& out) const;
+
+private:
+    std::int64_t piece_start(std::size_t piece) const noexcept {
+        return static_cast<std::int64_t>(piece) * piece_length_;
+    }
+
+    // Last non-empty file in [first, last] that starts at or before `position`.
+    std::size_t locate(std::int64_t position, std::size_t first, std::size_t last) const noexcept;
+
+    std::int64_t piece_length_;
+    std::int64_t total_size_;
+    std::vector<std::int64_t> file_starts_;        // one per file, then total_size_
+    std::vector<std::uint32_t> piece_first_file_;  // one per piece, then the last file
+};
+
+}  // namespace bittorrent::core
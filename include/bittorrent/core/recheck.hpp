@@ -0,0 +1,53 @@
+#pragma once
+
+#include "bitfield.hpp"
+#include "piece_map.hpp"
+#include "torrent_info.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <functional>
+#include <stop_token>
+#include <system_error>
+
+namespace bittorrent::core {
+
+struct RecheckProgress {
+    std::size_t pieces_checked{0};
+    std::size_t pieces_valid{0};
+    std::size_t piece_count{0};
+    std::int64_t bytes_read{0};
+};
+
+// Verifies the data of a torrent stored under a directory against its piece hashes. Workers claim runs of
+// consecutive pieces, ask the kernel to read ahead every file slice of the run, read them with pread and hash the
+// whole run through utils::sha1_batch, so one torrent spreads over every core and keeps the disk queue full.
+// Missing, short or unreadable files only make the pieces they cover invalid. The TorrentInfo must outlive the
+// engine.
+class RecheckEngine {
+public:
+    // Called after each run of pieces, from worker threads but never concurrently; it must not throw.
+    using ProgressCallback = std::function<void(const RecheckProgress& progress)>;
+
+    RecheckEngine(const TorrentInfo& info, std::filesystem::path save_path);
+
+    // Workers, the calling thread included; one per hardware thread when zero.
+    RecheckEngine& set_threads(unsigned threads);
+
+    RecheckEngine& set_progress_callback(ProgressCallback callback);
+
+    // Bit i is set when piece i matches its hash. Returns std::errc::operation_canceled if `stop` is requested
+    // before every piece has been checked.
+    [[nodiscard]] std::expected<Bitfield, std::error_code> run(std::stop_token stop = {}) const;
+
+private:
+    const TorrentInfo& info_;
+    PieceMap map_;
+    std::filesystem::path save_path_;
+    unsigned threads_{0};
+    ProgressCallback on_progress_;
+};
+
+}  // namespace bittorrent::core
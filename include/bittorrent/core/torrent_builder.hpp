@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace bittorrent::core {
+
+// Creates .torrent metainfo for a file or a directory tree. Files are read in large sequential chunks by one reader
+// thread while a pool of workers hashes the pieces of earlier chunks, so a build runs at disk speed rather than at
+// the speed of one core. Directory entries are sorted by path, and offsets follow FileInfo: the files are laid end
+// to end in that order, with no padding.
+class TorrentBuilder {
+public:
+    static constexpr std::int64_t kMinPieceLength = 16 * 1024;
+    static constexpr std::int64_t kMaxPieceLength = 16 * 1024 * 1024;
+
+    explicit TorrentBuilder(std::filesystem::path root);
+
+    // A power of two between kMinPieceLength and kMaxPieceLength; build() fails with invalid_argument on any other
+    // length. Zero picks one that yields roughly 2000 pieces.
+    TorrentBuilder& set_piece_length(std::int64_t piece_length);
+
+    TorrentBuilder& set_announce(std::string url);
+
+    TorrentBuilder& add_announce_tier(std::vector<std::string> urls);
+
+    TorrentBuilder& set_comment(std::string comment);
+
+    TorrentBuilder& set_created_by(std::string created_by);
+
+    TorrentBuilder& set_creation_date(std::chrono::system_clock::time_point date);
+
+    // Hashing workers; one per hardware thread when zero.
+    TorrentBuilder& set_threads(unsigned threads);
+
+    // Reads and hashes everything under the root and returns the encoded metainfo.
+    [[nodiscard]] std::expected<std::string, std::error_code> build() const;
+
+    static std::int64_t default_piece_length(std::int64_t total_size) noexcept;
+
+    static bool is_valid_piece_length(std::int64_t piece_length) noexcept;
+
+private:
+    std::filesystem::path root_;
+    std::int64_t piece_length_{0};
+    std::string announce_;
+    std::vector<std::vector<std::string>> announce_list_;
+    std::optional<std::string> comment_;
+    std::optional<std::string> created_by_;
+    std::optional<std::chrono::system_clock::time_point> creation_date_;
+    unsigned threads_{0};
+};
+
+}  // namespace bittorrent::core
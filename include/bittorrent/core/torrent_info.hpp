@@ -3,23 +3,64 @@
 #include "bittorrent/bencode.hpp"
 #include "errors.hpp"
 #include "file_info.hpp"
+#include "file_storage.hpp"
 #include "types.hpp"
 
 #include <chrono>
 #include <expected>
+#include <functional>
 #include <optional>
 #include <ostream>
+#include <span>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <vector>
 
 namespace bittorrent::core {
 
+class MetadataCache;
+
 class TorrentInfo {
 public:
     [[nodiscard]] static std::expected<TorrentInfo, TorrentError> from_bencode(const bencode::Value& value);
 
+    [[nodiscard]] static std::expected<TorrentInfo, TorrentError> from_bencode(const bencode::ValueView& value);
+
+    // Decodes a .torrent document in a single pass; the info hash is taken over the original bytes of its info
+    // dictionary. Nothing in the result refers to `data`.
+    [[nodiscard]] static std::expected<TorrentInfo, TorrentError> from_bytes(std::string_view data);
+
     [[nodiscard]] static std::expected<TorrentInfo, TorrentError> from_file(const std::filesystem::path& path);
 
+    // Serves `path` from `cache` while the file's size and mtime match its snapshot; otherwise decodes the file and
+    // refreshes the snapshot.
+    [[nodiscard]] static std::expected<TorrentInfo, TorrentError>
+    from_file(const std::filesystem::path& path, MetadataCache& cache);
+
+    // Receives each result of a batch load as soon as it is ready, in completion order. Calls come from worker
+    // threads but never overlap; the callback must not throw.
+    using LoadCallback =
+        std::function<void(const std::filesystem::path& path, std::expected<TorrentInfo, TorrentError> result)>;
+
+    // Reads, decodes and hashes `paths` on `threads` workers (one per hardware thread when zero), the calling thread
+    // included, going through `cache` when one is given. Returns once every file has been reported.
+    static void load_files(
+        std::span<const std::filesystem::path> paths,
+        const LoadCallback& on_loaded,
+        unsigned threads = 0,
+        MetadataCache* cache = nullptr
+    );
+
+    // Batch-loads every `.torrent` file directly inside `directory`. Returns the number of files reported, or the
+    // error that stopped the directory listing, in which case nothing is loaded.
+    [[nodiscard]] static std::expected<std::size_t, std::error_code> load_directory(
+        const std::filesystem::path& directory,
+        const LoadCallback& on_loaded,
+        unsigned threads = 0,
+        MetadataCache* cache = nullptr
+    );
+
     const std::string& name() const noexcept { return name_; }
 
     std::int64_t total_size() const noexcept { return total_size_; }
@@ -30,6 +71,9 @@ public:
 
     const std::vector<SHA1Hash>& piece_hashes() const noexcept { return piece_hashes_; }
 
+    // All piece digests back to back, 20 bytes each, as they appear in the info dictionary's `pieces` string.
+    std::span<const std::byte> piece_hash_bytes() const noexcept { return std::as_bytes(std::span(piece_hashes_)); }
+
     const InfoHash& info_hash() const noexcept { return info_hash_; }
 
     const std::string& announce() const noexcept { return announce_; }
@@ -38,7 +82,7 @@ public:
 
     bool is_single_file() const noexcept { return files_.size() == 1; }
 
-    const std::vector<FileInfo>& files() const noexcept { return files_; }
+    const FileStorage& files() const noexcept { return files_; }
 
     const std::optional<std::string>& comment() const noexcept { return comment_; }
 
@@ -52,7 +96,45 @@ public:
 
     bool verify_piece_hash(std::size_t piece_index, const SHA1Hash& hash) const noexcept;
 
+    // Checks `hashes[i]` against the expected digest of piece `piece_indices[i]` and stores the outcome in
+    // `matches[i]`; out-of-range indices never match. Only the common prefix of the three spans is examined.
+    // Returns the number of matching pieces.
+    std::size_t verify_pieces(
+        std::span<const std::size_t> piece_indices,
+        std::span<const SHA1Hash> hashes,
+        std::span<bool> matches
+    ) const noexcept;
+
+    // BitTorrent v2 (BEP 52) metadata of hybrid torrents, which carry a v2 file tree next to the v1 fields. The v2
+    // info hash is the SHA-256 of the same info dictionary bytes as the v1 one.
+    bool has_v2() const noexcept { return info_hash_v2_.has_value(); }
+
+    const std::optional<SHA256Hash>& info_hash_v2() const noexcept { return info_hash_v2_; }
+
+    // In file tree order; empty unless has_v2().
+    const std::vector<V2FileInfo>& v2_files() const noexcept { return v2_files_; }
+
+    // Checks the hashes of every 16 KiB block of piece `piece` of v2 file `file_index` against the file's piece layer,
+    // or its pieces root for a file of one piece. The last piece of a file has only as many blocks as the file does.
+    bool verify_v2_piece(
+        std::size_t file_index,
+        std::size_t piece,
+        std::span<const SHA256Hash> block_hashes
+    ) const;
+
+    // Checks one block against its file from the sibling hashes `proof`, bottom first, so a bad block is caught
+    // before the rest of its piece arrives. A proof reaching the piece layer is checked against that piece's hash
+    // and one reaching the top against the pieces root.
+    bool verify_v2_block(
+        std::size_t file_index,
+        std::size_t block,
+        const SHA256Hash& block_hash,
+        std::span<const SHA256Hash> proof
+    ) const;
+
 private:
+    friend class MetadataCache;
+
     TorrentInfo() = default;
 
     std::string name_;
@@ -61,14 +143,15 @@ private:
     std::vector<SHA1Hash> piece_hashes_;
     InfoHash info_hash_;
     std::string announce_;
-    std::vector<FileInfo> files_;
+    FileStorage files_;
 
     std::vector<std::vector<std::string>> announce_list_;
     std::optional<std::string> comment_;
     std::optional<std::string> created_by_;
     std::optional<std::chrono::system_clock::time_point> creation_date_;
 
-    std::string info_dict_bencoded_;
+    std::optional<SHA256Hash> info_hash_v2_;
+    std::vector<V2FileInfo> v2_files_;
 };
 
 }  // namespace bittorrent::core
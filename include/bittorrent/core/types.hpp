@@ -3,6 +3,7 @@
 #include <array>
 #include <cstdint>
 #include <expected>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -11,12 +12,21 @@ namespace bittorrent::core {
 // https://www.bittorrent.org/beps/bep_0003.html#:~:text=trackers,they%20cease%20downloading.
 using SHA1Hash = std::array<std::byte, 20>;
 
+// Piece hashes are stored and snapshotted as one packed block of digests.
+static_assert(sizeof(SHA1Hash) == 20 && alignof(SHA1Hash) == 1);
+
 using InfoHash = SHA1Hash;
 
+// BitTorrent v2 (BEP 52) block, piece-layer and Merkle root hashes, and the v2 info hash.
+// https://www.bittorrent.org/beps/bep_0052.html
+using SHA256Hash = std::array<std::byte, 32>;
+
 using PeerID = std::array<std::byte, 20>;
 
 std::string to_hex_string(const SHA1Hash& hash);
 
+std::string to_hex_string(const SHA256Hash& hash);
+
 std::expected<SHA1Hash, std::string> from_hex_string(std::string_view hex);
 
 }  // namespace bittorrent::core
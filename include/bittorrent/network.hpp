@@ -1,6 +1,11 @@
 #pragma once
 
+#include "network/announce_scheduler.hpp"
+#include "network/connection_pool.hpp"
 #include "network/errors.hpp"
 #include "network/http_tracker.hpp"
 #include "network/peer_info.hpp"
+#include "network/resolver_cache.hpp"
+#include "network/tracker_manager.hpp"
 #include "network/tracker_response.hpp"
+#include "network/udp_tracker.hpp"
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "bittorrent/core/types.hpp"
+#include "bittorrent/utils/timer_wheel.hpp"
+#include "http_tracker.hpp"
+#include "tracker_response.hpp"
+#include "udp_tracker.hpp"
+
+namespace bittorrent::network {
+
+// Keeps many torrents announced to their trackers from a single timer. Every announce due is held on a timer wheel,
+// so thousands of torrents cost one steady_timer and O(1) work per announce. Re-announces follow the tracker's
+// interval, shortened by a random fraction so torrents added together drift apart, and never come sooner than its
+// min interval.
+//
+// Due announces are queued per tracker host and drained by at most `max_in_flight_per_host` workers, each sending
+// its announces back to back, so a burst to one host rides a single pooled HTTP connection or cached UDP connection
+// ID. A host that cannot be reached is backed off as a whole; a tracker that rejects one torrent backs off only that
+// torrent. Both backoffs double up to a limit and reset on success. Not thread-safe: use it from its io_context's
+// thread.
+class AnnounceScheduler {
+public:
+    using TorrentId = std::uint32_t;
+    using Result = std::expected<TrackerResponse, TrackerError>;
+    // Called with the outcome of every announce except Stopped. May add, update or remove torrents.
+    using Callback = std::function<void(TorrentId id, const Result& result)>;
+
+    struct Options {
+        std::chrono::milliseconds tick;  // timer resolution
+        std::size_t max_in_flight_per_host;
+        std::chrono::milliseconds initial_backoff;
+        std::chrono::milliseconds max_backoff;
+        double jitter;  // up to this fraction of every delay is cut at random
+        std::chrono::milliseconds min_reannounce;  // floor under whatever interval a tracker asks for
+    };
+
+    // Ceiling on a tracker's interval and min interval, so an absurd value can neither overflow nor park a torrent.
+    static constexpr std::chrono::hours kMaxReannounce{24};
+
+    static constexpr Options kDefaultOptions{
+        std::chrono::seconds(1),
+        2,
+        std::chrono::seconds(15),
+        std::chrono::minutes(30),
+        0.1,
+        std::chrono::seconds(60),
+    };
+
+    AnnounceScheduler(
+        boost::asio::io_context& io_context,
+        HttpTracker& http,
+        UdpTracker& udp,
+        Callback on_result,
+        const Options& options = kDefaultOptions
+    );
+
+    // Starts announcing a torrent to one tracker; the Started announce goes out on the next tick. A torrent on
+    // several trackers is added once per tracker.
+    TorrentId add(
+        std::string announce_url,
+        const core::InfoHash& info_hash,
+        const core::PeerID& peer_id,
+        std::uint16_t port,
+        std::int64_t left
+    );
+
+    // Transfer totals for the next announce.
+    void update(TorrentId id, std::int64_t uploaded, std::int64_t downloaded, std::int64_t left);
+
+    // Sends Completed as soon as the tracker's min interval and any backoff allow. Until the tracker has accepted
+    // Started, Completed waits for it.
+    void completed(TorrentId id);
+
+    // Sends Stopped if the tracker knows the torrent, then forgets it; the id may be handed out again afterwards.
+    void remove(TorrentId id);
+
+    // Ticks the wheel until `stop`, then returns once announces in flight and pending Stopped announces are done.
+    // The scheduler must outlive it.
+    boost::asio::awaitable<void> run();
+
+    void stop();
+
+    // Torrents added and not yet removed.
+    std::size_t size() const noexcept { return entries_.size() - free_.size(); }
+
+    // Public for testing. Time until the next regular announce: the interval cut by `spread`, a fraction, but never
+    // below the min interval, and kept between `floor` and kMaxReannounce.
+    static std::chrono::milliseconds
+    reannounce_delay(const TrackerResponse& response, double spread, std::chrono::milliseconds floor);
+
+private:
+    struct Entry {
+        std::string url;
+        std::string host;  // host and port, the key into hosts_
+        core::InfoHash info_hash{};
+        core::PeerID peer_id{};
+        std::uint16_t port{0};
+        std::int64_t uploaded{0};
+        std::int64_t downloaded{0};
+        std::int64_t left{0};
+        TrackerEvent event{TrackerEvent::Started};
+        std::chrono::milliseconds backoff{0};
+        std::chrono::steady_clock::time_point earliest;  // min interval since the last announce
+        bool live{false};
+        bool started{false};  // the tracker has accepted Started and has not been sent Stopped
+        bool completion_pending{false};  // completed() before Started went through
+        bool queued{false};
+        bool in_flight{false};
+        bool removed{false};
+    };
+
+    struct Host {
+        std::deque<TorrentId> queue;
+        std::size_t workers{0};
+        std::chrono::milliseconds backoff{0};
+        std::chrono::steady_clock::time_point blocked_until;
+    };
+
+    // Hands a due torrent to its host, or puts it back on the wheel while the host is backed off.
+    void dispatch(TorrentId id);
+
+    void enqueue(TorrentId id);
+
+    void schedule(TorrentId id, std::chrono::steady_clock::duration delay);
+
+    // Sends the host's queued announces one after another until the queue is empty or the host is backed off.
+    boost::asio::awaitable<void> work(std::string key);
+
+    void finish(TorrentId id, TrackerEvent sent, const Result& result);
+
+    void release(TorrentId id);
+
+    // A random fraction in [0, jitter).
+    double spread();
+
+    std::chrono::milliseconds jittered(std::chrono::milliseconds delay);
+
+    std::chrono::milliseconds next_backoff(std::chrono::milliseconds backoff) const;
+
+    boost::asio::io_context& io_context_;
+    HttpTracker& http_;
+    UdpTracker& udp_;
+    Callback on_result_;
+    Options options_;
+    utils::TimerWheel wheel_;
+    std::vector<Entry> entries_;  // indexed by TorrentId
+    std::vector<TorrentId> free_;
+    std::unordered_map<std::string, Host> hosts_;
+    std::vector<utils::TimerWheel::Id> due_;
+    boost::asio::steady_timer timer_;  // the tick, then cancelled by each worker that exits once stopping
+    std::size_t workers_{0};
+    bool stopping_{false};
+    std::mt19937 rng_;
+};
+
+}  // namespace bittorrent::network
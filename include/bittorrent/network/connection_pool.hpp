@@ -0,0 +1,84 @@
+#pragma once
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/beast/core/tcp_stream.hpp>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "resolver_cache.hpp"
+
+namespace bittorrent::network {
+
+// Idle HTTP/1.1 keep-alive connections per host and port, so repeated requests to the same tracker skip the DNS
+// lookup and the TCP handshake. The most recently used connection is handed out first. Connections idle for longer
+// than the timeout, or already closed by the server, are dropped when next looked at rather than by a timer. Not
+// thread-safe: use it from its io_context's thread.
+class ConnectionPool {
+public:
+    struct Options {
+        std::size_t max_idle_per_host;  // zero disables pooling
+        std::chrono::seconds idle_timeout;
+        std::chrono::seconds connect_timeout;
+        std::chrono::seconds dns_ttl;
+    };
+
+    static constexpr Options kDefaultOptions{
+        8,
+        std::chrono::seconds(30),
+        std::chrono::seconds(30),
+        std::chrono::minutes(5),
+    };
+
+    struct Connection {
+        boost::beast::tcp_stream stream;
+        bool reused;  // came from the pool, so the server may have closed it since
+    };
+
+    explicit ConnectionPool(boost::asio::io_context& io_context, const Options& options = kDefaultOptions);
+
+    // A warm connection to host and port if there is one, otherwise a new one. Throws boost::system::system_error if
+    // connecting fails or the pool has been shut down.
+    boost::asio::awaitable<Connection> acquire(std::string_view host, std::string_view port);
+
+    // Returns a connection whose last response allowed keep-alive; it is closed instead if the host's pool is full.
+    void release(std::string_view host, std::string_view port, boost::beast::tcp_stream stream);
+
+    // Marks a connection as carrying a request, which shutdown() aborts, until `unwatch`.
+    void watch(boost::beast::tcp_stream& stream) { busy_.insert(&stream); }
+
+    void unwatch(boost::beast::tcp_stream& stream) noexcept { busy_.erase(&stream); }
+
+    // Closes idle connections and those being connected or watched, whose operations then fail with
+    // operation_aborted. Connections released afterwards are closed too.
+    void shutdown();
+
+    std::size_t idle_count() const noexcept;
+
+    std::size_t connections_opened() const noexcept { return opened_; }
+
+    std::size_t connections_reused() const noexcept { return reused_; }
+
+    ResolverCache& resolver() noexcept { return resolver_; }
+
+private:
+    struct Idle {
+        boost::beast::tcp_stream stream;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    boost::asio::io_context& io_context_;
+    Options options_;
+    ResolverCache resolver_;
+    std::unordered_map<std::string, std::vector<Idle>> idle_;  // by "host:port"
+    std::unordered_set<boost::beast::tcp_stream*> busy_;
+    bool shut_down_{false};
+    std::size_t opened_{0};
+    std::size_t reused_{0};
+};
+
+}  // namespace bittorrent::network
@@ -2,16 +2,28 @@
 
 #include <boost/asio/awaitable.hpp>
 #include <boost/asio/io_context.hpp>
+#include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include "bittorrent/core/types.hpp"
+#include "connection_pool.hpp"
 #include "tracker_response.hpp"
 
 namespace bittorrent::network {
 
+// Announces over persistent HTTP/1.1 connections from a ConnectionPool, so torrents sharing a tracker share its
+// connections and its DNS answer.
 class HttpTracker {
 public:
-    explicit HttpTracker(boost::asio::io_context& io_context);
+    // Info-hashes per scrape request. At up to 71 bytes per escaped `info_hash` parameter this keeps the URL within
+    // the 4 KiB that many servers accept.
+    static constexpr std::size_t kMaxScrapeHashes = 50;
+
+    explicit HttpTracker(
+        boost::asio::io_context& io_context,
+        const ConnectionPool::Options& pool_options = ConnectionPool::kDefaultOptions
+    );
 
     boost::asio::awaitable<std::expected<TrackerResponse, TrackerError>> announce(
         std::string_view announce_url,
@@ -24,11 +36,30 @@ public:
         TrackerEvent event = TrackerEvent::None
     );
 
+    // Swarm counts for any number of torrents on the tracker. Info-hashes are packed kMaxScrapeHashes to a request,
+    // as repeated `info_hash` parameters, over the same pooled connection. Should a request fail after others
+    // succeeded, the counts gathered so far are returned and the remaining torrents are left out.
+    boost::asio::awaitable<std::expected<ScrapeResponse, TrackerError>>
+    scrape(std::string_view announce_url, std::span<const core::InfoHash> info_hashes);
+
+    // The scrape URL for an announce URL by the usual convention: the last path segment must start with "announce",
+    // which becomes "scrape". Trackers whose URL does not follow it do not support scrape.
+    static std::optional<std::string> scrape_url(std::string_view announce_url);
+
     // Public for testing
     static std::expected<TrackerResponse, TrackerError> parse_response(std::string_view response_body);
 
+    // Public for testing
+    static std::expected<ScrapeResponse, TrackerError> parse_scrape_response(std::string_view response_body);
+
+    // Aborts requests in flight, which then fail with ConnectionFailed, and closes pooled connections. For shutting
+    // down without waiting out slow trackers.
+    void shutdown() { pool_.shutdown(); }
+
+    ConnectionPool& connection_pool() noexcept { return pool_; }
+
 private:
-    boost::asio::io_context& io_context_;
+    ConnectionPool pool_;
 };
 
 }  // namespace bittorrent::network
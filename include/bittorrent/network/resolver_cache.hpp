@@ -0,0 +1,50 @@
+#pragma once
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace bittorrent::network {
+
+// Remembers DNS answers per host and port, so announces to a tracker shared by thousands of torrents resolve its
+// name once per TTL rather than once per announce. The system resolver does not report record TTLs, so one TTL
+// applies to every entry. Failed lookups are not cached. Not thread-safe: use it from its io_context's thread.
+class ResolverCache {
+public:
+    using Endpoints = boost::asio::ip::tcp::resolver::results_type;
+
+    explicit ResolverCache(boost::asio::io_context& io_context, std::chrono::seconds ttl = std::chrono::minutes(5));
+
+    // Throws boost::system::system_error if the name cannot be resolved.
+    boost::asio::awaitable<Endpoints> resolve(std::string_view host, std::string_view port);
+
+    // Forgets the answer for host and port, e.g. after none of its endpoints accepted a connection.
+    void invalidate(std::string_view host, std::string_view port);
+
+    std::size_t size() const noexcept { return entries_.size(); }
+
+    std::size_t hits() const noexcept { return hits_; }
+
+    std::size_t misses() const noexcept { return misses_; }
+
+private:
+    struct Entry {
+        Endpoints endpoints;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    static std::string key(std::string_view host, std::string_view port);
+
+    boost::asio::io_context& io_context_;
+    std::chrono::seconds ttl_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::size_t hits_{0};
+    std::size_t misses_{0};
+};
+
+}  // namespace bittorrent::network
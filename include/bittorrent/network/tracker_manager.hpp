@@ -0,0 +1,100 @@
+#pragma once
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "bittorrent/core/torrent_info.hpp"
+#include "bittorrent/core/types.hpp"
+#include "http_tracker.hpp"
+#include "tracker_response.hpp"
+#include "udp_tracker.hpp"
+
+namespace bittorrent::network {
+
+// One torrent on one tracker, for TrackerManager::scrape.
+struct ScrapeTarget {
+    std::string announce_url;
+    core::InfoHash info_hash;
+};
+
+// Announces one torrent to the tiers of its announce list (BEP 12). Every tracker in a tier is asked at once and
+// the first to answer wins; the next tier starts when the current one has failed or is still silent after a short
+// delay, so a dead tracker never costs a full timeout. The tracker that answers first is moved to the front of its
+// tier. Peers from every tracker that answers in time are merged.
+//
+// Announces still running when `announce` returns finish in the background, so the HttpTracker and UdpTracker must
+// outlive them; the manager itself may go away.
+class TrackerManager {
+public:
+    using Tiers = std::vector<std::vector<std::string>>;
+
+    struct Options {
+        std::chrono::milliseconds tier_fallback_delay;  // start the next tier if no tracker has answered by then
+        std::chrono::milliseconds merge_window;         // after the first answer, how long to wait for more peers
+    };
+
+    static constexpr Options kDefaultOptions{
+        std::chrono::seconds(5),
+        std::chrono::milliseconds(250),
+    };
+
+    TrackerManager(HttpTracker& http, UdpTracker& udp, Tiers tiers, const Options& options = kDefaultOptions);
+
+    // The announce-list tiers, or the single `announce` URL when the torrent has no list, each tier shuffled.
+    static Tiers tiers_of(const core::TorrentInfo& torrent);
+
+    boost::asio::awaitable<std::expected<TrackerResponse, TrackerError>> announce(
+        const core::InfoHash& info_hash,
+        const core::PeerID& peer_id,
+        std::uint16_t port,
+        std::int64_t uploaded,
+        std::int64_t downloaded,
+        std::int64_t left,
+        TrackerEvent event = TrackerEvent::None
+    );
+
+    // Swarm counts for many torrents in a handful of requests: targets are grouped by tracker, every tracker is
+    // scraped at once, and each packs its info-hashes into as few requests as its protocol allows. Trackers that fail
+    // are logged and left out, though one failing partway still contributes the counts it returned; where several
+    // report the same torrent, the highest counts win.
+    static boost::asio::awaitable<ScrapeResponse>
+    scrape(HttpTracker& http, UdpTracker& udp, std::span<const ScrapeTarget> targets);
+
+    // Current tracker order, which changes as trackers answer.
+    const Tiers& tiers() const noexcept { return *tiers_; }
+
+private:
+    struct Round;
+    struct ScrapeRound;
+
+    static boost::asio::awaitable<void> announce_one(
+        HttpTracker& http,
+        UdpTracker& udp,
+        std::shared_ptr<Tiers> tiers,
+        std::shared_ptr<Round> round,
+        std::size_t tier,
+        std::string url
+    );
+
+    static boost::asio::awaitable<void> scrape_one(
+        HttpTracker& http,
+        UdpTracker& udp,
+        std::shared_ptr<ScrapeRound> round,
+        std::string url,
+        std::vector<core::InfoHash> info_hashes
+    );
+
+    HttpTracker& http_;
+    UdpTracker& udp_;
+    std::shared_ptr<Tiers> tiers_;  // shared with announces that outlive their round
+    Options options_;
+};
+
+}  // namespace bittorrent::network
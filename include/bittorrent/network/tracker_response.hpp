@@ -1,9 +1,11 @@
 #pragma once
 
 #include <chrono>
+#include <map>
 #include <optional>
 #include <string>
 #include <vector>
+#include "bittorrent/core/types.hpp"
 #include "errors.hpp"
 #include "peer_info.hpp"
 
@@ -19,4 +21,14 @@ struct TrackerResponse {
     std::optional<std::string> warning_message;
 };
 
+// Swarm counts for one torrent, as reported by a scrape.
+struct ScrapeStats {
+    std::int64_t complete{0};    // Number of seeders
+    std::int64_t downloaded{0};  // Completed downloads the tracker has seen
+    std::int64_t incomplete{0};  // Number of leechers
+};
+
+// Info-hashes the tracker knows about; ones it does not are absent.
+using ScrapeResponse = std::map<core::InfoHash, ScrapeStats>;
+
 }  // namespace bittorrent::network
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "bittorrent/core/types.hpp"
+#include "tracker_response.hpp"
+
+namespace bittorrent::network {
+
+// Announces to and scrapes udp:// trackers (BEP 15). Every torrent shares one socket; replies are routed back to
+// their request by transaction ID and sender. Connection IDs are kept per tracker for their lifetime, so a request
+// usually costs a single round trip. Lost packets are retransmitted after 15 * 2^n seconds. IPv4 only, like
+// PeerInfo. Not thread-safe: use it from its io_context's thread.
+class UdpTracker {
+public:
+    struct Options {
+        std::chrono::milliseconds initial_timeout;  // doubled after every retransmission
+        int max_retransmits;
+        std::chrono::seconds connection_id_lifetime;
+        std::chrono::seconds dns_ttl;
+    };
+
+    // Info-hashes per scrape packet: the BEP 15 limit.
+    static constexpr std::size_t kMaxScrapeHashes = 74;
+
+    static constexpr Options kDefaultOptions{
+        std::chrono::seconds(15),
+        8,
+        std::chrono::seconds(60),
+        std::chrono::minutes(5),
+    };
+
+    explicit UdpTracker(boost::asio::io_context& io_context, const Options& options = kDefaultOptions);
+
+    boost::asio::awaitable<std::expected<TrackerResponse, TrackerError>> announce(
+        std::string_view announce_url,
+        const core::InfoHash& info_hash,
+        const core::PeerID& peer_id,
+        std::uint16_t port,
+        std::int64_t uploaded,
+        std::int64_t downloaded,
+        std::int64_t left,
+        TrackerEvent event = TrackerEvent::None
+    );
+
+    // Swarm counts for any number of torrents on the tracker, kMaxScrapeHashes per request. Should a request fail
+    // after others succeeded, the counts gathered so far are returned and the remaining torrents are left out.
+    boost::asio::awaitable<std::expected<ScrapeResponse, TrackerError>>
+    scrape(std::string_view announce_url, std::span<const core::InfoHash> info_hashes);
+
+    // Public for testing. Decodes an announce or error reply; the transaction ID is not checked.
+    static std::expected<TrackerResponse, TrackerError> parse_response(std::span<const std::uint8_t> packet);
+
+    // Public for testing. Decodes a reply to a scrape of `info_hashes`, whose counts come back in the same order.
+    static std::expected<ScrapeResponse, TrackerError>
+    parse_scrape_response(std::span<const std::uint8_t> packet, std::span<const core::InfoHash> info_hashes);
+
+    // Closes the socket and fails every request in flight, and any made later, with ConnectionFailed, so their
+    // coroutines finish promptly instead of retransmitting to trackers that do not answer.
+    void shutdown();
+
+    // Connect requests sent so far; with a warm connection ID cache this stays far below the number of announces.
+    std::size_t connects_sent() const noexcept { return connects_; }
+
+private:
+    struct Transaction;
+
+    // The socket and the requests waiting on it. Owned jointly with the receive loop, whose last read completes only
+    // after the final request has returned and may outlive the tracker.
+    struct Channel {
+        explicit Channel(boost::asio::io_context& io_context);
+
+        boost::asio::ip::udp::socket socket;
+        std::vector<std::uint8_t> buffer;
+        std::unordered_map<std::uint32_t, Transaction*> transactions;
+        bool receiving{false};
+    };
+
+    struct Tracker {
+        explicit Tracker(boost::asio::io_context& io_context);
+
+        boost::asio::ip::udp::endpoint endpoint;
+        std::chrono::steady_clock::time_point endpoint_expires;
+        std::uint64_t connection_id{0};
+        std::chrono::steady_clock::time_point connection_expires;
+        bool connecting{false};
+        boost::asio::steady_timer connect_done;  // never expires; cancelled when the connect in flight ends
+    };
+
+    static boost::asio::awaitable<void> receive_loop(std::shared_ptr<Channel> channel);
+
+    boost::asio::awaitable<Tracker*> lookup(const std::string& host, const std::string& port);
+
+    // Sends `packet`, whose 16-byte header (connection ID, action, transaction ID) is filled in here, and returns the
+    // reply. Connects first when the cached connection ID has expired, and retransmits both as BEP 15 prescribes.
+    // Error replies come back as TrackerFailure.
+    boost::asio::awaitable<std::expected<std::vector<std::uint8_t>, TrackerError>>
+    request(std::string_view tracker_url, std::span<std::uint8_t> packet, std::uint32_t action);
+
+    // Gets `tracker` a fresh connection ID. Only one connect is in flight per tracker; other requests wait for its
+    // outcome instead of sending their own. Timeout means no ID yet, so the caller may retry.
+    boost::asio::awaitable<std::expected<void, TrackerError>>
+    connect(Tracker& tracker, std::uint32_t transaction_id, std::chrono::milliseconds timeout);
+
+    // The connect exchange itself, for `connect`.
+    boost::asio::awaitable<std::expected<void, TrackerError>>
+    send_connect(Tracker& tracker, std::uint32_t transaction_id, std::chrono::milliseconds timeout);
+
+    // Sends `packet` and waits up to `timeout` for the reply carrying `transaction_id`.
+    boost::asio::awaitable<std::optional<std::vector<std::uint8_t>>> exchange(
+        const boost::asio::ip::udp::endpoint& endpoint,
+        std::span<const std::uint8_t> packet,
+        std::uint32_t transaction_id,
+        std::chrono::milliseconds timeout
+    );
+
+    std::uint32_t next_transaction_id();
+
+    boost::asio::io_context& io_context_;
+    Options options_;
+    std::shared_ptr<Channel> channel_;
+    std::unordered_map<std::string, Tracker> trackers_;  // by "host:port"; never erased, so pointers stay valid
+    std::mt19937 rng_;
+    std::uint32_t key_;
+    std::size_t connects_{0};
+    bool shut_down_{false};
+};
+
+}  // namespace bittorrent::network
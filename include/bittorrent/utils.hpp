@@ -1,3 +1,5 @@
 #pragma once
 
 #include "utils/crypto.hpp"
+#include "utils/mapped_file.hpp"
+#include "utils/timer_wheel.hpp"
@@ -1,10 +1,86 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
 #include <string_view>
+#include <vector>
 #include "bittorrent/core/types.hpp"
 
 namespace bittorrent::utils {
 
+// SHA-1 implementations. The fastest one the CPU supports is chosen at first use; `force_sha1_kernel` exists for
+// tests and benchmarks.
+enum class Sha1Kernel {
+    OpenSsl,  // OpenSSL's SHA1(), one buffer at a time
+    ShaNi,    // x86 SHA extensions, one buffer at a time
+    Avx2,     // eight buffers at once, one per 32-bit AVX2 lane; OpenSSL for the rest
+};
+
+constexpr std::string_view to_string(Sha1Kernel kernel) noexcept {
+    switch (kernel) {
+        case Sha1Kernel::OpenSsl:
+            return "openssl";
+        case Sha1Kernel::ShaNi:
+            return "sha-ni";
+        case Sha1Kernel::Avx2:
+            return "avx2";
+    }
+    return "unknown";
+}
+
 core::SHA1Hash sha1(std::string_view data);
 
+// Hashes every input into the digest at the same index; `digests` must be at least as long as `inputs`. Pieces of
+// equal size make the best use of the multi-buffer kernel, which advances eight inputs in lockstep.
+void sha1_batch(std::span<const std::string_view> inputs, std::span<core::SHA1Hash> digests);
+
+std::vector<core::SHA1Hash> sha1_batch(std::span<const std::string_view> inputs);
+
+// Streaming SHA-1 for data that arrives in pieces, such as the blocks of a piece in download order. Whole 64-byte
+// blocks are hashed straight from the caller's buffer and only a partial block is kept, so the hasher is a small
+// value type: copying it forks the computation. Uses the single-stream block function of the kernel active when
+// it is constructed.
+class Sha1Hasher {
+public:
+    Sha1Hasher() noexcept;
+
+    Sha1Hasher& update(std::span<const std::byte> data) noexcept;
+
+    Sha1Hasher& update(std::string_view data) noexcept;
+
+    // Digest of everything passed to `update` so far; the hasher can keep going afterwards.
+    [[nodiscard]] core::SHA1Hash finalize() const noexcept;
+
+    void reset() noexcept;
+
+    // Bytes hashed so far.
+    std::uint64_t size() const noexcept { return size_; }
+
+private:
+    using CompressFn = void (*)(std::uint32_t (&state)[5], const std::byte* blocks, std::size_t count) noexcept;
+
+    CompressFn compress_;
+    std::uint32_t state_[5];
+    std::uint64_t size_{0};
+    std::array<std::byte, 64> buffer_{};
+};
+
+Sha1Kernel active_sha1_kernel() noexcept;
+
+bool is_sha1_kernel_supported(Sha1Kernel kernel) noexcept;
+
+// Returns false and leaves the active kernel unchanged if the CPU lacks `kernel`.
+bool force_sha1_kernel(Sha1Kernel kernel) noexcept;
+
+// SHA-256 for v2 torrents goes straight to OpenSSL, which picks the SHA extensions or its AVX2 code per call.
+core::SHA256Hash sha256(std::string_view data);
+
+// Hashes every input into the digest at the same index; `digests` must be at least as long as `inputs`.
+void sha256_batch(std::span<const std::string_view> inputs, std::span<core::SHA256Hash> digests);
+
+// SHA-256 of `left` followed by `right`: an interior node of a v2 Merkle tree.
+core::SHA256Hash sha256_pair(const core::SHA256Hash& left, const core::SHA256Hash& right);
+
 }  // namespace bittorrent::utils
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <expected>
+#include <filesystem>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace bittorrent::utils {
+
+// Read-only view of a whole file. Large regular files are memory-mapped, prefaulted and marked for sequential
+// access, so the bytes are never copied into user space; small or non-regular files are read into a buffer, where a
+// single read is cheaper than setting up a mapping. The view stays valid across moves.
+class MappedFile {
+public:
+    // Files smaller than this are read rather than mapped.
+    static constexpr std::size_t kMapThreshold = 64 * 1024;
+
+    [[nodiscard]] static std::expected<MappedFile, std::error_code> open(const std::filesystem::path& path);
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    std::string_view view() const noexcept {
+        return mapping_ ? std::string_view(static_cast<const char*>(mapping_), size_)
+                        : std::string_view(buffer_.data(), buffer_.size());
+    }
+
+    std::size_t size() const noexcept { return mapping_ ? size_ : buffer_.size(); }
+
+    bool is_mapped() const noexcept { return mapping_ != nullptr; }
+
+private:
+    MappedFile() = default;
+
+    void unmap() noexcept;
+
+    void* mapping_{nullptr};
+    std::size_t size_{0};
+    std::vector<char> buffer_;
+};
+
+}  // namespace bittorrent::utils
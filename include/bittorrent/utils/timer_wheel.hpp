@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bittorrent::utils {
+
+// Hierarchical timing wheel (Varghese and Lauck): four levels of 64 slots, each level 64 times coarser than the one
+// below. Scheduling and cancelling are O(1); `advance` is O(1) per tick plus O(1) amortised per timer, since a timer
+// moves down at most three levels before it fires. Delays are in ticks and are capped at 64^4 - 1.
+//
+// Timers are identified by small integers chosen by the caller, such as slots in a table. Nodes live in an array
+// indexed by id, so the wheel allocates only when it sees a larger id than before. Not thread-safe.
+class TimerWheel {
+public:
+    using Id = std::uint32_t;
+
+    static constexpr std::size_t kLevels = 4;
+    static constexpr std::size_t kSlotBits = 6;
+    static constexpr std::size_t kSlots = std::size_t{1} << kSlotBits;
+    static constexpr std::uint64_t kMaxDelay = (std::uint64_t{1} << (kSlotBits * kLevels)) - 1;
+
+    // Fires `id` `delay` ticks from now, or on the next tick if `delay` is zero. Replaces any earlier schedule.
+    void schedule(Id id, std::uint64_t delay);
+
+    void cancel(Id id) noexcept;
+
+    bool scheduled(Id id) const noexcept { return id < nodes_.size() && nodes_[id].slot != kNone; }
+
+    // Moves time on by one tick and appends the ids that are now due to `due`.
+    void advance(std::vector<Id>& due);
+
+    std::uint64_t now() const noexcept { return now_; }
+
+    std::size_t size() const noexcept { return size_; }
+
+private:
+    static constexpr Id kNone = 0xFFFFFFFF;
+
+    struct Node {
+        Id prev{kNone};
+        Id next{kNone};
+        Id slot{kNone};  // index into heads_, or kNone when not scheduled
+        std::uint64_t expires{0};
+    };
+
+    static constexpr std::array<Id, kLevels * kSlots> empty_heads() {
+        std::array<Id, kLevels * kSlots> heads{};
+        heads.fill(kNone);
+        return heads;
+    }
+
+    // Puts a node into the slot for its expiry: the finest level whose span still reaches it.
+    void link(Id id) noexcept;
+
+    void unlink(Id id) noexcept;
+
+    std::vector<Node> nodes_;
+    std::array<Id, kLevels * kSlots> heads_ = empty_heads();  // per slot, the first node of a doubly linked list
+    std::uint64_t now_{0};
+    std::size_t size_{0};
+};
+
+}  // namespace bittorrent::utils
@@ -0,0 +1,173 @@
+#include "bittorrent/bencode/decode.hpp"
+#include <charconv>
+#include "bittorrent/bencode/scan.hpp"
+
+namespace bittorrent::bencode {
+
+namespace {
+
+bool is_digit(char c) noexcept {
+    return static_cast<unsigned char>(c - '0') <= 9;
+}
+
+std::optional<TokenType> token_type(char c) noexcept {
+    if (c == 'i') {
+        return TokenType::Integer;
+    }
+    if (is_digit(c)) {
+        return TokenType::String;
+    }
+    if (c == 'l') {
+        return TokenType::List;
+    }
+    if (c == 'd') {
+        return TokenType::Dictionary;
+    }
+    return std::nullopt;
+}
+
+}  // anonymous namespace
+
+std::string to_string(const DecodeError& error) {
+    std::string message;
+    switch (error.kind) {
+        case DecodeError::Kind::Syntax:
+            message = to_string(error.syntax);
+            break;
+        case DecodeError::Kind::TypeMismatch:
+            message = "Expected ";
+            message += to_string(error.expected);
+            message += ", found ";
+            message += to_string(error.actual);
+            break;
+        case DecodeError::Kind::MissingField:
+            message = "Missing required field";
+            break;
+        case DecodeError::Kind::InvalidValue:
+            message = "Value out of range";
+            break;
+    }
+    if (!error.field.empty()) {
+        message += " for key '";
+        message += error.field;
+        message += '\'';
+    }
+    message += " at offset ";
+    message += std::to_string(error.offset);
+    return message;
+}
+
+std::expected<TokenType, DecodeError> Reader::peek() const {
+    if (pos_ == data_.size()) {
+        return std::unexpected(syntax_error(ParseError::UnexpectedEnd));
+    }
+    if (auto type = token_type(data_[pos_])) {
+        return *type;
+    }
+    return std::unexpected(syntax_error(ParseError::UnexpectedCharacter));
+}
+
+DecodeError Reader::type_error(TokenType expected) const noexcept {
+    auto actual = peek();
+    if (!actual) {
+        return actual.error();
+    }
+    return {DecodeError::Kind::TypeMismatch, pos_, {}, ParseError::InvalidFormat, expected, *actual};
+}
+
+std::expected<Integer, DecodeError> Reader::read_integer() {
+    if (pos_ == data_.size() || data_[pos_] != 'i') {
+        return std::unexpected(type_error(TokenType::Integer));
+    }
+
+    const std::size_t start = pos_ + 1;
+    const std::size_t end = scan_for(data_, start, 'e');
+    if (end == data_.size()) {
+        return std::unexpected(syntax_error(ParseError::UnexpectedEnd));
+    }
+
+    std::string_view digits = data_.substr(start, end - start);
+    if ((digits.size() > 1 && digits[0] == '0') || digits == "-0") {
+        return std::unexpected(syntax_error(ParseError::InvalidInteger));
+    }
+
+    Integer value;
+    auto [ptr, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+    if (ec != std::errc{} || ptr != digits.data() + digits.size()) {
+        return std::unexpected(syntax_error(ParseError::InvalidInteger));
+    }
+
+    pos_ = end + 1;
+    return value;
+}
+
+std::expected<std::string_view, DecodeError> Reader::read_string() {
+    if (pos_ == data_.size() || !is_digit(data_[pos_])) {
+        return std::unexpected(type_error(TokenType::String));
+    }
+
+    const std::size_t colon = scan_digits(data_, pos_);
+    if (colon == data_.size() || data_[colon] != ':') {
+        return std::unexpected(syntax_error(ParseError::InvalidString));
+    }
+
+    std::size_t length;
+    auto [ptr, ec] = std::from_chars(data_.data() + pos_, data_.data() + colon, length);
+    if (ec != std::errc{}) {
+        return std::unexpected(syntax_error(ParseError::InvalidLength));
+    }
+
+    if (length > data_.size() - colon - 1) {
+        return std::unexpected(syntax_error(ParseError::UnexpectedEnd));
+    }
+
+    pos_ = colon + 1 + length;
+    return data_.substr(colon + 1, length);
+}
+
+std::expected<void, DecodeError> Reader::skip() {
+    auto type = peek();
+    if (!type) {
+        return std::unexpected(type.error());
+    }
+
+    switch (*type) {
+        case TokenType::Integer:
+            if (auto integer = read_integer(); !integer) {
+                return std::unexpected(integer.error());
+            }
+            return {};
+        case TokenType::String:
+            if (auto string = read_string(); !string) {
+                return std::unexpected(string.error());
+            }
+            return {};
+        case TokenType::List:
+            return read_list([this] { return skip(); });
+        case TokenType::Dictionary:
+            return read_dictionary([this](std::string_view) { return skip(); });
+    }
+    return {};
+}
+
+std::expected<std::string_view, DecodeError> Reader::read_raw() {
+    const std::size_t start = pos_;
+    if (auto skipped = skip(); !skipped) {
+        return std::unexpected(skipped.error());
+    }
+    return data_.substr(start, pos_ - start);
+}
+
+std::expected<void, DecodeError> Reader::enter(char opener) {
+    if (pos_ == data_.size() || data_[pos_] != opener) {
+        return std::unexpected(type_error(opener == 'l' ? TokenType::List : TokenType::Dictionary));
+    }
+    if (depth_ == kMaxDepth) {
+        return std::unexpected(syntax_error(ParseError::NestingTooDeep));
+    }
+    ++depth_;
+    ++pos_;
+    return {};
+}
+
+}  // namespace bittorrent::bencode
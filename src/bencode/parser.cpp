@@ -1,16 +1,50 @@
 #include "bittorrent/bencode/parser.hpp"
-#include <cctype>
 #include <charconv>
 #include <iostream>
+#include "bittorrent/bencode/scan.hpp"
 
 namespace bittorrent::bencode {
 
+namespace {
+
+bool is_digit(char c) noexcept {
+    return static_cast<unsigned char>(c - '0') <= 9;
+}
+
+template <typename StringT, typename Alloc>
+StringT make_string(std::string_view value, const Alloc& alloc) {
+    if constexpr (std::is_same_v<StringT, std::string_view>) {
+        return value;
+    } else {
+        return StringT(value, alloc);
+    }
+}
+
+}  // anonymous namespace
+
 std::expected<Value, ParseError> Parser::parse(std::string_view data) {
     Parser parser(data);
-    return parser.parse_value();
+    return parser.parse_value<Value>({});
+}
+
+std::expected<ValueView, ParseError> Parser::parse_view(std::string_view data) {
+    Parser parser(data);
+    return parser.parse_value<ValueView>({});
 }
 
-std::expected<Value, ParseError> Parser::parse_value() {
+std::expected<pmr::Value, ParseError> Parser::parse(std::string_view data, std::pmr::memory_resource* resource) {
+    Parser parser(data);
+    return parser.parse_value<pmr::Value>(resource);
+}
+
+std::expected<pmr::ValueView, ParseError>
+Parser::parse_view(std::string_view data, std::pmr::memory_resource* resource) {
+    Parser parser(data);
+    return parser.parse_value<pmr::ValueView>(resource);
+}
+
+template <typename V>
+std::expected<V, ParseError> Parser::parse_value(const allocator_for<V>& alloc) {
     if (!has_more()) {
         return std::unexpected(ParseError::UnexpectedEnd);
     }
@@ -22,31 +56,31 @@ std::expected<Value, ParseError> Parser::parse_value() {
         if (!result) {
             return std::unexpected(result.error());
         }
-        return Value{*result};
+        return V{*result};
     }
 
-    if (std::isdigit(static_cast<unsigned char>(c))) {
+    if (is_digit(c)) {
         auto result = parse_string();
         if (!result) {
             return std::unexpected(result.error());
         }
-        return Value{*result};
+        return V{make_string<typename V::string_type>(*result, alloc)};
     }
 
     if (c == 'l') {
-        auto result = parse_list();
+        auto result = parse_list<V>(alloc);
         if (!result) {
             return std::unexpected(result.error());
         }
-        return Value{*result};
+        return V{std::move(*result)};
     }
 
     if (c == 'd') {
-        auto result = parse_dictionary();
+        auto result = parse_dictionary<V>(alloc);
         if (!result) {
             return std::unexpected(result.error());
         }
-        return Value{*result};
+        return V{std::move(*result)};
     }
 
     return std::unexpected(ParseError::UnexpectedCharacter);
@@ -58,9 +92,7 @@ std::expected<Integer, ParseError> Parser::parse_integer() {
     }
 
     size_t start = pos_;
-    while (has_more() && peek() != 'e') {
-        consume();
-    }
+    pos_ = scan_for(data_, pos_, 'e');
 
     if (!has_more()) {
         return std::unexpected(ParseError::UnexpectedEnd);
@@ -87,11 +119,9 @@ std::expected<Integer, ParseError> Parser::parse_integer() {
     return value;
 }
 
-std::expected<String, ParseError> Parser::parse_string() {
+std::expected<std::string_view, ParseError> Parser::parse_string() {
     size_t start = pos_;
-    while (has_more() && std::isdigit(static_cast<unsigned char>(peek()))) {
-        consume();
-    }
+    pos_ = scan_digits(data_, pos_);
 
     if (!has_more() || peek() != ':') {
         std::cerr << "Invalid string at pos " << pos_ << ": expected ':', got '" << peek() << "'\n";
@@ -115,22 +145,23 @@ std::expected<String, ParseError> Parser::parse_string() {
         return std::unexpected(ParseError::UnexpectedEnd);
     }
 
-    std::string result(data_.substr(pos_, length));
+    std::string_view result = data_.substr(pos_, length);
     skip(length);
 
     return result;
 }
 
-std::expected<List, ParseError> Parser::parse_list() {
+template <typename V>
+std::expected<typename V::list_type, ParseError> Parser::parse_list(const allocator_for<V>& alloc) {
     if (consume() != 'l') {
         std::cerr << "Invalid format in list: " << peek() << std::endl;
         return std::unexpected(ParseError::InvalidFormat);
     }
 
-    List list;
+    typename V::list_type list(alloc);
 
     while (has_more() && peek() != 'e') {
-        auto value = parse_value();
+        auto value = parse_value<V>(alloc);
         if (!value) {
             return std::unexpected(value.error());
         }
@@ -145,17 +176,18 @@ std::expected<List, ParseError> Parser::parse_list() {
     return list;
 }
 
-std::expected<Dictionary, ParseError> Parser::parse_dictionary() {
+template <typename V>
+std::expected<typename V::dictionary_type, ParseError> Parser::parse_dictionary(const allocator_for<V>& alloc) {
     if (consume() != 'd') {
         std::cerr << "Invalid format in dictionary: " << peek() << std::endl;
         return std::unexpected(ParseError::InvalidFormat);
     }
 
-    Dictionary dict;
-    std::string last_key;
+    typename V::dictionary_type dict(alloc);
+    std::string_view last_key;
 
     while (has_more() && peek() != 'e') {
-        if (!std::isdigit(peek())) {
+        if (!is_digit(peek())) {
             std::cerr << "Invalid format in dictionary key: " << pos_ << " " << peek() << std::endl;
             return std::unexpected(ParseError::InvalidFormat);
         }
@@ -171,12 +203,12 @@ std::expected<Dictionary, ParseError> Parser::parse_dictionary() {
         }
         last_key = *key;
 
-        auto value = parse_value();
+        auto value = parse_value<V>(alloc);
         if (!value) {
             return std::unexpected(value.error());
         }
 
-        dict.emplace(std::move(*key), std::move(*value));
+        dict.emplace(make_string<typename V::string_type>(*key, alloc), std::move(*value));
     }
 
     if (!has_more()) {
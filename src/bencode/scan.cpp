@@ -0,0 +1,179 @@
+#include "bittorrent/bencode/scan.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BITTORRENT_SCAN_X86 1
+#endif
+
+namespace bittorrent::bencode {
+
+namespace {
+
+struct Kernel {
+    ScanKernel kind;
+    std::size_t (*scan_digits)(const char* data, std::size_t size, std::size_t pos) noexcept;
+    std::size_t (*scan_for)(const char* data, std::size_t size, std::size_t pos, char c) noexcept;
+};
+
+bool is_digit(char c) noexcept {
+    return static_cast<unsigned char>(c - '0') <= 9;
+}
+
+std::size_t scalar_scan_digits(const char* data, std::size_t size, std::size_t pos) noexcept {
+    while (pos < size && is_digit(data[pos])) {
+        ++pos;
+    }
+    return pos;
+}
+
+std::size_t scalar_scan_for(const char* data, std::size_t size, std::size_t pos, char c) noexcept {
+    while (pos < size && data[pos] != c) {
+        ++pos;
+    }
+    return pos;
+}
+
+constexpr Kernel kScalar{ScanKernel::Scalar, scalar_scan_digits, scalar_scan_for};
+
+#ifdef BITTORRENT_SCAN_X86
+
+// A byte is a digit iff (byte - '0') as unsigned is at most 9, i.e. min(byte - '0', 9) == byte - '0'.
+__attribute__((target("sse2"))) std::size_t
+sse2_scan_digits(const char* data, std::size_t size, std::size_t pos) noexcept {
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i chunk = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos)), zero);
+        auto digits = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(chunk, nine), chunk)));
+        if (digits != 0xFFFF) {
+            return pos + std::countr_one(digits);
+        }
+    }
+    return scalar_scan_digits(data, size, pos);
+}
+
+__attribute__((target("sse2"))) std::size_t
+sse2_scan_for(const char* data, std::size_t size, std::size_t pos, char c) noexcept {
+    const __m128i needle = _mm_set1_epi8(c);
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        auto hits = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+        if (hits != 0) {
+            return pos + std::countr_zero(hits);
+        }
+    }
+    return scalar_scan_for(data, size, pos, c);
+}
+
+__attribute__((target("avx2"))) std::size_t
+avx2_scan_digits(const char* data, std::size_t size, std::size_t pos) noexcept {
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i nine = _mm256_set1_epi8(9);
+    for (; pos + 32 <= size; pos += 32) {
+        __m256i chunk = _mm256_sub_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos)), zero);
+        auto digits =
+            static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(chunk, nine), chunk)));
+        if (digits != 0xFFFFFFFF) {
+            return pos + std::countr_one(digits);
+        }
+    }
+    return sse2_scan_digits(data, size, pos);
+}
+
+__attribute__((target("avx2"))) std::size_t
+avx2_scan_for(const char* data, std::size_t size, std::size_t pos, char c) noexcept {
+    const __m256i needle = _mm256_set1_epi8(c);
+    for (; pos + 32 <= size; pos += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        auto hits = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)));
+        if (hits != 0) {
+            return pos + std::countr_zero(hits);
+        }
+    }
+    return sse2_scan_for(data, size, pos, c);
+}
+
+constexpr Kernel kSse2{ScanKernel::Sse2, sse2_scan_digits, sse2_scan_for};
+constexpr Kernel kAvx2{ScanKernel::Avx2, avx2_scan_digits, avx2_scan_for};
+
+#endif
+
+const Kernel* kernel_for(ScanKernel kind) noexcept {
+    switch (kind) {
+        case ScanKernel::Scalar:
+            return &kScalar;
+#ifdef BITTORRENT_SCAN_X86
+        case ScanKernel::Sse2:
+            return __builtin_cpu_supports("sse2") ? &kSse2 : nullptr;
+        case ScanKernel::Avx2:
+            return __builtin_cpu_supports("avx2") ? &kAvx2 : nullptr;
+#else
+        default:
+            return nullptr;
+#endif
+    }
+    return nullptr;
+}
+
+const Kernel* select_kernel() noexcept {
+    for (auto kind : {ScanKernel::Avx2, ScanKernel::Sse2}) {
+        if (const auto* kernel = kernel_for(kind)) {
+            return kernel;
+        }
+    }
+    return &kScalar;
+}
+
+std::atomic<const Kernel*>& active_kernel() noexcept {
+    static std::atomic<const Kernel*> kernel{select_kernel()};
+    return kernel;
+}
+
+}  // anonymous namespace
+
+// Length prefixes and integers are usually a handful of bytes, so the first few are checked inline before paying
+// for the indirect call into the vector kernel.
+constexpr std::size_t kInlinePrefix = 8;
+
+std::size_t scan_digits(std::string_view data, std::size_t pos) noexcept {
+    const std::size_t inline_end = std::min(data.size(), pos + kInlinePrefix);
+    for (; pos < inline_end; ++pos) {
+        if (!is_digit(data[pos])) {
+            return pos;
+        }
+    }
+    return active_kernel().load(std::memory_order_relaxed)->scan_digits(data.data(), data.size(), pos);
+}
+
+std::size_t scan_for(std::string_view data, std::size_t pos, char c) noexcept {
+    const std::size_t inline_end = std::min(data.size(), pos + kInlinePrefix);
+    for (; pos < inline_end; ++pos) {
+        if (data[pos] == c) {
+            return pos;
+        }
+    }
+    return active_kernel().load(std::memory_order_relaxed)->scan_for(data.data(), data.size(), pos, c);
+}
+
+ScanKernel active_scan_kernel() noexcept {
+    return active_kernel().load(std::memory_order_relaxed)->kind;
+}
+
+bool is_scan_kernel_supported(ScanKernel kernel) noexcept {
+    return kernel_for(kernel) != nullptr;
+}
+
+bool force_scan_kernel(ScanKernel kernel) noexcept {
+    const auto* selected = kernel_for(kernel);
+    if (!selected) {
+        return false;
+    }
+    active_kernel().store(selected, std::memory_order_relaxed);
+    return true;
+}
+
+}  // namespace bittorrent::bencode
@@ -0,0 +1,217 @@
+#include "bittorrent/bencode/tape.hpp"
+#include <charconv>
+#include <limits>
+#include <variant>
+#include "bittorrent/bencode/scan.hpp"
+
+namespace bittorrent::bencode {
+
+namespace {
+
+// Enough for any std::size_t; longer prefixes can only be zero-padded.
+constexpr std::size_t kMaxLengthDigits = 20;
+
+bool is_digit(char c) noexcept {
+    return static_cast<unsigned char>(c - '0') <= 9;
+}
+
+struct Frame {
+    std::uint32_t token;
+    bool is_dictionary;
+    bool expect_key;
+    std::string_view last_key;
+};
+
+}  // anonymous namespace
+
+std::expected<Tape, ParseError> Tape::parse(std::string_view data) {
+    if (data.size() >= std::numeric_limits<std::uint32_t>::max()) {
+        return std::unexpected(ParseError::InvalidLength);
+    }
+
+    Tape tape(data);
+    tape.tokens_.reserve(data.size() / 8 + 1);
+
+    std::vector<Frame> stack;
+    std::size_t pos = 0;
+
+    do {
+        if (pos >= data.size()) {
+            return std::unexpected(ParseError::UnexpectedEnd);
+        }
+
+        const char c = data[pos];
+        const auto index = static_cast<std::uint32_t>(tape.tokens_.size());
+        Frame* parent = stack.empty() ? nullptr : &stack.back();
+
+        if (c == 'e') {
+            if (!parent || (parent->is_dictionary && !parent->expect_key)) {
+                return std::unexpected(ParseError::UnexpectedCharacter);
+            }
+            auto& open = tape.tokens_[parent->token];
+            open.next = index;
+            open.length = static_cast<std::uint32_t>(pos + 1 - open.offset);
+            stack.pop_back();
+            ++pos;
+            if (!stack.empty() && stack.back().is_dictionary) {
+                stack.back().expect_key = true;
+            }
+            continue;
+        }
+
+        const bool is_key = parent && parent->is_dictionary && parent->expect_key;
+        if (is_key && !is_digit(c)) {
+            return std::unexpected(ParseError::InvalidFormat);
+        }
+
+        if (c == 'i') {
+            std::size_t start = ++pos;
+            pos = scan_for(data, pos, 'e');
+            if (pos >= data.size()) {
+                return std::unexpected(ParseError::UnexpectedEnd);
+            }
+
+            std::string_view digits = data.substr(start, pos - start);
+            if ((digits.size() > 1 && digits[0] == '0') || digits == "-0") {
+                return std::unexpected(ParseError::InvalidInteger);
+            }
+            Integer value;
+            auto [ptr, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+            if (ec != std::errc{} || ptr != digits.data() + digits.size()) {
+                return std::unexpected(ParseError::InvalidInteger);
+            }
+
+            ++pos;
+            tape.tokens_.push_back(
+                {TokenType::Integer,
+                 1,
+                 index + 1,
+                 static_cast<std::uint32_t>(start),
+                 static_cast<std::uint32_t>(digits.size())}
+            );
+        } else if (is_digit(c)) {
+            std::size_t start = pos;
+            pos = scan_digits(data, pos);
+            if (pos >= data.size() || data[pos] != ':') {
+                return std::unexpected(ParseError::InvalidString);
+            }
+
+            std::size_t length;
+            auto [ptr, ec] = std::from_chars(data.data() + start, data.data() + pos, length);
+            if (ec != std::errc{} || pos - start > kMaxLengthDigits) {
+                return std::unexpected(ParseError::InvalidLength);
+            }
+
+            ++pos;
+            if (length > data.size() - pos) {
+                return std::unexpected(ParseError::UnexpectedEnd);
+            }
+
+            if (is_key) {
+                std::string_view key = data.substr(pos, length);
+                if (!parent->last_key.empty() && key <= parent->last_key) {
+                    return std::unexpected(ParseError::InvalidFormat);
+                }
+                parent->last_key = key;
+            }
+
+            tape.tokens_.push_back(
+                {TokenType::String,
+                 static_cast<std::uint8_t>(pos - start),
+                 index + 1,
+                 static_cast<std::uint32_t>(pos),
+                 static_cast<std::uint32_t>(length)}
+            );
+            pos += length;
+        } else if (c == 'l' || c == 'd') {
+            const bool is_dictionary = c == 'd';
+            tape.tokens_.push_back(
+                {is_dictionary ? TokenType::Dictionary : TokenType::List, 0, 0, static_cast<std::uint32_t>(pos), 0}
+            );
+            ++pos;
+            if (parent && parent->is_dictionary) {
+                parent->expect_key = !parent->expect_key;
+            }
+            stack.push_back({index, is_dictionary, true, {}});
+            continue;
+        } else {
+            return std::unexpected(ParseError::UnexpectedCharacter);
+        }
+
+        if (parent && parent->is_dictionary) {
+            parent->expect_key = !parent->expect_key;
+        }
+    } while (!stack.empty());
+
+    return tape;
+}
+
+Integer TapeCursor::as_integer() const {
+    const auto& t = token();
+    if (t.type != TokenType::Integer) {
+        throw std::bad_variant_access();
+    }
+    const char* first = tape_->data().data() + t.offset;
+    Integer value{0};
+    std::from_chars(first, first + t.length, value);
+    return value;
+}
+
+std::string_view TapeCursor::as_string() const {
+    const auto& t = token();
+    if (t.type != TokenType::String) {
+        throw std::bad_variant_access();
+    }
+    return tape_->data().substr(t.offset, t.length);
+}
+
+TapeCursor::ListRange TapeCursor::as_list() const {
+    const auto& t = token();
+    if (t.type != TokenType::List) {
+        throw std::bad_variant_access();
+    }
+    return {{tape_, index_ + 1}, {tape_, t.next}};
+}
+
+TapeCursor::DictionaryRange TapeCursor::as_dictionary() const {
+    const auto& t = token();
+    if (t.type != TokenType::Dictionary) {
+        throw std::bad_variant_access();
+    }
+    return {{tape_, index_ + 1}, {tape_, t.next}};
+}
+
+std::size_t TapeCursor::size() const {
+    const auto& t = token();
+    if (t.type != TokenType::List && t.type != TokenType::Dictionary) {
+        throw std::bad_variant_access();
+    }
+
+    std::size_t count = 0;
+    const auto tokens = tape_->tokens();
+    for (auto i = index_ + 1; i < t.next; i = tokens[i].next) {
+        ++count;
+    }
+    return t.type == TokenType::Dictionary ? count / 2 : count;
+}
+
+std::optional<TapeCursor> TapeCursor::find(std::string_view key) const {
+    for (const auto& [k, v] : as_dictionary()) {
+        if (k == key) {
+            return v;
+        }
+        // Keys are sorted, so nothing past a greater key can match.
+        if (k > key) {
+            break;
+        }
+    }
+    return std::nullopt;
+}
+
+std::string_view TapeCursor::encoded() const noexcept {
+    const auto& t = token();
+    const std::size_t trailer = t.type == TokenType::Integer ? 1 : 0;
+    return tape_->data().substr(t.offset - t.header, t.header + t.length + trailer);
+}
+
+}  // namespace bittorrent::bencode
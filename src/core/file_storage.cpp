@@ -0,0 +1,78 @@
+#include "bittorrent/core/file_storage.hpp"
+
+namespace bittorrent::core {
+
+std::filesystem::path FileStorage::path(std::size_t index) const {
+    // Collect the chain leaf first, then append it root first. Torrent paths are only a few levels deep.
+    std::vector<std::uint32_t> chain{file_names_[index]};
+    for (auto dir = file_parents_[index]; dir != kNoParent; dir = directories_[dir].parent) {
+        chain.push_back(directories_[dir].name);
+    }
+
+    std::filesystem::path result;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        result /= name(*it);
+    }
+    return result;
+}
+
+void FileStorage::Builder::reserve(std::size_t files) {
+    storage_.file_parents_.reserve(files);
+    storage_.file_names_.reserve(files);
+    storage_.lengths_.reserve(files);
+    storage_.offsets_.reserve(files);
+}
+
+FileStorage::Builder&
+FileStorage::Builder::add_file(std::span<const std::string_view> components, std::int64_t length) {
+    auto parent = kNoParent;
+    if (components.size() > 1) {
+        for (const auto component : components.first(components.size() - 1)) {
+            parent = directory(parent, intern(component));
+        }
+    }
+
+    storage_.file_parents_.push_back(parent);
+    storage_.file_names_.push_back(intern(components.empty() ? std::string_view() : components.back()));
+    storage_.lengths_.push_back(length);
+    storage_.offsets_.push_back(next_offset_);
+    next_offset_ += length;
+    return *this;
+}
+
+FileStorage FileStorage::Builder::finish() {
+    name_ids_.clear();
+    directory_ids_.clear();
+    next_offset_ = 0;
+
+    auto storage = std::move(storage_);
+    storage.names_.shrink_to_fit();
+    storage.name_offsets_.shrink_to_fit();
+    storage.directories_.shrink_to_fit();
+
+    storage_ = FileStorage();
+    return storage;
+}
+
+std::uint32_t FileStorage::Builder::intern(std::string_view name) {
+    if (const auto it = name_ids_.find(name); it != name_ids_.end()) {
+        return it->second;
+    }
+    const auto id = static_cast<std::uint32_t>(storage_.name_offsets_.size() - 1);
+    storage_.names_ += name;
+    storage_.name_offsets_.push_back(static_cast<std::uint32_t>(storage_.names_.size()));
+    name_ids_.emplace(std::string(name), id);
+    return id;
+}
+
+std::uint32_t FileStorage::Builder::directory(std::uint32_t parent, std::uint32_t name) {
+    const auto key = static_cast<std::uint64_t>(parent) << 32 | name;
+    const auto [it, inserted] =
+        directory_ids_.try_emplace(key, static_cast<std::uint32_t>(storage_.directories_.size()));
+    if (inserted) {
+        storage_.directories_.push_back({parent, name});
+    }
+    return it->second;
+}
+
+}  // namespace bittorrent::core
@@ -0,0 +1,114 @@
+#include "bittorrent/core/merkle.hpp"
+#include <algorithm>
+#include <bit>
+#include "bittorrent/utils/crypto.hpp"
+
+namespace bittorrent::core {
+
+namespace {
+
+// Roots of padding subtrees 1, 2, 4, ... leaves wide, up to `levels` levels above a leaf of `pad`.
+std::vector<SHA256Hash> pad_hashes(const SHA256Hash& pad, std::size_t levels) {
+    std::vector<SHA256Hash> pads;
+    pads.reserve(levels + 1);
+    pads.push_back(pad);
+    for (std::size_t level = 0; level < levels; ++level) {
+        pads.push_back(utils::sha256_pair(pads.back(), pads.back()));
+    }
+    return pads;
+}
+
+// The layer above `nodes`, with `pad` standing in for a missing right child.
+std::vector<SHA256Hash> parent_layer(std::span<const SHA256Hash> nodes, const SHA256Hash& pad) {
+    std::vector<SHA256Hash> parents((nodes.size() + 1) / 2);
+    for (std::size_t i = 0; i < parents.size(); ++i) {
+        parents[i] = utils::sha256_pair(nodes[2 * i], 2 * i + 1 < nodes.size() ? nodes[2 * i + 1] : pad);
+    }
+    return parents;
+}
+
+std::size_t tree_width(std::size_t leaves, std::size_t width) noexcept {
+    return std::bit_ceil(std::max({leaves, width, std::size_t{1}}));
+}
+
+}  // anonymous namespace
+
+MerkleTree::MerkleTree(std::span<const SHA256Hash> leaves, std::size_t width)
+    : leaf_count_(leaves.size()), width_(tree_width(leaves.size(), width)) {
+    const auto depth = static_cast<std::size_t>(std::countr_zero(width_));
+    const auto pads = pad_hashes({}, depth);
+
+    layers_.reserve(depth + 1);
+    layers_.emplace_back(leaves.begin(), leaves.end());
+    for (std::size_t level = 0; level < depth; ++level) {
+        layers_.push_back(parent_layer(layers_.back(), pads[level]));
+    }
+    if (layers_.back().empty()) {
+        layers_.back().push_back(pads[depth]);
+    }
+}
+
+MerkleTree MerkleTree::from_data(std::string_view data) {
+    std::vector<SHA256Hash> leaves(block_count(static_cast<std::int64_t>(data.size())));
+    hash_blocks(data, leaves);
+    return MerkleTree(leaves);
+}
+
+std::vector<SHA256Hash> MerkleTree::layer(std::size_t leaves_per_node) const {
+    const auto level = std::min<std::size_t>(std::countr_zero(std::max<std::size_t>(leaves_per_node, 1)), depth());
+    return layers_[level];
+}
+
+std::vector<SHA256Hash> MerkleTree::proof(std::size_t index, std::size_t levels) const {
+    levels = levels == 0 ? depth() : std::min(levels, depth());
+    const auto pads = pad_hashes({}, levels);
+
+    std::vector<SHA256Hash> siblings;
+    siblings.reserve(levels);
+    for (std::size_t level = 0; level < levels; ++level, index >>= 1) {
+        const auto sibling = index ^ 1;
+        siblings.push_back(sibling < layers_[level].size() ? layers_[level][sibling] : pads[level]);
+    }
+    return siblings;
+}
+
+std::size_t MerkleTree::block_count(std::int64_t length) noexcept {
+    return length <= 0 ? 0 : static_cast<std::size_t>((length + kBlockSize - 1) / kBlockSize);
+}
+
+void MerkleTree::hash_blocks(std::string_view data, std::span<SHA256Hash> out) {
+    std::vector<std::string_view> blocks;
+    blocks.reserve(block_count(static_cast<std::int64_t>(data.size())));
+    for (std::size_t offset = 0; offset < data.size(); offset += kBlockSize) {
+        blocks.push_back(data.substr(offset, kBlockSize));
+    }
+    utils::sha256_batch(blocks, out);
+}
+
+SHA256Hash MerkleTree::pad_hash(std::size_t leaves) {
+    return pad_hashes({}, static_cast<std::size_t>(std::countr_zero(std::max<std::size_t>(leaves, 1)))).back();
+}
+
+SHA256Hash MerkleTree::root_of(std::span<const SHA256Hash> leaves, std::size_t width, const SHA256Hash& pad) {
+    width = tree_width(leaves.size(), width);
+
+    std::vector<SHA256Hash> nodes(leaves.begin(), leaves.end());
+    SHA256Hash level_pad = pad;
+    for (; width > 1; width /= 2) {
+        nodes = parent_layer(nodes, level_pad);
+        level_pad = utils::sha256_pair(level_pad, level_pad);
+    }
+    return nodes.empty() ? level_pad : nodes.front();
+}
+
+SHA256Hash
+MerkleTree::root_from_proof(const SHA256Hash& leaf, std::size_t index, std::span<const SHA256Hash> proof) noexcept {
+    SHA256Hash node = leaf;
+    for (const auto& sibling : proof) {
+        node = (index & 1) ? utils::sha256_pair(sibling, node) : utils::sha256_pair(node, sibling);
+        index >>= 1;
+    }
+    return node;
+}
+
+}  // namespace bittorrent::core
@@ -0,0 +1,530 @@
+#include "bittorrent/core/metadata_cache.hpp"
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "bittorrent/utils/crypto.hpp"
+#include "bittorrent/utils/mapped_file.hpp"
+
+namespace bittorrent::core {
+
+namespace {
+
+constexpr std::array<char, 8> kSnapshotMagic = {'B', 'T', 'S', 'N', 'A', 'P', '\0', '\0'};
+constexpr std::array<char, 8> kIndexMagic = {'B', 'T', 'I', 'N', 'D', 'E', 'X', '\0'};
+
+enum SnapshotFlags : std::uint32_t {
+    kHasComment = 1u << 0,
+    kHasCreatedBy = 1u << 1,
+    kHasCreationDate = 1u << 2,
+    kHasV2 = 1u << 3,
+};
+
+// Fixed-size prefix of a snapshot. The payload that follows holds, in order: the piece hashes, one FileRecord per
+// file, the file storage's directory nodes and name offsets, the size of each announce tier, one StringRef per tier
+// URL, the StringRefs of name, announce, comment, created-by and the file storage's names, one V2FileRecord per v2
+// file, the piece layers of those files back to back, and finally the string pool they all point into.
+struct SnapshotHeader {
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t header_size;
+    std::uint64_t payload_size;
+    SHA1Hash checksum;  // of the header, with this field zeroed, and the payload
+    InfoHash info_hash;
+    SHA256Hash info_hash_v2;  // kHasV2 only
+    std::int64_t piece_length;
+    std::int64_t total_size;
+    std::int64_t creation_date;  // seconds since the epoch
+    std::uint32_t flags;
+    std::uint32_t piece_count;
+    std::uint32_t file_count;
+    std::uint32_t tier_count;
+    std::uint32_t url_count;
+    std::uint32_t v2_file_count;
+    std::uint32_t directory_count;
+    std::uint32_t name_count;
+};
+
+struct StringRef {
+    std::uint32_t offset;
+    std::uint32_t size;
+};
+
+// A file as FileStorage keeps it: its directory node and the id of its last path component.
+struct FileRecord {
+    std::int64_t length;
+    std::int64_t offset;
+    std::uint32_t parent;
+    std::uint32_t name;
+};
+
+struct V2FileRecord {
+    std::int64_t length;
+    StringRef path;
+    std::uint32_t has_root;
+    std::uint32_t layer_size;  // hashes
+    SHA256Hash pieces_root;
+};
+
+// Followed by the source path bytes.
+struct IndexEntry {
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t path_size;
+    std::uint64_t file_size;
+    std::int64_t mtime;
+    InfoHash info_hash;
+    std::uint32_t reserved;
+};
+
+static_assert(std::is_trivially_copyable_v<SnapshotHeader>);
+static_assert(std::is_trivially_copyable_v<FileRecord>);
+static_assert(std::is_trivially_copyable_v<V2FileRecord>);
+static_assert(std::is_trivially_copyable_v<IndexEntry>);
+static_assert(std::is_standard_layout_v<SnapshotHeader>);
+
+// SHA-1 of a snapshot's header bytes, with the checksum field zeroed, followed by its payload. Covering the header
+// means a flipped count or flag is caught like a flipped payload byte.
+SHA1Hash snapshot_checksum(std::string_view header_bytes, std::string_view payload) {
+    std::array<char, sizeof(SnapshotHeader)> header;
+    std::memcpy(header.data(), header_bytes.data(), header.size());
+    std::memset(header.data() + offsetof(SnapshotHeader, checksum), 0, sizeof(SHA1Hash));
+    return utils::Sha1Hasher().update(std::string_view(header.data(), header.size())).update(payload).finalize();
+}
+
+// Bytes the fixed-size sections need by the counts in the header. Checked against the payload size before any
+// of those counts sizes an allocation, so a damaged header is a miss rather than a huge allocation.
+std::uint64_t fixed_section_bytes(const SnapshotHeader& header) noexcept {
+    return std::uint64_t{header.piece_count} * sizeof(SHA1Hash) +
+           std::uint64_t{header.file_count} * sizeof(FileRecord) +
+           std::uint64_t{header.tier_count} * sizeof(std::uint32_t) +
+           std::uint64_t{header.url_count} * sizeof(StringRef) + 5 * sizeof(StringRef) +
+           std::uint64_t{header.v2_file_count} * sizeof(V2FileRecord);
+}
+
+class SnapshotWriter {
+public:
+    template <typename T>
+    void put(const T& value) {
+        payload_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void put_bytes(std::span<const std::byte> bytes) {
+        payload_.append(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+
+    StringRef intern(std::string_view value) {
+        StringRef ref{static_cast<std::uint32_t>(pool_.size()), static_cast<std::uint32_t>(value.size())};
+        pool_ += value;
+        return ref;
+    }
+
+    std::string finish(SnapshotHeader header) {
+        payload_ += pool_;
+        header.payload_size = payload_.size();
+        header.checksum = {};
+
+        std::string out(reinterpret_cast<const char*>(&header), sizeof(header));
+        const auto checksum = snapshot_checksum(out, payload_);
+        std::memcpy(out.data() + offsetof(SnapshotHeader, checksum), checksum.data(), checksum.size());
+        out += payload_;
+        return out;
+    }
+
+private:
+    std::string payload_;
+    std::string pool_;
+};
+
+// Bounds-checked sequential reads from a snapshot; memcpy keeps them valid for unaligned mappings.
+class SnapshotReader {
+public:
+    explicit SnapshotReader(std::string_view data) noexcept : data_(data) {}
+
+    template <typename T>
+    bool get(T& value) noexcept {
+        if (data_.size() - pos_ < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, data_.data() + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return true;
+    }
+
+    template <typename T>
+    bool get_array(T* values, std::size_t count) noexcept {
+        if (count > (data_.size() - pos_) / sizeof(T)) {
+            return false;
+        }
+        std::memcpy(values, data_.data() + pos_, count * sizeof(T));
+        pos_ += count * sizeof(T);
+        return true;
+    }
+
+    // Everything not read yet.
+    std::string_view rest() const noexcept { return data_.substr(pos_); }
+
+private:
+    std::string_view data_;
+    std::size_t pos_{0};
+};
+
+std::optional<std::string_view> resolve(std::string_view pool, StringRef ref) noexcept {
+    if (ref.offset > pool.size() || ref.size > pool.size() - ref.offset) {
+        return std::nullopt;
+    }
+    return pool.substr(ref.offset, ref.size);
+}
+
+std::int64_t to_mtime(std::filesystem::file_time_type time) noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+std::filesystem::path normalise(const std::filesystem::path& source) {
+    std::error_code ec;
+    auto path = std::filesystem::weakly_canonical(source, ec);
+    return ec ? std::filesystem::absolute(source, ec) : path;
+}
+
+// Writes through a uniquely named temporary and renames it into place, so readers never see a partial file.
+std::expected<void, std::error_code> write_atomically(const std::filesystem::path& path, std::string_view bytes) {
+    static std::atomic<std::uint64_t> counter{0};
+    auto temp = path;
+    temp += ".tmp." + std::to_string(::getpid()) + "." + std::to_string(counter.fetch_add(1));
+
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!out.flush()) {
+            std::error_code ignored;
+            std::filesystem::remove(temp, ignored);
+            return std::unexpected(std::make_error_code(std::errc::io_error));
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+        std::error_code ignored;
+        std::filesystem::remove(temp, ignored);
+        return std::unexpected(ec);
+    }
+    return {};
+}
+
+}  // anonymous namespace
+
+MetadataCache::MetadataCache(std::filesystem::path directory) : directory_(std::move(directory)) {}
+
+std::filesystem::path MetadataCache::snapshot_path(const InfoHash& info_hash) const {
+    return directory_ / (to_hex_string(info_hash) + ".snapshot");
+}
+
+std::filesystem::path MetadataCache::index_path(const std::filesystem::path& source) const {
+    return directory_ / "index" / (to_hex_string(utils::sha1(source.string())) + ".entry");
+}
+
+std::optional<TorrentInfo> MetadataCache::load(const InfoHash& info_hash) const {
+    auto file = utils::MappedFile::open(snapshot_path(info_hash));
+    if (!file) {
+        return std::nullopt;
+    }
+
+    SnapshotReader reader(file->view());
+    SnapshotHeader header;
+    if (!reader.get(header) || header.magic != kSnapshotMagic || header.version != kFormatVersion ||
+        header.header_size != sizeof(SnapshotHeader) || header.info_hash != info_hash ||
+        header.payload_size != reader.rest().size() ||
+        snapshot_checksum(file->view(), reader.rest()) != header.checksum ||
+        fixed_section_bytes(header) > header.payload_size) {
+        spdlog::debug("Ignoring invalid snapshot for {}", to_hex_string(info_hash));
+        return std::nullopt;
+    }
+
+    TorrentInfo info;
+    info.info_hash_ = header.info_hash;
+    info.piece_length_ = header.piece_length;
+    info.total_size_ = header.total_size;
+
+    // The path trie's counts come from the header as well: bound them by the payload too before resizing.
+    auto& storage = info.files_;
+    if (fixed_section_bytes(header) + std::uint64_t{header.directory_count} * sizeof(storage.directories_[0]) +
+            (std::uint64_t{header.name_count} + 1) * sizeof(std::uint32_t) >
+        header.payload_size) {
+        return std::nullopt;
+    }
+
+    std::vector<FileRecord> files(header.file_count);
+    storage.directories_.resize(header.directory_count);
+    storage.name_offsets_.resize(header.name_count + std::size_t{1});
+    std::vector<std::uint32_t> tier_sizes(header.tier_count);
+    std::vector<StringRef> urls(header.url_count);
+    std::array<StringRef, 5> strings;  // name, announce, comment, created by, file names
+    std::vector<V2FileRecord> v2_files(header.v2_file_count);
+
+    info.piece_hashes_.resize(header.piece_count);
+    if (!reader.get_array(info.piece_hashes_.data(), info.piece_hashes_.size()) ||
+        !reader.get_array(files.data(), files.size()) ||
+        !reader.get_array(storage.directories_.data(), storage.directories_.size()) ||
+        !reader.get_array(storage.name_offsets_.data(), storage.name_offsets_.size()) ||
+        !reader.get_array(tier_sizes.data(), tier_sizes.size()) || !reader.get_array(urls.data(), urls.size()) ||
+        !reader.get_array(strings.data(), strings.size()) || !reader.get_array(v2_files.data(), v2_files.size())) {
+        return std::nullopt;
+    }
+
+    info.v2_files_.reserve(v2_files.size());
+    for (const auto& record : v2_files) {
+        auto& file = info.v2_files_.emplace_back(std::filesystem::path(), record.length, std::nullopt);
+        if (record.has_root) {
+            file.pieces_root = record.pieces_root;
+        }
+        if (record.layer_size > reader.rest().size() / sizeof(SHA256Hash)) {
+            return std::nullopt;
+        }
+        file.piece_layer.resize(record.layer_size);
+        if (!reader.get_array(file.piece_layer.data(), file.piece_layer.size())) {
+            return std::nullopt;
+        }
+    }
+    if (header.flags & kHasV2) {
+        info.info_hash_v2_ = header.info_hash_v2;
+    }
+
+    const std::string_view pool = reader.rest();
+    auto name = resolve(pool, strings[0]);
+    auto announce = resolve(pool, strings[1]);
+    auto comment = resolve(pool, strings[2]);
+    auto created_by = resolve(pool, strings[3]);
+    auto file_names = resolve(pool, strings[4]);
+    if (!name || !announce || !comment || !created_by || !file_names) {
+        return std::nullopt;
+    }
+
+    info.name_ = *name;
+    info.announce_ = *announce;
+    if (header.flags & kHasComment) {
+        info.comment_ = std::string(*comment);
+    }
+    if (header.flags & kHasCreatedBy) {
+        info.created_by_ = std::string(*created_by);
+    }
+    if (header.flags & kHasCreationDate) {
+        info.creation_date_ = std::chrono::system_clock::time_point(std::chrono::seconds(header.creation_date));
+    }
+
+    // Names must tile the name bytes, and parents precede their children, so paths always resolve and end.
+    storage.names_ = *file_names;
+    if (storage.name_offsets_.front() != 0 || storage.name_offsets_.back() != storage.names_.size() ||
+        !std::ranges::is_sorted(storage.name_offsets_)) {
+        return std::nullopt;
+    }
+    for (std::size_t i = 0; i < storage.directories_.size(); ++i) {
+        const auto& directory = storage.directories_[i];
+        if ((directory.parent != FileStorage::kNoParent && directory.parent >= i) ||
+            directory.name >= header.name_count) {
+            return std::nullopt;
+        }
+    }
+    storage.file_parents_.reserve(files.size());
+    storage.file_names_.reserve(files.size());
+    storage.lengths_.reserve(files.size());
+    storage.offsets_.reserve(files.size());
+    for (const auto& record : files) {
+        if ((record.parent != FileStorage::kNoParent && record.parent >= header.directory_count) ||
+            record.name >= header.name_count) {
+            return std::nullopt;
+        }
+        storage.file_parents_.push_back(record.parent);
+        storage.file_names_.push_back(record.name);
+        storage.lengths_.push_back(record.length);
+        storage.offsets_.push_back(record.offset);
+    }
+
+    for (std::size_t i = 0; i < v2_files.size(); ++i) {
+        auto path = resolve(pool, v2_files[i].path);
+        if (!path) {
+            return std::nullopt;
+        }
+        info.v2_files_[i].path = std::filesystem::path(*path);
+    }
+
+    std::size_t next_url = 0;
+    info.announce_list_.reserve(tier_sizes.size());
+    for (auto tier_size : tier_sizes) {
+        if (tier_size > urls.size() - next_url) {
+            return std::nullopt;
+        }
+        auto& tier = info.announce_list_.emplace_back();
+        tier.reserve(tier_size);
+        for (std::uint32_t i = 0; i < tier_size; ++i) {
+            auto url = resolve(pool, urls[next_url++]);
+            if (!url) {
+                return std::nullopt;
+            }
+            tier.emplace_back(*url);
+        }
+    }
+
+    return info;
+}
+
+std::optional<TorrentInfo> MetadataCache::lookup(const std::filesystem::path& source) const {
+    const auto normalised = normalise(source);
+    const auto current = stamp(normalised);
+    if (!current) {
+        return std::nullopt;
+    }
+
+    auto file = utils::MappedFile::open(index_path(normalised));
+    if (!file) {
+        return std::nullopt;
+    }
+
+    SnapshotReader reader(file->view());
+    IndexEntry entry;
+    if (!reader.get(entry) || entry.magic != kIndexMagic || entry.version != kFormatVersion ||
+        reader.rest() != normalised.string()) {
+        return std::nullopt;
+    }
+    if (SourceStamp{entry.file_size, entry.mtime} != *current) {
+        spdlog::debug("Cached metadata for {} is stale", source.string());
+        return std::nullopt;
+    }
+
+    return load(entry.info_hash);
+}
+
+std::expected<MetadataCache::SourceStamp, std::error_code> MetadataCache::stamp(const std::filesystem::path& source) {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(source, ec);
+    if (ec) {
+        return std::unexpected(ec);
+    }
+    const auto mtime = std::filesystem::last_write_time(source, ec);
+    if (ec) {
+        return std::unexpected(ec);
+    }
+    return SourceStamp{size, to_mtime(mtime)};
+}
+
+std::expected<void, std::error_code> MetadataCache::store(const TorrentInfo& info) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory_ / "index", ec);
+    if (ec) {
+        return std::unexpected(ec);
+    }
+
+    SnapshotHeader header{};
+    header.magic = kSnapshotMagic;
+    header.version = kFormatVersion;
+    header.header_size = sizeof(SnapshotHeader);
+    header.info_hash = info.info_hash_;
+    header.piece_length = info.piece_length_;
+    header.total_size = info.total_size_;
+    header.piece_count = static_cast<std::uint32_t>(info.piece_hashes_.size());
+    header.file_count = static_cast<std::uint32_t>(info.files_.size());
+    header.directory_count = static_cast<std::uint32_t>(info.files_.directory_count());
+    header.name_count = static_cast<std::uint32_t>(info.files_.name_count());
+    header.tier_count = static_cast<std::uint32_t>(info.announce_list_.size());
+    header.v2_file_count = static_cast<std::uint32_t>(info.v2_files_.size());
+
+    SnapshotWriter writer;
+    writer.put_bytes(info.piece_hash_bytes());
+    const auto& storage = info.files_;
+    for (std::size_t i = 0; i < storage.size(); ++i) {
+        writer.put(
+            FileRecord{storage.lengths_[i], storage.offsets_[i], storage.file_parents_[i], storage.file_names_[i]}
+        );
+    }
+    for (const auto& directory : storage.directories_) {
+        writer.put(directory);
+    }
+    for (const auto offset : storage.name_offsets_) {
+        writer.put(offset);
+    }
+    for (const auto& tier : info.announce_list_) {
+        writer.put(static_cast<std::uint32_t>(tier.size()));
+        header.url_count += static_cast<std::uint32_t>(tier.size());
+    }
+    for (const auto& tier : info.announce_list_) {
+        for (const auto& url : tier) {
+            writer.put(writer.intern(url));
+        }
+    }
+
+    writer.put(writer.intern(info.name_));
+    writer.put(writer.intern(info.announce_));
+    writer.put(writer.intern(info.comment_.value_or("")));
+    writer.put(writer.intern(info.created_by_.value_or("")));
+    writer.put(writer.intern(storage.names_));
+    if (info.comment_) {
+        header.flags |= kHasComment;
+    }
+    if (info.created_by_) {
+        header.flags |= kHasCreatedBy;
+    }
+    if (info.creation_date_) {
+        header.flags |= kHasCreationDate;
+        header.creation_date =
+            std::chrono::duration_cast<std::chrono::seconds>(info.creation_date_->time_since_epoch()).count();
+    }
+
+    for (const auto& file : info.v2_files_) {
+        writer.put(V2FileRecord{
+            file.length,
+            writer.intern(file.path.string()),
+            file.pieces_root.has_value(),
+            static_cast<std::uint32_t>(file.piece_layer.size()),
+            file.pieces_root.value_or(SHA256Hash{}),
+        });
+    }
+    for (const auto& file : info.v2_files_) {
+        writer.put_bytes(std::as_bytes(std::span(file.piece_layer)));
+    }
+    if (info.info_hash_v2_) {
+        header.flags |= kHasV2;
+        header.info_hash_v2 = *info.info_hash_v2_;
+    }
+
+    return write_atomically(snapshot_path(info.info_hash_), writer.finish(header));
+}
+
+std::expected<void, std::error_code> MetadataCache::store(
+    const TorrentInfo& info, const std::filesystem::path& source, const SourceStamp& read_stamp
+) {
+    if (auto written = store(info); !written) {
+        return written;
+    }
+
+    const auto normalised = normalise(source);
+    const auto current = stamp(normalised);
+    if (!current) {
+        return std::unexpected(current.error());
+    }
+    if (*current != read_stamp) {
+        spdlog::debug("{} changed while it was read; not indexing it", source.string());
+        return {};
+    }
+
+    const std::string path = normalised.string();
+    IndexEntry entry{};
+    entry.magic = kIndexMagic;
+    entry.version = kFormatVersion;
+    entry.path_size = static_cast<std::uint32_t>(path.size());
+    entry.file_size = read_stamp.size;
+    entry.mtime = read_stamp.mtime;
+    entry.info_hash = info.info_hash_;
+    std::string bytes(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    bytes += path;
+    return write_atomically(index_path(normalised), bytes);
+}
+
+}  // namespace bittorrent::core
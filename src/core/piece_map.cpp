@@ -0,0 +1,75 @@
+#include "bittorrent/core/piece_map.hpp"
+#include <algorithm>
+
+namespace bittorrent::core {
+
+PieceMap::PieceMap(const TorrentInfo& info) : piece_length_(info.piece_length()), total_size_(0) {
+    const auto& files = info.files();
+    file_starts_.reserve(files.size() + 1);
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        file_starts_.push_back(total_size_);
+        total_size_ += files.length(i);
+    }
+    file_starts_.push_back(total_size_);
+
+    // One sweep over pieces and files together; empty files are stepped over because the next file starts at the
+    // same offset.
+    const auto last_file = static_cast<std::uint32_t>(files.empty() ? 0 : files.size() - 1);
+    piece_first_file_.reserve(info.piece_count() + 1);
+    std::uint32_t file = 0;
+    for (std::size_t piece = 0; piece < info.piece_count(); ++piece) {
+        const auto start = piece_start(piece);
+        while (file < last_file && file_starts_[file + 1] <= start) {
+            ++file;
+        }
+        piece_first_file_.push_back(file);
+    }
+    piece_first_file_.push_back(last_file);
+}
+
+std::size_t PieceMap::locate(std::int64_t position, std::size_t first, std::size_t last) const noexcept {
+    const auto begin = file_starts_.begin();
+    return static_cast<std::size_t>(std::upper_bound(begin + first, begin + last + 1, position) - begin) - 1;
+}
+
+PieceMap::Range PieceMap::slices(std::size_t piece, std::int64_t offset, std::int64_t length) const noexcept {
+    if (piece >= piece_count() || offset < 0 || offset >= piece_length_ || length <= 0) {
+        return {};
+    }
+
+    const auto start = piece_start(piece) + offset;
+    const auto end = std::min(start + std::min(length, piece_length_ - offset), total_size_);
+    if (start >= end) {
+        return {};
+    }
+
+    const auto file = locate(start, piece_first_file_[piece], piece_first_file_[piece + 1]);
+    return {Iterator(this, file, start, end), Iterator(this, file, end, end)};
+}
+
+std::size_t PieceMap::append_slices(std::span<const std::size_t> pieces, std::vector<FileSlice>& out) const {
+    const auto before = out.size();
+    for (auto piece : pieces) {
+        for (const auto& slice : slices(piece)) {
+            out.push_back(slice);
+        }
+    }
+    return out.size() - before;
+}
+
+FileSlice PieceMap::Iterator::operator*() const noexcept {
+    const auto file_end = map_->file_starts_[file_ + 1];
+    return {file_, position_ - map_->file_starts_[file_], std::min(end_, file_end) - position_};
+}
+
+PieceMap::Iterator& PieceMap::Iterator::operator++() noexcept {
+    position_ = std::min(end_, map_->file_starts_[file_ + 1]);
+    if (position_ < end_) {
+        do {
+            ++file_;
+        } while (map_->file_starts_[file_ + 1] <= position_);
+    }
+    return *this;
+}
+
+}  // namespace bittorrent::core
@@ -0,0 +1,291 @@
+#include "bittorrent/core/recheck.hpp"
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "bittorrent/utils/crypto.hpp"
+
+namespace bittorrent::core {
+
+namespace {
+
+// A run covers about kRunBytes, rounded up to whole groups of eight pieces to keep every SHA-1 lane busy, but each
+// worker buffers a whole run, so it never exceeds kMaxRunBytes: with large pieces the last group is left short.
+constexpr std::int64_t kRunBytes = 4 * 1024 * 1024;
+constexpr std::int64_t kMaxRunBytes = 16 * 1024 * 1024;
+constexpr std::int64_t kPiecesPerLaneGroup = 8;
+
+std::size_t run_pieces_for(std::int64_t piece_length) noexcept {
+    const auto wanted = (kRunBytes + piece_length - 1) / piece_length;
+    const auto grouped = (wanted + kPiecesPerLaneGroup - 1) / kPiecesPerLaneGroup * kPiecesPerLaneGroup;
+    return static_cast<std::size_t>(std::min(grouped, std::max<std::int64_t>(kMaxRunBytes / piece_length, 1)));
+}
+
+// The descriptors one worker has open for its current run of pieces, at most kMaxOpen at a time. The file a run
+// ends in is kept open for the next run, which usually starts in it.
+class FileCache {
+public:
+    static constexpr std::size_t kMaxOpen = 64;
+
+    FileCache(const std::filesystem::path& save_path, const TorrentInfo& info) noexcept
+        : save_path_(save_path), info_(info) {}
+
+    FileCache(const FileCache&) = delete;
+    FileCache& operator=(const FileCache&) = delete;
+
+    ~FileCache() {
+        for (auto& [index, fd] : open_) {
+            close_fd(fd);
+        }
+    }
+
+    // -1 if the file cannot be opened; the failure is remembered for the rest of the run.
+    int get(std::size_t file_index) {
+        for (const auto& [index, fd] : open_) {
+            if (index == file_index) {
+                return fd;
+            }
+        }
+        if (open_.size() == kMaxOpen) {
+            close_fd(open_.front().second);
+            open_.erase(open_.begin());
+        }
+        const auto path = save_path_ / info_.files().path(file_index);
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        } else {
+            spdlog::debug("Cannot open {} for recheck: {}", path.string(), std::strerror(errno));
+        }
+        open_.emplace_back(file_index, fd);
+        return fd;
+    }
+
+    std::size_t open_count() const noexcept { return open_.size(); }
+
+    void end_run(std::size_t last_file) {
+        std::erase_if(open_, [&](const auto& entry) {
+            if (entry.first == last_file) {
+                return false;
+            }
+            close_fd(entry.second);
+            return true;
+        });
+    }
+
+private:
+    static void close_fd(int fd) noexcept {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    const std::filesystem::path& save_path_;
+    const TorrentInfo& info_;
+    std::vector<std::pair<std::size_t, int>> open_;
+};
+
+// Reads `slice` into `out`; false on an error or a file shorter than the torrent says.
+bool read_slice(int fd, const FileSlice& slice, char* out) noexcept {
+    std::int64_t done = 0;
+    while (done < slice.length) {
+        const ssize_t count =
+            ::pread(fd, out + done, static_cast<std::size_t>(slice.length - done), slice.file_offset + done);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        done += count;
+    }
+    return true;
+}
+
+}  // anonymous namespace
+
+RecheckEngine::RecheckEngine(const TorrentInfo& info, std::filesystem::path save_path)
+    : info_(info), map_(info), save_path_(std::move(save_path)) {}
+
+RecheckEngine& RecheckEngine::set_threads(unsigned threads) {
+    threads_ = threads;
+    return *this;
+}
+
+RecheckEngine& RecheckEngine::set_progress_callback(ProgressCallback callback) {
+    on_progress_ = std::move(callback);
+    return *this;
+}
+
+std::expected<Bitfield, std::error_code> RecheckEngine::run(std::stop_token stop) const {
+    const auto piece_count = info_.piece_count();
+    const auto piece_length = info_.piece_length();
+    const auto run_pieces = run_pieces_for(piece_length);
+    const auto run_count = (piece_count + run_pieces - 1) / run_pieces;
+
+    auto threads = threads_ > 0 ? threads_ : std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, std::max<std::size_t>(run_count, 1)));
+
+    // One byte per piece, so workers finishing neighbouring runs never write to the same element.
+    std::vector<std::uint8_t> valid(piece_count, 0);
+    std::atomic<std::size_t> next_run{0};
+    std::mutex progress_mutex;
+    RecheckProgress progress{0, 0, piece_count, 0};
+
+    // A run never holds more than the torrent's data, whatever piece length it declares. Allocated up front, so
+    // running out of memory is an error for the caller rather than std::terminate in a worker thread.
+    struct Buffers {
+        std::vector<char> data;
+        std::vector<std::uint8_t> readable;
+        std::vector<SHA1Hash> digests;
+        std::unique_ptr<bool[]> matches;
+    };
+    const auto buffer_size = static_cast<std::size_t>(
+        std::min<std::int64_t>(static_cast<std::int64_t>(run_pieces) * piece_length, info_.total_size())
+    );
+    std::vector<Buffers> buffers;
+    try {
+        buffers.reserve(threads);
+        for (unsigned i = 0; i < threads; ++i) {
+            buffers.push_back({
+                std::vector<char>(buffer_size),
+                std::vector<std::uint8_t>(run_pieces),
+                std::vector<SHA1Hash>(run_pieces),
+                std::make_unique<bool[]>(run_pieces),
+            });
+        }
+    } catch (const std::bad_alloc&) {
+        spdlog::error("Not enough memory to recheck {} with {} byte pieces", info_.name(), piece_length);
+        return std::unexpected(std::make_error_code(std::errc::not_enough_memory));
+    }
+
+    auto worker = [&](Buffers& own) {
+        struct PendingSlice {
+            FileSlice slice;
+            std::size_t buffer_offset;
+            std::size_t piece;  // within the run
+        };
+
+        FileCache files(save_path_, info_);
+        auto& buffer = own.data;
+        auto& readable = own.readable;
+        auto& digests = own.digests;
+        auto& matches = own.matches;
+        std::vector<PendingSlice> slices;
+        std::vector<std::size_t> indices;
+        std::vector<std::string_view> pieces;
+
+        for (auto run = next_run.fetch_add(1, std::memory_order_relaxed); run < run_count && !stop.stop_requested();
+             run = next_run.fetch_add(1, std::memory_order_relaxed)) {
+            const auto first = run * run_pieces;
+            const auto count = std::min(run_pieces, piece_count - first);
+
+            slices.clear();
+            for (std::size_t i = 0; i < count; ++i) {
+                auto offset = i * static_cast<std::size_t>(piece_length);
+                for (const auto& slice : map_.slices(first + i)) {
+                    slices.push_back({slice, offset, i});
+                    offset += static_cast<std::size_t>(slice.length);
+                }
+            }
+
+            // Queue readahead for the run first, so the kernel fetches the files it touches in parallel. Runs over
+            // many small files only get hints for as many files as can stay open.
+            for (const auto& pending : slices) {
+                if (files.open_count() == FileCache::kMaxOpen) {
+                    break;
+                }
+                if (const int fd = files.get(pending.slice.file_index); fd >= 0) {
+                    ::posix_fadvise(fd, pending.slice.file_offset, pending.slice.length, POSIX_FADV_WILLNEED);
+                }
+            }
+
+            std::fill_n(readable.begin(), count, 1);
+            std::int64_t bytes_read = 0;
+            for (const auto& pending : slices) {
+                if (!readable[pending.piece]) {
+                    continue;
+                }
+                const int fd = files.get(pending.slice.file_index);
+                if (fd < 0 || !read_slice(fd, pending.slice, buffer.data() + pending.buffer_offset)) {
+                    readable[pending.piece] = 0;
+                    continue;
+                }
+                bytes_read += pending.slice.length;
+            }
+            files.end_run(slices.empty() ? info_.files().size() : slices.back().slice.file_index);
+
+            // Pieces that could not be read are invalid without hashing them.
+            indices.clear();
+            pieces.clear();
+            for (std::size_t i = 0; i < count; ++i) {
+                if (readable[i]) {
+                    indices.push_back(first + i);
+                    pieces.emplace_back(
+                        buffer.data() + i * static_cast<std::size_t>(piece_length),
+                        static_cast<std::size_t>(info_.piece_size(first + i))
+                    );
+                }
+            }
+            utils::sha1_batch(pieces, digests);
+            const auto matched = info_.verify_pieces(indices, digests, std::span(matches.get(), indices.size()));
+            for (std::size_t i = 0; i < indices.size(); ++i) {
+                valid[indices[i]] = matches[i];
+            }
+
+            std::lock_guard lock(progress_mutex);
+            progress.pieces_checked += count;
+            progress.pieces_valid += matched;
+            progress.bytes_read += bytes_read;
+            if (on_progress_) {
+                on_progress_(progress);
+            }
+        }
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(threads > 0 ? threads - 1 : 0);
+        for (unsigned i = 1; i < threads; ++i) {
+            workers.emplace_back(worker, std::ref(buffers[i]));
+        }
+        worker(buffers[0]);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    if (progress.pieces_checked < piece_count) {
+        spdlog::info("Recheck of {} cancelled after {} pieces", info_.name(), progress.pieces_checked);
+        return std::unexpected(std::make_error_code(std::errc::operation_canceled));
+    }
+    spdlog::info(
+        "Rechecked {}: {} of {} pieces valid, {} bytes read in {} ms",
+        info_.name(),
+        progress.pieces_valid,
+        piece_count,
+        progress.bytes_read,
+        std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()
+    );
+
+    Bitfield bitfield(piece_count);
+    for (std::size_t i = 0; i < piece_count; ++i) {
+        if (valid[i]) {
+            bitfield.set(i);
+        }
+    }
+    return bitfield;
+}
+
+}  // namespace bittorrent::core
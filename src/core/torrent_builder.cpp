@@ -0,0 +1,372 @@
+#include "bittorrent/core/torrent_builder.hpp"
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <thread>
+#include "bittorrent/bencode.hpp"
+#include "bittorrent/core/types.hpp"
+#include "bittorrent/utils/crypto.hpp"
+
+namespace bittorrent::core {
+
+namespace {
+
+// Reads are issued in chunks of at least this many bytes, rounded up to whole pieces, unless the whole input is
+// smaller. All chunks together stay within kMaxBufferedBytes, however many threads hash them.
+constexpr std::int64_t kMinChunkSize = 8 * 1024 * 1024;
+constexpr std::int64_t kMaxBufferedBytes = 256 * 1024 * 1024;
+
+struct SourceFile {
+    std::filesystem::path path;
+    std::filesystem::path relative;
+    std::int64_t length;
+};
+
+// A run of whole pieces read from disk, starting at `first_piece`. Only the last chunk may end in a partial piece.
+struct Chunk {
+    std::size_t first_piece{0};
+    std::vector<char> data;
+    std::size_t size{0};
+};
+
+// Hands filled chunks from the reader to the hashers and empty ones back. The fixed number of chunks bounds memory
+// and makes the reader wait when hashing falls behind.
+class ChunkQueue {
+public:
+    ChunkQueue(std::size_t count, std::size_t chunk_size) {
+        for (std::size_t i = 0; i < count; ++i) {
+            free_.push_back(Chunk{0, std::vector<char>(chunk_size), 0});
+        }
+    }
+
+    Chunk acquire() {
+        std::unique_lock lock(mutex_);
+        free_ready_.wait(lock, [this] { return !free_.empty(); });
+        auto chunk = std::move(free_.back());
+        free_.pop_back();
+        chunk.size = 0;
+        return chunk;
+    }
+
+    void release(Chunk chunk) {
+        {
+            std::lock_guard lock(mutex_);
+            free_.push_back(std::move(chunk));
+        }
+        free_ready_.notify_one();
+    }
+
+    void push(Chunk chunk) {
+        {
+            std::lock_guard lock(mutex_);
+            filled_.push_back(std::move(chunk));
+        }
+        filled_ready_.notify_one();
+    }
+
+    // Wakes every hasher once the queue drains.
+    void close() {
+        {
+            std::lock_guard lock(mutex_);
+            closed_ = true;
+        }
+        filled_ready_.notify_all();
+    }
+
+    std::optional<Chunk> pop() {
+        std::unique_lock lock(mutex_);
+        filled_ready_.wait(lock, [this] { return closed_ || !filled_.empty(); });
+        if (filled_.empty()) {
+            return std::nullopt;
+        }
+        auto chunk = std::move(filled_.front());
+        filled_.pop_front();
+        return chunk;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable free_ready_;
+    std::condition_variable filled_ready_;
+    std::vector<Chunk> free_;
+    std::deque<Chunk> filled_;
+    bool closed_{false};
+};
+
+std::error_code last_error() noexcept {
+    return {errno, std::generic_category()};
+}
+
+std::expected<std::vector<SourceFile>, std::error_code> collect_files(const std::filesystem::path& root) {
+    std::error_code ec;
+    std::vector<SourceFile> files;
+
+    if (std::filesystem::is_regular_file(root, ec)) {
+        const auto size = std::filesystem::file_size(root, ec);
+        if (ec) {
+            return std::unexpected(ec);
+        }
+        files.push_back({root, root.filename(), static_cast<std::int64_t>(size)});
+        return files;
+    }
+
+    for (std::filesystem::recursive_directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code status_ec;
+        if (!it->is_regular_file(status_ec)) {
+            continue;
+        }
+        const auto size = it->file_size(status_ec);
+        if (status_ec) {
+            return std::unexpected(status_ec);
+        }
+        files.push_back({it->path(), it->path().lexically_relative(root), static_cast<std::int64_t>(size)});
+    }
+    if (ec) {
+        return std::unexpected(ec);
+    }
+    if (files.empty()) {
+        return std::unexpected(std::make_error_code(std::errc::no_such_file_or_directory));
+    }
+
+    std::ranges::sort(files, {}, &SourceFile::relative);
+    return files;
+}
+
+// Fills chunks with the concatenated file contents and queues them for hashing. A file that ends earlier than its
+// listed length means it changed under us, which is reported as an I/O error.
+std::expected<void, std::error_code>
+read_files(std::span<const SourceFile> files, std::int64_t piece_length, ChunkQueue& queue) {
+    auto chunk = queue.acquire();
+    std::size_t next_piece = 0;
+
+    auto flush = [&] {
+        const auto pieces = (chunk.size + static_cast<std::size_t>(piece_length) - 1) / piece_length;
+        chunk.first_piece = next_piece;
+        next_piece += pieces;
+        queue.push(std::move(chunk));
+        chunk = queue.acquire();
+    };
+
+    for (const auto& file : files) {
+        const int fd = ::open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            queue.release(std::move(chunk));
+            return std::unexpected(last_error());
+        }
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+        std::int64_t remaining = file.length;
+        std::error_code error;
+        while (remaining > 0) {
+            const auto want = std::min<std::int64_t>(remaining, chunk.data.size() - chunk.size);
+            const ssize_t count = ::read(fd, chunk.data.data() + chunk.size, static_cast<std::size_t>(want));
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                error = count < 0 ? last_error() : std::make_error_code(std::errc::io_error);
+                break;
+            }
+            chunk.size += static_cast<std::size_t>(count);
+            remaining -= count;
+            if (chunk.size == chunk.data.size()) {
+                flush();
+            }
+        }
+        ::close(fd);
+
+        if (error) {
+            spdlog::error("Failed to read {}: {}", file.path.string(), error.message());
+            queue.release(std::move(chunk));
+            return std::unexpected(error);
+        }
+    }
+
+    if (chunk.size > 0) {
+        flush();
+    }
+    queue.release(std::move(chunk));
+    return {};
+}
+
+void hash_chunks(ChunkQueue& queue, std::int64_t piece_length, std::span<SHA1Hash> digests) {
+    std::vector<std::string_view> pieces;
+    while (auto chunk = queue.pop()) {
+        pieces.clear();
+        for (std::size_t offset = 0; offset < chunk->size; offset += static_cast<std::size_t>(piece_length)) {
+            pieces.emplace_back(
+                chunk->data.data() + offset, std::min<std::size_t>(piece_length, chunk->size - offset)
+            );
+        }
+        utils::sha1_batch(pieces, digests.subspan(chunk->first_piece, pieces.size()));
+        queue.release(std::move(*chunk));
+    }
+}
+
+bencode::Value to_path_list(const std::filesystem::path& relative) {
+    bencode::List components;
+    for (const auto& component : relative) {
+        components.emplace_back(bencode::String{component.string()});
+    }
+    return components;
+}
+
+}  // anonymous namespace
+
+TorrentBuilder::TorrentBuilder(std::filesystem::path root) : root_(std::move(root)) {}
+
+TorrentBuilder& TorrentBuilder::set_piece_length(std::int64_t piece_length) {
+    piece_length_ = piece_length;
+    return *this;
+}
+
+TorrentBuilder& TorrentBuilder::set_announce(std::string url) {
+    announce_ = std::move(url);
+    return *this;
+}
+
+TorrentBuilder& TorrentBuilder::add_announce_tier(std::vector<std::string> urls) {
+    announce_list_.push_back(std::move(urls));
+    return *this;
+}
+
+TorrentBuilder& TorrentBuilder::set_comment(std::string comment) {
+    comment_ = std::move(comment);
+    return *this;
+}
+
+TorrentBuilder& TorrentBuilder::set_created_by(std::string created_by) {
+    created_by_ = std::move(created_by);
+    return *this;
+}
+
+TorrentBuilder& TorrentBuilder::set_creation_date(std::chrono::system_clock::time_point date) {
+    creation_date_ = date;
+    return *this;
+}
+
+TorrentBuilder& TorrentBuilder::set_threads(unsigned threads) {
+    threads_ = threads;
+    return *this;
+}
+
+std::int64_t TorrentBuilder::default_piece_length(std::int64_t total_size) noexcept {
+    constexpr std::int64_t kTargetPieces = 2000;
+    const auto wanted = static_cast<std::uint64_t>(std::max<std::int64_t>(total_size / kTargetPieces, 1));
+    return std::clamp<std::int64_t>(static_cast<std::int64_t>(std::bit_ceil(wanted)), kMinPieceLength, kMaxPieceLength);
+}
+
+bool TorrentBuilder::is_valid_piece_length(std::int64_t piece_length) noexcept {
+    return piece_length >= kMinPieceLength && piece_length <= kMaxPieceLength &&
+           std::has_single_bit(static_cast<std::uint64_t>(piece_length));
+}
+
+std::expected<std::string, std::error_code> TorrentBuilder::build() const {
+    if (piece_length_ != 0 && !is_valid_piece_length(piece_length_)) {
+        spdlog::error("Invalid piece length: {}", piece_length_);
+        return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    }
+
+    auto files = collect_files(root_);
+    if (!files) {
+        spdlog::error("Failed to list {}: {}", root_.string(), files.error().message());
+        return std::unexpected(files.error());
+    }
+
+    std::int64_t total_size = 0;
+    for (const auto& file : *files) {
+        total_size += file.length;
+    }
+    const auto piece_length = piece_length_ > 0 ? piece_length_ : default_piece_length(total_size);
+    const auto piece_count = static_cast<std::size_t>((total_size + piece_length - 1) / piece_length);
+
+    // One chunk per hasher, one being filled and one queued, so no worker waits on a chunk it could be hashing; but
+    // no more than the input fills, nor than the buffer bound allows.
+    const auto chunk_size = std::min(
+        (kMinChunkSize + piece_length - 1) / piece_length * piece_length, std::max<std::int64_t>(total_size, 1)
+    );
+    const std::int64_t wanted_threads = threads_ > 0 ? threads_ : std::max(1u, std::thread::hardware_concurrency());
+    const auto chunk_count = std::min(
+        {wanted_threads + 2, (total_size + chunk_size - 1) / chunk_size + 1, kMaxBufferedBytes / chunk_size}
+    );
+    const auto threads = static_cast<unsigned>(std::clamp<std::int64_t>(chunk_count - 1, 1, wanted_threads));
+    spdlog::info(
+        "Hashing {} files, {} bytes in {} pieces of {} bytes on {} threads",
+        files->size(),
+        total_size,
+        piece_count,
+        piece_length,
+        threads
+    );
+
+    std::vector<SHA1Hash> digests(piece_count);
+    ChunkQueue queue(static_cast<std::size_t>(chunk_count), static_cast<std::size_t>(chunk_size));
+    std::expected<void, std::error_code> read_result;
+    {
+        std::vector<std::jthread> hashers;
+        hashers.reserve(threads);
+        for (unsigned i = 0; i < threads; ++i) {
+            hashers.emplace_back([&] { hash_chunks(queue, piece_length, digests); });
+        }
+        read_result = read_files(*files, piece_length, queue);
+        queue.close();
+    }
+    if (!read_result) {
+        return std::unexpected(read_result.error());
+    }
+
+    bencode::Dictionary info;
+    info["name"] = bencode::String{root_.filename().empty() ? root_.parent_path().filename().string()
+                                                            : root_.filename().string()};
+    info["piece length"] = bencode::Integer{piece_length};
+    info["pieces"] = bencode::String(reinterpret_cast<const char*>(digests.data()), digests.size() * sizeof(SHA1Hash));
+    if (files->size() == 1 && files->front().path == root_) {
+        info["length"] = bencode::Integer{files->front().length};
+    } else {
+        bencode::List entries;
+        entries.reserve(files->size());
+        for (const auto& file : *files) {
+            bencode::Dictionary entry;
+            entry["length"] = bencode::Integer{file.length};
+            entry["path"] = to_path_list(file.relative);
+            entries.emplace_back(std::move(entry));
+        }
+        info["files"] = std::move(entries);
+    }
+
+    bencode::Dictionary root;
+    root["announce"] = bencode::String{announce_};
+    if (!announce_list_.empty()) {
+        bencode::List tiers;
+        for (const auto& tier : announce_list_) {
+            bencode::List urls;
+            for (const auto& url : tier) {
+                urls.emplace_back(bencode::String{url});
+            }
+            tiers.emplace_back(std::move(urls));
+        }
+        root["announce-list"] = std::move(tiers);
+    }
+    if (comment_) {
+        root["comment"] = bencode::String{*comment_};
+    }
+    if (created_by_) {
+        root["created by"] = bencode::String{*created_by_};
+    }
+    if (creation_date_) {
+        root["creation date"] = bencode::Integer{std::chrono::system_clock::to_time_t(*creation_date_)};
+    }
+    root["info"] = std::move(info);
+
+    return bencode::Encoder::encode(bencode::Value{std::move(root)});
+}
+
+}  // namespace bittorrent::core
@@ -1,227 +1,416 @@
 #include "bittorrent/core/torrent_info.hpp"
 #include <spdlog/spdlog.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
 #include <ctime>
-#include <fstream>
 #include <iomanip>
-#include <sstream>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <tuple>
 #include "bittorrent/bencode.hpp"
+#include "bittorrent/core/merkle.hpp"
+#include "bittorrent/core/metadata_cache.hpp"
 #include "bittorrent/utils/crypto.hpp"
+#include "bittorrent/utils/mapped_file.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace bittorrent::core {
 
 namespace {
 
-std::expected<std::string, TorrentError> get_string_field(const bencode::Dictionary& dict, const std::string& key) {
-    auto it = dict.find(key);
-    if (it == dict.end()) {
-        return std::unexpected(TorrentError::MissingRequiredField);
-    }
-    if (!it->second.is_string()) {
-        return std::unexpected(TorrentError::InvalidFieldType);
+struct FileEntry {
+    std::int64_t length{0};
+    std::vector<std::string_view> path;
+};
+
+// The value under the empty key that marks a file in a v2 file tree.
+struct FileTreeLeaf {
+    std::int64_t length{0};
+    std::optional<std::string_view> pieces_root;
+};
+
+struct FileTreeEntry {
+    std::vector<std::string_view> path;
+    FileTreeLeaf leaf;
+};
+
+struct InfoFields {
+    std::optional<std::vector<FileTreeEntry>> file_tree;
+    std::optional<std::vector<FileEntry>> files;
+    std::optional<std::int64_t> length;
+    std::optional<std::int64_t> meta_version;
+    std::string_view name;
+    std::int64_t piece_length{0};
+    std::string_view pieces;
+};
+
+// Concatenated piece hashes keyed by the pieces root of their file, in key order.
+using PieceLayers = std::vector<std::pair<std::string_view, std::string_view>>;
+
+struct MetainfoFields {
+    std::string_view announce;
+    std::vector<std::vector<std::string>> announce_list;
+    std::optional<std::string_view> comment;
+    std::optional<std::string_view> created_by;
+    std::optional<std::int64_t> creation_date;
+    bencode::Encoded<InfoFields> info;
+    PieceLayers piece_layers;
+};
+
+}  // anonymous namespace
+
+}  // namespace bittorrent::core
+
+// Needed by the file tree decoder below; the other schemas follow the decoders they use.
+template <>
+struct bittorrent::bencode::Schema<bittorrent::core::FileTreeLeaf> {
+    using Leaf = core::FileTreeLeaf;
+
+    static constexpr auto fields = std::tuple{
+        required_field("length", &Leaf::length),
+        field("pieces root", &Leaf::pieces_root),
+    };
+};
+
+namespace bittorrent::core {
+
+namespace {
+
+// Keeps the string URLs of every list tier and drops anything else, including tiers left empty.
+std::expected<void, bencode::DecodeError>
+decode_announce_list(bencode::Reader& reader, std::vector<std::vector<std::string>>& announce_list) {
+    auto is_type = [&reader](bencode::TokenType type) {
+        auto next = reader.peek();
+        return next && *next == type;
+    };
+
+    if (!is_type(bencode::TokenType::List)) {
+        return reader.skip();
     }
-    return it->second.as_string();
+
+    return reader.read_list([&]() -> std::expected<void, bencode::DecodeError> {
+        if (!is_type(bencode::TokenType::List)) {
+            return reader.skip();
+        }
+
+        std::vector<std::string> tier;
+        auto result = reader.read_list([&]() -> std::expected<void, bencode::DecodeError> {
+            if (!is_type(bencode::TokenType::String)) {
+                return reader.skip();
+            }
+            auto url = reader.read_string();
+            if (!url) {
+                return std::unexpected(url.error());
+            }
+            tier.emplace_back(*url);
+            return {};
+        });
+
+        if (result && !tier.empty()) {
+            announce_list.push_back(std::move(tier));
+        }
+        return result;
+    });
 }
 
-std::expected<std::int64_t, TorrentError> get_integer_field(const bencode::Dictionary& dict, const std::string& key) {
-    auto it = dict.find(key);
-    if (it == dict.end()) {
-        return std::unexpected(TorrentError::MissingRequiredField);
-    }
-    if (!it->second.is_integer()) {
-        return std::unexpected(TorrentError::InvalidFieldType);
+// Flattens one directory of a v2 file tree into `files`. A dictionary whose only key is empty is a file; a file may not
+// sit at the root or share its node with a directory.
+std::expected<void, bencode::DecodeError>
+decode_file_tree_node(bencode::Reader& reader, std::vector<std::string_view>& path, std::vector<FileTreeEntry>& files) {
+    bool has_file = false;
+    bool has_children = false;
+    return reader.read_dictionary([&](std::string_view key) -> std::expected<void, bencode::DecodeError> {
+        const bool misplaced = key.empty() ? path.empty() || has_children : has_file;
+        if (misplaced) {
+            return std::unexpected(bencode::DecodeError{bencode::DecodeError::Kind::InvalidValue, reader.position()});
+        }
+        if (key.empty()) {
+            has_file = true;
+            auto& entry = files.emplace_back(path, FileTreeLeaf{});
+            return bencode::Decoder<FileTreeLeaf>::decode(reader, entry.leaf);
+        }
+        has_children = true;
+        path.push_back(key);
+        auto result = decode_file_tree_node(reader, path, files);
+        path.pop_back();
+        return result;
+    });
+}
+
+std::expected<void, bencode::DecodeError>
+decode_file_tree(bencode::Reader& reader, std::optional<std::vector<FileTreeEntry>>& files) {
+    std::vector<std::string_view> path;
+    auto& entries = files.emplace();
+    return decode_file_tree_node(reader, path, entries);
+}
+
+std::expected<void, bencode::DecodeError> decode_piece_layers(bencode::Reader& reader, PieceLayers& layers) {
+    return reader.read_dictionary([&](std::string_view key) -> std::expected<void, bencode::DecodeError> {
+        auto hashes = reader.read_string();
+        if (!hashes) {
+            return std::unexpected(hashes.error());
+        }
+        layers.emplace_back(key, *hashes);
+        return {};
+    });
+}
+
+TorrentError to_torrent_error(const bencode::DecodeError& error) {
+    switch (error.kind) {
+        case bencode::DecodeError::Kind::Syntax:
+            return TorrentError::InvalidFormat;
+        case bencode::DecodeError::Kind::TypeMismatch:
+            return error.field.empty() ? TorrentError::InvalidFormat : TorrentError::InvalidFieldType;
+        case bencode::DecodeError::Kind::MissingField:
+            return TorrentError::MissingRequiredField;
+        case bencode::DecodeError::Kind::InvalidValue:
+            return TorrentError::InvalidFieldType;
     }
-    return it->second.as_integer();
+    return TorrentError::InvalidFormat;
 }
 
-std::expected<std::vector<SHA1Hash>, TorrentError> parse_piece_hashes(const std::string& pieces_str) {
+std::expected<std::vector<SHA1Hash>, TorrentError> parse_piece_hashes(std::string_view pieces_str) {
     if (pieces_str.size() % 20 != 0) {
         return std::unexpected(TorrentError::InvalidPieceHash);
     }
 
-    std::vector<SHA1Hash> hashes;
-    hashes.reserve(pieces_str.size() / 20);
-
-    for (std::size_t i = 0; i < pieces_str.size(); i += 20) {
-        SHA1Hash hash;
-        for (std::size_t j = 0; j < 20; ++j) {
-            hash[j] = static_cast<std::byte>(static_cast<unsigned char>(pieces_str[i + j]));
-        }
-        hashes.push_back(hash);
+    // SHA1Hash has no padding, so the whole string is copied into the vector's storage at once.
+    std::vector<SHA1Hash> hashes(pieces_str.size() / 20);
+    if (!hashes.empty()) {
+        std::memcpy(hashes.data(), pieces_str.data(), pieces_str.size());
     }
-
     return hashes;
 }
 
-std::expected<std::vector<FileInfo>, TorrentError>
-parse_files(const bencode::Dictionary& info_dict, const std::string& name) {
-    std::vector<FileInfo> files;
+// One unaligned 16-byte vector compare plus a 4-byte tail, with no early exit.
+bool digest_equal(const SHA1Hash& lhs, const SHA1Hash& rhs) noexcept {
+#if defined(__SSE2__)
+    const __m128i head = _mm_cmpeq_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs.data())),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs.data()))
+    );
+    std::uint32_t lhs_tail;
+    std::uint32_t rhs_tail;
+    std::memcpy(&lhs_tail, lhs.data() + 16, sizeof(lhs_tail));
+    std::memcpy(&rhs_tail, rhs.data() + 16, sizeof(rhs_tail));
+    return (_mm_movemask_epi8(head) == 0xFFFF) & (lhs_tail == rhs_tail);
+#else
+    return std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0;
+#endif
+}
 
-    auto length_it = info_dict.find("length");
-    if (length_it != info_dict.end()) {
-        if (!length_it->second.is_integer()) {
-            return std::unexpected(TorrentError::InvalidFieldType);
-        }
-        files.emplace_back(name, length_it->second.as_integer());
-        return files;
+std::expected<FileStorage, TorrentError> build_files(const InfoFields& info, const std::string& name) {
+    FileStorage::Builder files;
+
+    if (info.length) {
+        const std::string_view component = name;
+        files.add_file(std::span(&component, 1), *info.length);
+        return files.finish();
     }
 
     // Multi-file torrent
-    auto files_it = info_dict.find("files");
-    if (files_it == info_dict.end() || !files_it->second.is_list()) {
+    if (!info.files) {
         return std::unexpected(TorrentError::MissingRequiredField);
     }
 
-    const auto& files_list = files_it->second.as_list();
-    std::int64_t offset = 0;
+    // Every path starts with the torrent name, which the storage keeps once like any other directory.
+    files.reserve(info.files->size());
+    std::vector<std::string_view> components;
+    for (const auto& entry : *info.files) {
+        components.assign(1, name);
+        components.insert(components.end(), entry.path.begin(), entry.path.end());
+        files.add_file(components, entry.length);
+    }
 
-    for (const auto& file_value : files_list) {
-        if (!file_value.is_dictionary()) {
-            return std::unexpected(TorrentError::InvalidFieldType);
-        }
+    return files.finish();
+}
 
-        const auto& file_dict = file_value.as_dictionary();
+std::optional<SHA256Hash> to_sha256(std::string_view bytes) noexcept {
+    SHA256Hash hash;
+    if (bytes.size() != hash.size()) {
+        return std::nullopt;
+    }
+    std::memcpy(hash.data(), bytes.data(), hash.size());
+    return hash;
+}
 
-        auto length = get_integer_field(file_dict, "length");
-        if (!length) {
-            return std::unexpected(length.error());
+// Files of the v2 tree, with their piece layers checked against their roots. v2 needs power-of-two pieces of at
+// least one block. Piece layers may be absent, as in metadata fetched from peers; one that is present must hash up
+// to its file's root.
+std::expected<std::vector<V2FileInfo>, TorrentError>
+build_v2_files(const InfoFields& info, const PieceLayers& piece_layers, const std::string& name) {
+    if (!info.file_tree) {
+        return std::unexpected(TorrentError::MissingRequiredField);
+    }
+    if (info.piece_length < MerkleTree::kBlockSize ||
+        !std::has_single_bit(static_cast<std::uint64_t>(info.piece_length))) {
+        return std::unexpected(TorrentError::InvalidPieceLength);
+    }
+    const auto blocks_per_piece = static_cast<std::size_t>(info.piece_length / MerkleTree::kBlockSize);
+    const auto piece_pad = MerkleTree::pad_hash(blocks_per_piece);
+
+    // A lone top-level file is the whole torrent and, as in v1, is named by its key alone.
+    const bool single_file = info.file_tree->size() == 1 && info.file_tree->front().path.size() == 1;
+
+    std::vector<V2FileInfo> files;
+    files.reserve(info.file_tree->size());
+    for (const auto& entry : *info.file_tree) {
+        std::filesystem::path file_path = single_file ? std::filesystem::path() : std::filesystem::path(name);
+        for (auto component : entry.path) {
+            file_path /= component;
         }
 
-        auto path_it = file_dict.find("path");
-        if (path_it == file_dict.end() || !path_it->second.is_list()) {
-            return std::unexpected(TorrentError::MissingRequiredField);
+        V2FileInfo file{std::move(file_path), entry.leaf.length, std::nullopt, {}};
+        if (file.length < 0) {
+            return std::unexpected(TorrentError::InvalidFileTree);
+        }
+        if (file.length == 0) {
+            files.push_back(std::move(file));
+            continue;
+        }
+        if (!entry.leaf.pieces_root || !(file.pieces_root = to_sha256(*entry.leaf.pieces_root))) {
+            return std::unexpected(TorrentError::InvalidFileTree);
         }
 
-        const auto& path_list = path_it->second.as_list();
-        std::filesystem::path file_path = name;
-
-        for (const auto& component : path_list) {
-            if (!component.is_string()) {
-                return std::unexpected(TorrentError::InvalidFieldType);
+        if (file.length > info.piece_length) {
+            const auto layer = std::ranges::lower_bound(
+                piece_layers, *entry.leaf.pieces_root, {}, [](const auto& item) { return item.first; }
+            );
+            if (layer != piece_layers.end() && layer->first == *entry.leaf.pieces_root) {
+                const auto piece_count =
+                    static_cast<std::size_t>((file.length + info.piece_length - 1) / info.piece_length);
+                if (layer->second.size() != piece_count * sizeof(SHA256Hash)) {
+                    return std::unexpected(TorrentError::InvalidPieceLayer);
+                }
+                file.piece_layer.resize(piece_count);
+                std::memcpy(file.piece_layer.data(), layer->second.data(), layer->second.size());
+
+                const auto width = std::bit_ceil(MerkleTree::block_count(file.length)) / blocks_per_piece;
+                if (MerkleTree::root_of(file.piece_layer, width, piece_pad) != *file.pieces_root) {
+                    return std::unexpected(TorrentError::InvalidPieceLayer);
+                }
+            } else {
+                spdlog::debug("No piece layer for {}", file.path.string());
             }
-            file_path /= component.as_string();
         }
-
-        FileInfo file_info(file_path, *length);
-        file_info.offset = offset;
-        offset += *length;
-
-        files.push_back(std::move(file_info));
+        files.push_back(std::move(file));
     }
-
     return files;
 }
 
-std::vector<std::vector<std::string>> parse_announce_list(const bencode::Dictionary& root) {
-    std::vector<std::vector<std::string>> announce_list;
-
-    auto it = root.find("announce-list");
-    if (it == root.end() || !it->second.is_list()) {
-        return announce_list;
-    }
+}  // anonymous namespace
 
-    const auto& outer_list = it->second.as_list();
-    for (const auto& inner_value : outer_list) {
-        if (!inner_value.is_list()) {
-            continue;
-        }
+}  // namespace bittorrent::core
 
-        std::vector<std::string> tier;
-        const auto& inner_list = inner_value.as_list();
-        for (const auto& url_value : inner_list) {
-            if (url_value.is_string()) {
-                tier.push_back(url_value.as_string());
-            }
-        }
+template <>
+struct bittorrent::bencode::Schema<bittorrent::core::FileEntry> {
+    using Entry = core::FileEntry;
+
+    static constexpr auto fields = std::tuple{
+        required_field("length", &Entry::length),
+        required_field("path", &Entry::path),
+    };
+};
+
+template <>
+struct bittorrent::bencode::Schema<bittorrent::core::InfoFields> {
+    using Info = core::InfoFields;
+
+    // A missing "piece length" keeps its zero default and is reported as InvalidPieceLength.
+    static constexpr auto fields = std::tuple{
+        field("file tree", &Info::file_tree, &core::decode_file_tree),
+        field("files", &Info::files),
+        field("length", &Info::length),
+        field("meta version", &Info::meta_version),
+        required_field("name", &Info::name),
+        field("piece length", &Info::piece_length),
+        required_field("pieces", &Info::pieces),
+    };
+};
+
+template <>
+struct bittorrent::bencode::Schema<bittorrent::core::MetainfoFields> {
+    using Metainfo = core::MetainfoFields;
+
+    static constexpr auto fields = std::tuple{
+        required_field("announce", &Metainfo::announce),
+        field("announce-list", &Metainfo::announce_list, &core::decode_announce_list),
+        field("comment", &Metainfo::comment, &bencode::decode_lenient<std::optional<std::string_view>>),
+        field("created by", &Metainfo::created_by, &bencode::decode_lenient<std::optional<std::string_view>>),
+        field("creation date", &Metainfo::creation_date, &bencode::decode_lenient<std::optional<std::int64_t>>),
+        required_field("info", &Metainfo::info),
+        field("piece layers", &Metainfo::piece_layers, &core::decode_piece_layers),
+    };
+};
 
-        if (!tier.empty()) {
-            announce_list.push_back(std::move(tier));
-        }
-    }
+namespace bittorrent::core {
 
-    return announce_list;
+std::expected<TorrentInfo, TorrentError> TorrentInfo::from_bencode(const bencode::Value& value) {
+    return from_bytes(bencode::Encoder::encode(value));
 }
 
-}  // anonymous namespace
+std::expected<TorrentInfo, TorrentError> TorrentInfo::from_bencode(const bencode::ValueView& value) {
+    return from_bytes(bencode::Encoder::encode(value));
+}
 
-std::expected<TorrentInfo, TorrentError> TorrentInfo::from_bencode(const bencode::Value& value) {
-    spdlog::debug("Starting torrent parsing from bencode value");
+std::expected<TorrentInfo, TorrentError> TorrentInfo::from_bytes(std::string_view data) {
+    spdlog::debug("Decoding {} bytes of torrent metainfo", data.size());
 
-    if (!value.is_dictionary()) {
-        spdlog::error("Torrent root is not a dictionary");
-        return std::unexpected(TorrentError::InvalidFormat);
+    MetainfoFields metainfo;
+    if (auto decoded = bencode::decode(data, metainfo); !decoded) {
+        spdlog::error("Failed to decode torrent: {}", bencode::to_string(decoded.error()));
+        return std::unexpected(to_torrent_error(decoded.error()));
     }
 
-    const auto& root = value.as_dictionary();
+    const InfoFields& info_fields = metainfo.info.value;
     TorrentInfo info;
 
-    spdlog::debug("Parsing announce URL");
-    auto announce = get_string_field(root, "announce");
-    if (!announce) {
-        spdlog::error("Failed to parse announce URL");
-        return std::unexpected(announce.error());
-    }
-    info.announce_ = *announce;
-    spdlog::info("Tracker: {}", info.announce_);
+    info.announce_ = metainfo.announce;
+    spdlog::debug("Tracker: {}", info.announce_);
 
-    info.announce_list_ = parse_announce_list(root);
+    info.announce_list_ = std::move(metainfo.announce_list);
     if (!info.announce_list_.empty()) {
         spdlog::debug("Found {} announce tiers", info.announce_list_.size());
     }
 
-    if (auto it = root.find("comment"); it != root.end() && it->second.is_string()) {
-        info.comment_ = it->second.as_string();
+    if (metainfo.comment) {
+        info.comment_ = std::string(*metainfo.comment);
     }
 
-    if (auto it = root.find("created by"); it != root.end() && it->second.is_string()) {
-        info.created_by_ = it->second.as_string();
+    if (metainfo.created_by) {
+        info.created_by_ = std::string(*metainfo.created_by);
     }
 
-    if (auto it = root.find("creation date"); it != root.end() && it->second.is_integer()) {
-        auto timestamp = it->second.as_integer();
-        info.creation_date_ = std::chrono::system_clock::from_time_t(timestamp);
+    if (metainfo.creation_date) {
+        info.creation_date_ = std::chrono::system_clock::from_time_t(*metainfo.creation_date);
     }
 
-    spdlog::debug("Parsing info dictionary");
-    auto info_it = root.find("info");
-    if (info_it == root.end() || !info_it->second.is_dictionary()) {
-        spdlog::error("Missing or invalid info dictionary");
-        return std::unexpected(TorrentError::MissingRequiredField);
-    }
-
-    const auto& info_dict = info_it->second.as_dictionary();
-    auto name = get_string_field(info_dict, "name");
-    if (!name) {
-        spdlog::error("Failed to parse torrent name");
-        return std::unexpected(name.error());
-    }
-    info.name_ = *name;
-    spdlog::info("Torrent name: {}", info.name_);
+    info.name_ = info_fields.name;
+    spdlog::debug("Torrent name: {}", info.name_);
 
-    auto piece_length = get_integer_field(info_dict, "piece length");
-    if (!piece_length || *piece_length <= 0) {
+    if (info_fields.piece_length <= 0) {
         spdlog::error("Invalid piece length");
         return std::unexpected(TorrentError::InvalidPieceLength);
     }
-    info.piece_length_ = *piece_length;
+    info.piece_length_ = info_fields.piece_length;
     spdlog::debug("Piece length: {} bytes ({} KB)", info.piece_length_, info.piece_length_ / 1024);
 
-    spdlog::debug("Parsing piece hashes");
-    auto pieces = get_string_field(info_dict, "pieces");
-    if (!pieces) {
-        spdlog::error("Failed to parse pieces field");
-        return std::unexpected(pieces.error());
-    }
-
-    auto piece_hashes = parse_piece_hashes(*pieces);
+    auto piece_hashes = parse_piece_hashes(info_fields.pieces);
     if (!piece_hashes) {
         spdlog::error("Failed to parse piece hashes");
         return std::unexpected(piece_hashes.error());
     }
     info.piece_hashes_ = std::move(*piece_hashes);
-    spdlog::info("Number of pieces: {}", info.piece_hashes_.size());
+    spdlog::debug("Number of pieces: {}", info.piece_hashes_.size());
 
-    spdlog::debug("Parsing file information");
-    auto files = parse_files(info_dict, info.name_);
+    auto files = build_files(info_fields, info.name_);
     if (!files) {
         spdlog::error("Failed to parse files");
         return std::unexpected(files.error());
@@ -229,16 +418,16 @@ std::expected<TorrentInfo, TorrentError> TorrentInfo::from_bencode(const bencode
     info.files_ = std::move(*files);
 
     info.total_size_ = 0;
-    for (const auto& file : info.files_) {
-        info.total_size_ += file.length;
+    for (std::size_t i = 0; i < info.files_.size(); ++i) {
+        info.total_size_ += info.files_.length(i);
     }
 
     if (info.is_single_file()) {
-        spdlog::info(
+        spdlog::debug(
             "Single file torrent, size: {} bytes ({:.2f} MB)", info.total_size_, info.total_size_ / (1024.0 * 1024.0)
         );
     } else {
-        spdlog::info(
+        spdlog::debug(
             "Multi-file torrent with {} files, total size: {} bytes ({:.2f} GB)",
             info.files_.size(),
             info.total_size_,
@@ -246,36 +435,121 @@ std::expected<TorrentInfo, TorrentError> TorrentInfo::from_bencode(const bencode
         );
     }
 
-    info.info_dict_bencoded_ = bencode::Encoder::encode(info_it->second);
-    info.info_hash_ = utils::sha1(info.info_dict_bencoded_);
+    // The info hash covers the info dictionary exactly as it appears in the file, canonical or not.
+    info.info_hash_ = utils::sha1(metainfo.info.bytes);
     spdlog::debug("Calculated info_hash: {}", to_hex_string(info.info_hash_));
-    spdlog::info("Successfully parsed torrent");
+
+    if (info_fields.meta_version) {
+        if (*info_fields.meta_version != 2) {
+            spdlog::error("Unsupported meta version {}", *info_fields.meta_version);
+            return std::unexpected(TorrentError::InvalidFormat);
+        }
+        auto v2_files = build_v2_files(info_fields, metainfo.piece_layers, info.name_);
+        if (!v2_files) {
+            spdlog::error("Failed to parse v2 file tree: {}", to_string(v2_files.error()));
+            return std::unexpected(v2_files.error());
+        }
+        info.v2_files_ = std::move(*v2_files);
+        info.info_hash_v2_ = utils::sha256(metainfo.info.bytes);
+        spdlog::debug("Calculated v2 info_hash: {}", to_hex_string(*info.info_hash_v2_));
+    }
+    spdlog::debug("Successfully parsed torrent");
 
     return info;
 }
 
 std::expected<TorrentInfo, TorrentError> TorrentInfo::from_file(const std::filesystem::path& path) {
-    spdlog::info("Loading torrent file: {}", path.string());
+    spdlog::debug("Loading torrent file: {}", path.string());
 
-    std::ifstream file(path, std::ios::binary);
+    auto file = utils::MappedFile::open(path);
     if (!file) {
-        spdlog::error("Failed to open torrent file: {}", path.string());
+        spdlog::error("Failed to open torrent file: {}: {}", path.string(), file.error().message());
         return std::unexpected(TorrentError::InvalidFormat);
     }
+    spdlog::debug("{} {} bytes from torrent file", file->is_mapped() ? "Mapped" : "Read", file->size());
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string content = buffer.str();
-    spdlog::debug("Read {} bytes from torrent file", content.size());
+    return from_bytes(file->view());
+}
 
-    spdlog::debug("Parsing bencode data");
-    auto parse_result = bencode::Parser::parse(content);
-    if (!parse_result) {
-        spdlog::error("Failed to parse bencode data: {}", to_string(parse_result.error()));
-        return std::unexpected(TorrentError::InvalidFormat);
+std::expected<TorrentInfo, TorrentError>
+TorrentInfo::from_file(const std::filesystem::path& path, MetadataCache& cache) {
+    if (auto cached = cache.lookup(path)) {
+        spdlog::debug("Loaded {} from metadata cache", path.string());
+        return std::move(*cached);
+    }
+
+    // Stamped before reading, so a rewrite while it is parsed is not indexed under the new file's stamp.
+    const auto stamp = MetadataCache::stamp(path);
+    auto info = from_file(path);
+    if (info && stamp) {
+        if (auto stored = cache.store(*info, path, *stamp); !stored) {
+            spdlog::warn("Failed to cache metadata for {}: {}", path.string(), stored.error().message());
+        }
     }
+    return info;
+}
+
+void TorrentInfo::load_files(
+    std::span<const std::filesystem::path> paths,
+    const LoadCallback& on_loaded,
+    unsigned threads,
+    MetadataCache* cache
+) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, paths.size()));
+
+    // Workers claim files one at a time, so a few large torrents cannot leave the other threads idle.
+    std::atomic<std::size_t> next{0};
+    std::mutex callback_mutex;
+    auto worker = [&] {
+        for (auto i = next.fetch_add(1, std::memory_order_relaxed); i < paths.size();
+             i = next.fetch_add(1, std::memory_order_relaxed)) {
+            auto result = cache ? from_file(paths[i], *cache) : from_file(paths[i]);
+            std::lock_guard lock(callback_mutex);
+            on_loaded(paths[i], std::move(result));
+        }
+    };
+
+    std::vector<std::jthread> workers;
+    workers.reserve(threads > 0 ? threads - 1 : 0);
+    for (unsigned i = 1; i < threads; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+}
 
-    return from_bencode(*parse_result);
+std::expected<std::size_t, std::error_code> TorrentInfo::load_directory(
+    const std::filesystem::path& directory,
+    const LoadCallback& on_loaded,
+    unsigned threads,
+    MetadataCache* cache
+) {
+    std::vector<std::filesystem::path> paths;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code status_ec;
+        if (it->path().extension() == ".torrent" && it->is_regular_file(status_ec)) {
+            paths.push_back(it->path());
+        }
+    }
+    if (ec) {
+        spdlog::error("Failed to list torrent directory {}: {}", directory.string(), ec.message());
+        return std::unexpected(ec);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    load_files(paths, on_loaded, threads, cache);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    spdlog::info(
+        "Loaded {} torrent files from {} in {} ms",
+        paths.size(),
+        directory.string(),
+        std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()
+    );
+
+    return paths.size();
 }
 
 std::int64_t TorrentInfo::piece_size(std::size_t piece_index) const noexcept {
@@ -295,7 +569,70 @@ bool TorrentInfo::verify_piece_hash(std::size_t piece_index, const SHA1Hash& has
     if (piece_index >= piece_hashes_.size()) {
         return false;
     }
-    return piece_hashes_[piece_index] == hash;
+    return digest_equal(piece_hashes_[piece_index], hash);
+}
+
+std::size_t TorrentInfo::verify_pieces(
+    std::span<const std::size_t> piece_indices,
+    std::span<const SHA1Hash> hashes,
+    std::span<bool> matches
+) const noexcept {
+    const auto count = std::min({piece_indices.size(), hashes.size(), matches.size()});
+    std::size_t matched = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto index = piece_indices[i];
+        matches[i] = index < piece_hashes_.size() && digest_equal(piece_hashes_[index], hashes[i]);
+        matched += matches[i];
+    }
+    return matched;
+}
+
+bool TorrentInfo::verify_v2_piece(
+    std::size_t file_index,
+    std::size_t piece,
+    std::span<const SHA256Hash> block_hashes
+) const {
+    if (file_index >= v2_files_.size() || !v2_files_[file_index].pieces_root) {
+        return false;
+    }
+    const auto& file = v2_files_[file_index];
+    const auto blocks_per_piece = static_cast<std::size_t>(piece_length_ / MerkleTree::kBlockSize);
+    const auto file_blocks = MerkleTree::block_count(file.length);
+    if (piece >= (file_blocks + blocks_per_piece - 1) / blocks_per_piece ||
+        block_hashes.size() != std::min(blocks_per_piece, file_blocks - piece * blocks_per_piece)) {
+        return false;
+    }
+
+    if (file_blocks <= blocks_per_piece) {
+        return MerkleTree::root_of(block_hashes, std::bit_ceil(file_blocks)) == *file.pieces_root;
+    }
+    return !file.piece_layer.empty() && MerkleTree::root_of(block_hashes, blocks_per_piece) == file.piece_layer[piece];
+}
+
+bool TorrentInfo::verify_v2_block(
+    std::size_t file_index,
+    std::size_t block,
+    const SHA256Hash& block_hash,
+    std::span<const SHA256Hash> proof
+) const {
+    if (file_index >= v2_files_.size() || !v2_files_[file_index].pieces_root) {
+        return false;
+    }
+    const auto& file = v2_files_[file_index];
+    const auto file_blocks = MerkleTree::block_count(file.length);
+    if (block >= file_blocks) {
+        return false;
+    }
+
+    const auto tree_depth = static_cast<std::size_t>(std::countr_zero(std::bit_ceil(file_blocks)));
+    const auto piece_depth = static_cast<std::size_t>(std::countr_zero(
+        static_cast<std::uint64_t>(piece_length_ / MerkleTree::kBlockSize)
+    ));
+    const auto node = MerkleTree::root_from_proof(block_hash, block, proof);
+    if (proof.size() == tree_depth) {
+        return node == *file.pieces_root;
+    }
+    return proof.size() == piece_depth && !file.piece_layer.empty() && node == file.piece_layer[block >> piece_depth];
 }
 
 }  // namespace bittorrent::core
@@ -4,15 +4,27 @@
 
 namespace bittorrent::core {
 
-std::string to_hex_string(const SHA1Hash& hash) {
+namespace {
+
+std::string to_hex(std::span<const std::byte> bytes) {
     std::ostringstream oss;
     oss << std::hex << std::setfill('0');
-    for (const auto byte : hash) {
+    for (const auto byte : bytes) {
         oss << std::setw(2) << static_cast<unsigned int>(static_cast<std::uint8_t>(byte));
     }
     return oss.str();
 }
 
+}  // anonymous namespace
+
+std::string to_hex_string(const SHA1Hash& hash) {
+    return to_hex(hash);
+}
+
+std::string to_hex_string(const SHA256Hash& hash) {
+    return to_hex(hash);
+}
+
 std::expected<SHA1Hash, std::string> from_hex_string(std::string_view hex) {
     if (hex.size() != 40) {
         return std::unexpected("Invalid hex string length (expected 40 characters)");
@@ -30,7 +30,7 @@ core::PeerID generate_peer_id() {
     return peer_id;
 }
 
-asio::awaitable<void> run_client() {
+asio::awaitable<void> run_client(network::HttpTracker& http_tracker, network::UdpTracker& udp_tracker) {
     spdlog::info("BitTorrent Client starting...");
 
     auto torrent =
@@ -47,14 +47,10 @@ asio::awaitable<void> run_client() {
     auto peer_id = generate_peer_id();
     spdlog::info("Generated peer ID: {}", core::to_hex_string(peer_id));
 
-    auto executor = co_await asio::this_coro::executor;
-    auto& io_context = static_cast<boost::asio::io_context&>(executor.context());
-    network::HttpTracker tracker(io_context);
+    network::TrackerManager trackers(http_tracker, udp_tracker, network::TrackerManager::tiers_of(*torrent));
+    spdlog::info("Announcing to {} tracker tier(s)", trackers.tiers().size());
 
-    spdlog::info("Announcing to tracker: {}", torrent->announce());
-
-    auto response = co_await tracker.announce(
-        torrent->announce(),
+    auto response = co_await trackers.announce(
         torrent->info_hash(),
         peer_id,
         /* port */ 6881,
@@ -88,8 +84,15 @@ int main() {
 
     try {
         asio::io_context io_context;
-
-        asio::co_spawn(io_context, run_client(), [](std::exception_ptr e) {
+        network::HttpTracker http_tracker(io_context);
+        network::UdpTracker udp_tracker(io_context);
+
+        // The client is done when run_client is. Announces to slower trackers may still be running, and a dead
+        // udp:// tracker is retried for about two hours, so shut the trackers down: those announces fail at once and
+        // run() returns once they have, with every coroutine finished while the trackers still exist.
+        auto on_done = [&http_tracker, &udp_tracker](std::exception_ptr e) {
+            http_tracker.shutdown();
+            udp_tracker.shutdown();
             if (!e) {
                 return;
             }
@@ -98,7 +101,8 @@ int main() {
             } catch (const std::exception& ex) {
                 spdlog::error("Exception in client: {}", ex.what());
             }
-        });
+        };
+        asio::co_spawn(io_context, run_client(http_tracker, udp_tracker), on_done);
 
         io_context.run();
 
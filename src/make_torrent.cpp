@@ -0,0 +1,133 @@
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <string_view>
+#include "bittorrent/core.hpp"
+
+using namespace bittorrent;
+
+namespace {
+
+// More hashing threads than this only adds contention; a larger -j is almost certainly a typo.
+constexpr unsigned kMaxThreads = 256;
+
+void print_usage(const char* program) {
+    spdlog::info(
+        "Usage: {} <file or directory> -o <output.torrent> [-a <announce url>]... [-p <piece length>] "
+        "[-c <comment>] [-j <threads>]",
+        program
+    );
+}
+
+template <typename T>
+std::optional<T> parse_number(std::string_view text) {
+    T value{};
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc{} || ptr != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+}  // anonymous namespace
+
+// Each -a adds a tracker: the first becomes `announce`, and with more than one every URL gets its own tier.
+int main(int argc, char** argv) {
+    auto console = spdlog::stdout_color_mt("console");
+    spdlog::set_default_logger(console);
+    spdlog::set_pattern("[%^%l%$] %v");
+
+    std::optional<std::filesystem::path> source;
+    std::optional<std::filesystem::path> output;
+    std::vector<std::string> trackers;
+    std::int64_t piece_length = 0;
+    unsigned threads = 0;
+    std::optional<std::string> comment;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "-o" && has_value) {
+            output = argv[++i];
+        } else if (arg == "-a" && has_value) {
+            trackers.emplace_back(argv[++i]);
+        } else if (arg == "-c" && has_value) {
+            comment = argv[++i];
+        } else if (arg == "-p" && has_value) {
+            auto value = parse_number<std::int64_t>(argv[++i]);
+            if (!value || !core::TorrentBuilder::is_valid_piece_length(*value)) {
+                spdlog::error(
+                    "Invalid piece length: {} (expected a power of two from {} to {})",
+                    argv[i],
+                    core::TorrentBuilder::kMinPieceLength,
+                    core::TorrentBuilder::kMaxPieceLength
+                );
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            piece_length = *value;
+        } else if (arg == "-j" && has_value) {
+            auto value = parse_number<unsigned>(argv[++i]);
+            if (!value || *value == 0 || *value > kMaxThreads) {
+                spdlog::error("Invalid thread count: {} (expected 1 to {})", argv[i], kMaxThreads);
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            threads = *value;
+        } else if (!arg.starts_with('-') && !source) {
+            source = arg;
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!source || !output) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    core::TorrentBuilder builder(*source);
+    builder.set_piece_length(piece_length)
+        .set_threads(threads)
+        .set_created_by("bittorrent-cpp23")
+        .set_creation_date(std::chrono::system_clock::now());
+    if (!trackers.empty()) {
+        builder.set_announce(trackers.front());
+    }
+    if (trackers.size() > 1) {
+        for (const auto& tracker : trackers) {
+            builder.add_announce_tier({tracker});
+        }
+    }
+    if (comment) {
+        builder.set_comment(*comment);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    auto metainfo = builder.build();
+    if (!metainfo) {
+        spdlog::error("Failed to create torrent: {}", metainfo.error().message());
+        return EXIT_FAILURE;
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    std::ofstream out(*output, std::ios::binary | std::ios::trunc);
+    out.write(metainfo->data(), static_cast<std::streamsize>(metainfo->size()));
+    if (!out.flush()) {
+        spdlog::error("Failed to write {}", output->string());
+        return EXIT_FAILURE;
+    }
+
+    auto info = core::TorrentInfo::from_bytes(*metainfo);
+    spdlog::info(
+        "Wrote {} in {} ms{}",
+        output->string(),
+        std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(),
+        info ? ", info hash " + core::to_hex_string(info->info_hash()) : std::string()
+    );
+    return EXIT_SUCCESS;
+}
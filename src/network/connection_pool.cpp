@@ -0,0 +1,134 @@
+#include "bittorrent/network/connection_pool.hpp"
+#include <spdlog/spdlog.h>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/system/system_error.hpp>
+#include <utility>
+
+namespace asio = boost::asio;
+namespace beast = boost::beast;
+using tcp = asio::ip::tcp;
+
+namespace bittorrent::network {
+
+namespace {
+
+std::string pool_key(std::string_view host, std::string_view port) {
+    std::string key;
+    key.reserve(host.size() + port.size() + 1);
+    key.append(host).append(":").append(port);
+    return key;
+}
+
+// An idle HTTP connection has nothing to read; a pending byte, EOF or an error all mean the server is done with it.
+bool is_open_and_quiet(tcp::socket& socket) {
+    if (!socket.is_open()) {
+        return false;
+    }
+    boost::system::error_code ec;
+    socket.non_blocking(true, ec);
+    char byte;
+    socket.receive(asio::buffer(&byte, 1), tcp::socket::message_peek, ec);
+    const bool quiet = ec == asio::error::would_block;
+    socket.non_blocking(false, ec);
+    return quiet;
+}
+
+void close(beast::tcp_stream& stream) {
+    boost::system::error_code ec;
+    stream.socket().shutdown(tcp::socket::shutdown_both, ec);
+    stream.socket().close(ec);
+}
+
+}  // anonymous namespace
+
+ConnectionPool::ConnectionPool(asio::io_context& io_context, const Options& options)
+    : io_context_(io_context), options_(options), resolver_(io_context, options.dns_ttl) {}
+
+asio::awaitable<ConnectionPool::Connection> ConnectionPool::acquire(std::string_view host, std::string_view port) {
+    if (shut_down_) {
+        throw boost::system::system_error(asio::error::operation_aborted);
+    }
+
+    // A host's entry goes once its last connection is taken or expires, so hosts seen once do not pile up.
+    if (auto it = idle_.find(pool_key(host, port)); it != idle_.end()) {
+        auto& idle = it->second;
+        const auto now = std::chrono::steady_clock::now();
+        while (!idle.empty()) {
+            auto candidate = std::move(idle.back());
+            idle.pop_back();
+            if (now - candidate.since < options_.idle_timeout && is_open_and_quiet(candidate.stream.socket())) {
+                if (idle.empty()) {
+                    idle_.erase(it);
+                }
+                ++reused_;
+                co_return Connection{std::move(candidate.stream), true};
+            }
+            close(candidate.stream);
+        }
+        idle_.erase(it);
+    }
+
+    const auto endpoints = co_await resolver_.resolve(host, port);
+    if (shut_down_) {
+        throw boost::system::system_error(asio::error::operation_aborted);
+    }
+    beast::tcp_stream stream(io_context_);
+    stream.expires_after(options_.connect_timeout);
+
+    boost::system::error_code ec;
+    watch(stream);
+    co_await stream.async_connect(endpoints, asio::redirect_error(asio::use_awaitable, ec));
+    unwatch(stream);
+    if (shut_down_) {
+        throw boost::system::system_error(asio::error::operation_aborted);
+    }
+    if (ec) {
+        // The cached addresses may be what is wrong; look the name up again next time.
+        resolver_.invalidate(host, port);
+        throw boost::system::system_error(ec);
+    }
+    stream.expires_never();
+    ++opened_;
+    spdlog::debug("Opened connection to {}:{}", host, port);
+    co_return Connection{std::move(stream), false};
+}
+
+void ConnectionPool::release(std::string_view host, std::string_view port, beast::tcp_stream stream) {
+    if (shut_down_ || options_.max_idle_per_host == 0 || !stream.socket().is_open()) {
+        close(stream);
+        return;
+    }
+    auto& idle = idle_[pool_key(host, port)];
+    if (idle.size() >= options_.max_idle_per_host) {
+        close(stream);
+        return;
+    }
+    stream.expires_never();
+    idle.push_back({std::move(stream), std::chrono::steady_clock::now()});
+}
+
+void ConnectionPool::shutdown() {
+    shut_down_ = true;
+    for (auto& [key, idle] : idle_) {
+        for (auto& connection : idle) {
+            close(connection.stream);
+        }
+    }
+    idle_.clear();
+    for (auto* stream : busy_) {
+        stream->cancel();
+        close(*stream);
+    }
+}
+
+std::size_t ConnectionPool::idle_count() const noexcept {
+    std::size_t count = 0;
+    for (const auto& [key, idle] : idle_) {
+        count += idle.size();
+    }
+    return count;
+}
+
+}  // namespace bittorrent::network
@@ -0,0 +1,44 @@
+#include "bittorrent/network/resolver_cache.hpp"
+#include <spdlog/spdlog.h>
+#include <boost/asio/use_awaitable.hpp>
+
+namespace asio = boost::asio;
+using tcp = asio::ip::tcp;
+
+namespace bittorrent::network {
+
+ResolverCache::ResolverCache(asio::io_context& io_context, std::chrono::seconds ttl)
+    : io_context_(io_context), ttl_(ttl) {}
+
+std::string ResolverCache::key(std::string_view host, std::string_view port) {
+    std::string key;
+    key.reserve(host.size() + port.size() + 1);
+    key.append(host).append(":").append(port);
+    return key;
+}
+
+asio::awaitable<ResolverCache::Endpoints> ResolverCache::resolve(std::string_view host, std::string_view port) {
+    auto cache_key = key(host, port);
+    const auto now = std::chrono::steady_clock::now();
+    if (auto it = entries_.find(cache_key); it != entries_.end()) {
+        if (it->second.expires > now) {
+            ++hits_;
+            co_return it->second.endpoints;
+        }
+        entries_.erase(it);
+    }
+
+    ++misses_;
+    tcp::resolver resolver(io_context_);
+    auto endpoints = co_await resolver.async_resolve(std::string(host), std::string(port), asio::use_awaitable);
+    spdlog::debug("Resolved {} to {} endpoints", cache_key, endpoints.size());
+
+    entries_.insert_or_assign(std::move(cache_key), Entry{endpoints, std::chrono::steady_clock::now() + ttl_});
+    co_return endpoints;
+}
+
+void ResolverCache::invalidate(std::string_view host, std::string_view port) {
+    entries_.erase(key(host, port));
+}
+
+}  // namespace bittorrent::network
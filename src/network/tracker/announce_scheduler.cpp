@@ -0,0 +1,327 @@
+#include "bittorrent/network/announce_scheduler.hpp"
+#include <spdlog/spdlog.h>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <algorithm>
+
+namespace asio = boost::asio;
+
+namespace bittorrent::network {
+
+namespace {
+
+// "host:port" of a tracker URL, which is what its announces share: a pooled connection or a connection ID.
+std::string host_of(std::string_view url) {
+    if (const auto scheme = url.find("://"); scheme != std::string_view::npos) {
+        url.remove_prefix(scheme + 3);
+    }
+    return std::string(url.substr(0, url.find('/')));
+}
+
+}  // anonymous namespace
+
+AnnounceScheduler::AnnounceScheduler(
+    asio::io_context& io_context, HttpTracker& http, UdpTracker& udp, Callback on_result, const Options& options
+)
+    : io_context_(io_context),
+      http_(http),
+      udp_(udp),
+      on_result_(std::move(on_result)),
+      options_(options),
+      timer_(io_context),
+      rng_(std::random_device{}()) {}
+
+AnnounceScheduler::TorrentId AnnounceScheduler::add(
+    std::string announce_url,
+    const core::InfoHash& info_hash,
+    const core::PeerID& peer_id,
+    std::uint16_t port,
+    std::int64_t left
+) {
+    TorrentId id;
+    if (!free_.empty()) {
+        id = free_.back();
+        free_.pop_back();
+    } else {
+        id = static_cast<TorrentId>(entries_.size());
+        entries_.emplace_back();
+    }
+
+    auto& entry = entries_[id];
+    entry.host = host_of(announce_url);
+    entry.url = std::move(announce_url);
+    entry.info_hash = info_hash;
+    entry.peer_id = peer_id;
+    entry.port = port;
+    entry.left = left;
+    entry.live = true;
+    wheel_.schedule(id, 0);
+    return id;
+}
+
+void AnnounceScheduler::update(TorrentId id, std::int64_t uploaded, std::int64_t downloaded, std::int64_t left) {
+    auto& entry = entries_[id];
+    entry.uploaded = uploaded;
+    entry.downloaded = downloaded;
+    entry.left = left;
+}
+
+void AnnounceScheduler::completed(TorrentId id) {
+    auto& entry = entries_[id];
+    if (!entry.live || entry.removed) {
+        return;
+    }
+    if (!entry.started) {
+        entry.completion_pending = true;  // finish() follows Started up with it
+        return;
+    }
+    entry.event = TrackerEvent::Completed;
+    // One queued or in flight picks up the event; otherwise bring the next announce forward, unless backing off.
+    if (wheel_.scheduled(id) && entry.backoff.count() == 0) {
+        schedule(id, entry.earliest - std::chrono::steady_clock::now());
+    }
+}
+
+void AnnounceScheduler::remove(TorrentId id) {
+    auto& entry = entries_[id];
+    if (!entry.live || entry.removed) {
+        return;
+    }
+    entry.removed = true;
+    wheel_.cancel(id);
+    if (entry.in_flight) {
+        return;  // finish() sends Stopped or releases it
+    }
+    if (!entry.started) {
+        if (!entry.queued) {
+            release(id);
+        }
+        return;  // a worker releases it when it comes up
+    }
+    entry.event = TrackerEvent::Stopped;
+    if (!entry.queued) {
+        enqueue(id);
+    }
+}
+
+asio::awaitable<void> AnnounceScheduler::run() {
+    auto next_tick = std::chrono::steady_clock::now();
+    while (!stopping_) {
+        // Absolute deadlines, so time spent dispatching does not make the wheel fall behind.
+        next_tick += options_.tick;
+        boost::system::error_code ec;
+        timer_.expires_at(next_tick);
+        co_await timer_.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+        if (stopping_) {
+            break;
+        }
+
+        due_.clear();
+        wheel_.advance(due_);
+        for (const auto id : due_) {
+            dispatch(id);
+        }
+    }
+
+    while (workers_ > 0) {
+        boost::system::error_code ec;
+        timer_.expires_at(std::chrono::steady_clock::time_point::max());
+        co_await timer_.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+    }
+}
+
+void AnnounceScheduler::stop() {
+    stopping_ = true;
+    timer_.cancel();
+}
+
+std::chrono::milliseconds
+AnnounceScheduler::reannounce_delay(const TrackerResponse& response, double spread, std::chrono::milliseconds floor) {
+    // In floating point until clamped: trackers send any integer, zero and negative ones included.
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    auto delay = Milliseconds(response.interval) * (1.0 - spread);
+    if (response.min_interval) {
+        delay = std::max(delay, Milliseconds(*response.min_interval));
+    }
+    delay = std::clamp(delay, Milliseconds(floor), Milliseconds(kMaxReannounce));
+    return std::chrono::duration_cast<std::chrono::milliseconds>(delay);
+}
+
+void AnnounceScheduler::dispatch(TorrentId id) {
+    const auto& host = hosts_[entries_[id].host];
+    const auto now = std::chrono::steady_clock::now();
+    if (now < host.blocked_until) {
+        schedule(id, host.blocked_until - now);
+        return;
+    }
+    enqueue(id);
+}
+
+void AnnounceScheduler::enqueue(TorrentId id) {
+    auto& entry = entries_[id];
+    auto& host = hosts_[entry.host];
+    entry.queued = true;
+    host.queue.push_back(id);
+    if (host.workers < options_.max_in_flight_per_host && host.workers < host.queue.size()) {
+        ++host.workers;
+        ++workers_;
+        asio::co_spawn(io_context_, work(entry.host), asio::detached);
+    }
+}
+
+void AnnounceScheduler::schedule(TorrentId id, std::chrono::steady_clock::duration delay) {
+    const auto tick = std::chrono::duration_cast<std::chrono::steady_clock::duration>(options_.tick);
+    std::uint64_t ticks = 0;
+    if (delay / tick >= static_cast<std::int64_t>(utils::TimerWheel::kMaxDelay)) {
+        ticks = utils::TimerWheel::kMaxDelay;
+    } else if (delay > delay.zero()) {
+        ticks = static_cast<std::uint64_t>((delay + tick - std::chrono::steady_clock::duration(1)) / tick);
+    }
+    wheel_.schedule(id, ticks);
+}
+
+asio::awaitable<void> AnnounceScheduler::work(std::string key) {
+    // Elements of an unordered_map stay put when it grows, and hosts are never erased.
+    auto& host = hosts_[key];
+    while (!host.queue.empty() && std::chrono::steady_clock::now() >= host.blocked_until) {
+        const auto id = host.queue.front();
+        host.queue.pop_front();
+
+        auto& entry = entries_[id];
+        entry.queued = false;
+        if (entry.removed && !entry.started) {
+            release(id);
+            continue;
+        }
+        if (stopping_ && entry.event != TrackerEvent::Stopped) {
+            continue;
+        }
+
+        // Copied: `entries_` may grow while the announce runs.
+        entry.in_flight = true;
+        const auto url = entry.url;
+        const auto event = entry.event;
+        const auto info_hash = entry.info_hash;
+        const auto peer_id = entry.peer_id;
+        Result result = std::unexpected(TrackerError::InvalidResponse);
+        if (url.starts_with("udp://")) {
+            result = co_await udp_.announce(
+                url, info_hash, peer_id, entry.port, entry.uploaded, entry.downloaded, entry.left, event
+            );
+        } else if (url.starts_with("http://")) {
+            result = co_await http_.announce(
+                url, info_hash, peer_id, entry.port, entry.uploaded, entry.downloaded, entry.left, event
+            );
+        } else {
+            spdlog::warn("Unsupported tracker URL: {}", url);
+        }
+        finish(id, event, result);
+    }
+
+    // The last worker out puts whatever the host could not take back on the wheel.
+    --host.workers;
+    --workers_;
+    if (host.workers == 0) {
+        const auto now = std::chrono::steady_clock::now();
+        for (const auto id : host.queue) {
+            auto& entry = entries_[id];
+            entry.queued = false;
+            if (entry.removed && !entry.started) {
+                release(id);
+            } else {
+                schedule(id, host.blocked_until - now);
+            }
+        }
+        host.queue.clear();
+    }
+    if (stopping_) {
+        timer_.cancel();
+    }
+}
+
+void AnnounceScheduler::finish(TorrentId id, TrackerEvent sent, const Result& result) {
+    auto& entry = entries_[id];
+    entry.in_flight = false;
+    if (sent == TrackerEvent::Stopped) {
+        release(id);
+        return;
+    }
+
+    auto& host = hosts_[entry.host];
+    const auto now = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration delay;
+    if (result) {
+        host.backoff = entry.backoff = std::chrono::milliseconds(0);
+        entry.started = true;
+        // Clamped like the interval, so an absurd min interval cannot overflow the time point.
+        const auto min_interval = std::clamp<std::chrono::seconds>(
+            result->min_interval.value_or(std::chrono::seconds(0)), std::chrono::seconds(0), kMaxReannounce
+        );
+        entry.earliest = now + min_interval;
+        if (entry.event == sent) {
+            entry.event = TrackerEvent::None;
+        }
+        if (entry.completion_pending) {
+            entry.completion_pending = false;
+            entry.event = TrackerEvent::Completed;
+        }
+        if (entry.event == TrackerEvent::None) {
+            delay = reannounce_delay(*result, spread(), options_.min_reannounce);
+        } else {
+            delay = entry.earliest - now;  // completed() while this announce was out
+        }
+    } else if (result.error() == TrackerError::ConnectionFailed || result.error() == TrackerError::Timeout) {
+        host.backoff = next_backoff(host.backoff);
+        host.blocked_until = std::max(host.blocked_until, now + jittered(host.backoff));
+        delay = host.blocked_until - now;
+        spdlog::warn("Tracker host {} unreachable, backing off for {} ms", entry.host, host.backoff.count());
+    } else {
+        entry.backoff = next_backoff(entry.backoff);
+        delay = jittered(entry.backoff);
+        spdlog::warn(
+            "Tracker {} failed: {}, retrying in {} ms", entry.url, to_string(result.error()), entry.backoff.count()
+        );
+    }
+
+    if (entry.removed) {
+        if (entry.started) {
+            entry.event = TrackerEvent::Stopped;
+            enqueue(id);
+        } else {
+            release(id);
+        }
+        return;
+    }
+    if (!stopping_) {
+        schedule(id, delay);
+    }
+    on_result_(id, result);
+}
+
+void AnnounceScheduler::release(TorrentId id) {
+    wheel_.cancel(id);
+    entries_[id] = Entry{};
+    free_.push_back(id);
+}
+
+double AnnounceScheduler::spread() {
+    if (options_.jitter <= 0.0) {
+        return 0.0;
+    }
+    return std::uniform_real_distribution<double>(0.0, options_.jitter)(rng_);
+}
+
+std::chrono::milliseconds AnnounceScheduler::jittered(std::chrono::milliseconds delay) {
+    return std::chrono::milliseconds(static_cast<std::int64_t>(static_cast<double>(delay.count()) * (1.0 - spread())));
+}
+
+std::chrono::milliseconds AnnounceScheduler::next_backoff(std::chrono::milliseconds backoff) const {
+    if (backoff.count() == 0) {
+        return options_.initial_backoff;
+    }
+    return std::min(backoff * 2, options_.max_backoff);
+}
+
+}  // namespace bittorrent::network
@@ -3,13 +3,16 @@
 #include <boost/asio/co_spawn.hpp>
 #include <boost/asio/detached.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/redirect_error.hpp>
 #include <boost/asio/use_awaitable.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/url.hpp>
+#include <cstring>
+#include <optional>
 #include <string_view>
-#include "bittorrent/bencode/parser.hpp"
-#include "bittorrent/bencode/value.hpp"
+#include <tuple>
+#include "bittorrent/bencode/decode.hpp"
 
 namespace beast = boost::beast;
 namespace http = beast::http;
@@ -18,88 +21,186 @@ using tcp = asio::ip::tcp;
 
 namespace bittorrent::network {
 
-HttpTracker::HttpTracker(asio::io_context& io_context) : io_context_(io_context) {}
+namespace {
 
-std::expected<TrackerResponse, TrackerError> HttpTracker::parse_response(std::string_view response_body) {
-    auto result = bencode::Parser::parse(response_body);
+constexpr std::chrono::seconds kRequestTimeout{30};
 
-    if (!result) {
-        spdlog::error("Failed to parse tracker response: {}", bencode::to_string(result.error()));
-        return std::unexpected(TrackerError::ParseError);
-    }
+// The wire form of an announce reply: a TrackerResponse plus the keys only needed while decoding it.
+struct AnnounceReply : TrackerResponse {
+    std::optional<std::string_view> failure_reason;
+};
 
-    const auto& value = *result;
-    if (!value.is_dictionary()) {
-        spdlog::error("Tracker response is not a dictionary");
-        return std::unexpected(TrackerError::InvalidResponse);
+std::expected<void, bencode::DecodeError> decode_peers(bencode::Reader& reader, std::vector<PeerInfo>& peers) {
+    auto type = reader.peek();
+    if (type && *type == bencode::TokenType::List) {
+        spdlog::warn("Dictionary format peers not yet supported");
+        return reader.skip();
     }
 
-    const auto& dict = value.as_dictionary();
-
-    if (dict.contains("failure reason")) {
-        const auto& failure = dict.at("failure reason");
-        if (failure.is_string()) {
-            spdlog::error("Tracker failure: {}", failure.as_string());
-        }
-        return std::unexpected(TrackerError::TrackerFailure);
+    const std::size_t offset = reader.position();
+    auto peers_data = reader.read_string();
+    if (!peers_data) {
+        return std::unexpected(peers_data.error());
     }
 
-    TrackerResponse response;
-    if (!dict.contains("interval") || !dict.at("interval").is_integer()) {
-        spdlog::error("Missing or invalid 'interval' in tracker response");
-        return std::unexpected(TrackerError::InvalidResponse);
+    if (peers_data->size() % 6 != 0) {
+        spdlog::error("Invalid peers data size: {}", peers_data->size());
+        return std::unexpected(bencode::DecodeError{bencode::DecodeError::Kind::InvalidValue, offset});
     }
-    response.interval = std::chrono::seconds(dict.at("interval").as_integer());
 
-    if (dict.contains("min interval") && dict.at("min interval").is_integer()) {
-        response.min_interval = std::chrono::seconds(dict.at("min interval").as_integer());
-    }
+    peers.reserve(peers_data->size() / 6);
+    for (size_t i = 0; i < peers_data->size(); i += 6) {
+        const auto* entry = reinterpret_cast<const std::uint8_t*>(peers_data->data() + i);
+        PeerInfo peer;
+        peer.ip = {entry[0], entry[1], entry[2], entry[3]};
 
-    if (dict.contains("tracker id") && dict.at("tracker id").is_string()) {
-        response.tracker_id = dict.at("tracker id").as_string();
-    }
+        // Network byte order
+        // https://www.ibm.com/docs/en/zvm/7.3.0?topic=domains-network-byte-order-host-byte-order
+        peer.port = static_cast<std::uint16_t>((entry[4] << 8) | entry[5]);
 
-    if (dict.contains("complete") && dict.at("complete").is_integer()) {
-        response.complete = dict.at("complete").as_integer();
+        peers.push_back(peer);
     }
+    return {};
+}
 
-    if (dict.contains("incomplete") && dict.at("incomplete").is_integer()) {
-        response.incomplete = dict.at("incomplete").as_integer();
-    }
+// Sends a GET for `target` over a pooled connection and reads the reply, returning the connection to the pool when
+// the server keeps it open. A reused connection that the server has closed in the meantime fails on first use; the
+// request is then retried once on a fresh connection. Throws boost::system::system_error on other failures.
+asio::awaitable<http::response<http::string_body>>
+fetch(ConnectionPool& pool, const std::string& host, const std::string& port, const std::string& target) {
+    http::request<http::string_body> req{http::verb::get, target, 11};
+    req.set(http::field::host, host);
+    req.set(http::field::user_agent, "bittorrent-cpp23/1.0");
+    req.keep_alive(true);
 
-    if (dict.contains("warning message") && dict.at("warning message").is_string()) {
-        response.warning_message = dict.at("warning message").as_string();
-    }
+    for (bool retried = false;; retried = true) {
+        auto connection = co_await pool.acquire(host, port);
+        connection.stream.expires_after(kRequestTimeout);
 
-    if (dict.contains("peers")) {
-        const auto& peers_value = dict.at("peers");
-        if (peers_value.is_string()) {
-            const auto& peers_data = peers_value.as_string();
+        beast::flat_buffer buffer;
+        http::response<http::string_body> res;
+        boost::system::error_code ec;
+        pool.watch(connection.stream);
+        co_await http::async_write(connection.stream, req, asio::redirect_error(asio::use_awaitable, ec));
+        if (!ec) {
+            co_await http::async_read(connection.stream, buffer, res, asio::redirect_error(asio::use_awaitable, ec));
+        }
+        pool.unwatch(connection.stream);
 
-            if (peers_data.size() % 6 != 0) {
-                spdlog::error("Invalid peers data size: {}", peers_data.size());
-                return std::unexpected(TrackerError::InvalidResponse);
+        if (ec) {
+            // A stale pooled connection is worth one retry; one aborted by shutdown() is not.
+            if (connection.reused && !retried && ec != beast::error::timeout && ec != asio::error::operation_aborted) {
+                spdlog::debug("Pooled connection to {}:{} was stale ({}), reconnecting", host, port, ec.message());
+                continue;
             }
+            throw boost::system::system_error(ec);
+        }
 
-            for (size_t i = 0; i < peers_data.size(); i += 6) {
-                PeerInfo peer;
-                peer.ip[0] = static_cast<std::uint8_t>(peers_data[i]);
-                peer.ip[1] = static_cast<std::uint8_t>(peers_data[i + 1]);
-                peer.ip[2] = static_cast<std::uint8_t>(peers_data[i + 2]);
-                peer.ip[3] = static_cast<std::uint8_t>(peers_data[i + 3]);
+        if (res.keep_alive()) {
+            pool.release(host, port, std::move(connection.stream));
+        } else {
+            connection.stream.socket().shutdown(tcp::socket::shutdown_both, ec);
+        }
+        co_return res;
+    }
+}
 
-                // Network byte order
-                // https://www.ibm.com/docs/en/zvm/7.3.0?topic=domains-network-byte-order-host-byte-order
-                peer.port = (static_cast<std::uint16_t>(static_cast<std::uint8_t>(peers_data[i + 4])) << 8) |
-                            static_cast<std::uint16_t>(static_cast<std::uint8_t>(peers_data[i + 5]));
+}  // anonymous namespace
 
-                response.peers.emplace_back(std::move(peer));
-            }
-        } else if (peers_value.is_list()) {
-            spdlog::warn("Dictionary format peers not yet supported");
+}  // namespace bittorrent::network
+
+template <>
+struct bittorrent::bencode::Schema<bittorrent::network::AnnounceReply> {
+    using Reply = network::AnnounceReply;
+
+    // Only the interval and the peers matter; a mistyped informational key is ignored, and cannot hide a failure
+    // reason that sorts after it.
+    static constexpr auto fields = std::tuple{
+        field("complete", &Reply::complete, &decode_lenient<std::int64_t>),
+        field("failure reason", &Reply::failure_reason, &decode_lenient<std::optional<std::string_view>>),
+        field("incomplete", &Reply::incomplete, &decode_lenient<std::int64_t>),
+        required_field("interval", &Reply::interval),
+        field("min interval", &Reply::min_interval, &decode_lenient<std::optional<std::chrono::seconds>>),
+        field("peers", &Reply::peers, &network::decode_peers),
+        field("tracker id", &Reply::tracker_id, &decode_lenient<std::optional<std::string>>),
+        field("warning message", &Reply::warning_message, &decode_lenient<std::optional<std::string>>),
+    };
+};
+
+template <>
+struct bittorrent::bencode::Schema<bittorrent::network::ScrapeStats> {
+    using Stats = network::ScrapeStats;
+
+    static constexpr auto fields = std::tuple{
+        field("complete", &Stats::complete, &decode_lenient<std::int64_t>),
+        field("downloaded", &Stats::downloaded, &decode_lenient<std::int64_t>),
+        field("incomplete", &Stats::incomplete, &decode_lenient<std::int64_t>),
+    };
+};
+
+namespace bittorrent::network {
+
+namespace {
+
+// The wire form of a scrape reply.
+struct ScrapeReply {
+    ScrapeResponse files;
+    std::optional<std::string_view> failure_reason;
+};
+
+// `files` is keyed by raw 20-byte info-hashes; keys of any other length are skipped.
+std::expected<void, bencode::DecodeError> decode_files(bencode::Reader& reader, ScrapeResponse& files) {
+    return reader.read_dictionary([&](std::string_view key) -> std::expected<void, bencode::DecodeError> {
+        core::InfoHash info_hash;
+        if (key.size() != info_hash.size()) {
+            return reader.skip();
         }
+        std::memcpy(info_hash.data(), key.data(), key.size());
+        return bencode::Decoder<ScrapeStats>::decode(reader, files[info_hash]);
+    });
+}
+
+}  // anonymous namespace
+
+}  // namespace bittorrent::network
+
+template <>
+struct bittorrent::bencode::Schema<bittorrent::network::ScrapeReply> {
+    using Reply = network::ScrapeReply;
+
+    static constexpr auto fields = std::tuple{
+        field("failure reason", &Reply::failure_reason),
+        field("files", &Reply::files, &network::decode_files),
+    };
+};
+
+namespace bittorrent::network {
+
+HttpTracker::HttpTracker(asio::io_context& io_context, const ConnectionPool::Options& pool_options)
+    : pool_(io_context, pool_options) {}
+
+std::expected<TrackerResponse, TrackerError> HttpTracker::parse_response(std::string_view response_body) {
+    // Decoded in one pass straight from the body; no Value tree is built.
+    AnnounceReply reply{};
+    auto decoded = bencode::decode(response_body, reply);
+
+    if (!decoded && decoded.error().kind == bencode::DecodeError::Kind::Syntax) {
+        spdlog::error("Failed to parse tracker response: {}", bencode::to_string(decoded.error()));
+        return std::unexpected(TrackerError::ParseError);
+    }
+
+    if (reply.failure_reason) {
+        spdlog::error("Tracker failure: {}", *reply.failure_reason);
+        return std::unexpected(TrackerError::TrackerFailure);
+    }
+
+    if (!decoded) {
+        spdlog::error("Invalid tracker response: {}", bencode::to_string(decoded.error()));
+        return std::unexpected(TrackerError::InvalidResponse);
     }
 
+    TrackerResponse response = std::move(reply);
+
     spdlog::info(
         "Parsed tracker response: interval={}s, peers={}, seeders={}, leechers={}",
         response.interval.count(),
@@ -111,6 +212,43 @@ std::expected<TrackerResponse, TrackerError> HttpTracker::parse_response(std::st
     return response;
 }
 
+std::expected<ScrapeResponse, TrackerError> HttpTracker::parse_scrape_response(std::string_view response_body) {
+    ScrapeReply reply{};
+    auto decoded = bencode::decode(response_body, reply);
+
+    if (!decoded && decoded.error().kind == bencode::DecodeError::Kind::Syntax) {
+        spdlog::error("Failed to parse scrape response: {}", bencode::to_string(decoded.error()));
+        return std::unexpected(TrackerError::ParseError);
+    }
+
+    if (reply.failure_reason) {
+        spdlog::error("Tracker failure: {}", *reply.failure_reason);
+        return std::unexpected(TrackerError::TrackerFailure);
+    }
+
+    if (!decoded) {
+        spdlog::error("Invalid scrape response: {}", bencode::to_string(decoded.error()));
+        return std::unexpected(TrackerError::InvalidResponse);
+    }
+
+    return std::move(reply.files);
+}
+
+std::optional<std::string> HttpTracker::scrape_url(std::string_view announce_url) {
+    const auto path_end = std::min(announce_url.find('?'), announce_url.size());
+    const auto slash = announce_url.rfind('/', path_end == 0 ? 0 : path_end - 1);
+    if (slash == std::string_view::npos) {
+        return std::nullopt;
+    }
+    if (!announce_url.substr(slash + 1, path_end - slash - 1).starts_with("announce")) {
+        return std::nullopt;
+    }
+
+    std::string url(announce_url);
+    url.replace(slash + 1, std::string_view("announce").size(), "scrape");
+    return url;
+}
+
 asio::awaitable<std::expected<TrackerResponse, TrackerError>> HttpTracker::announce(
     std::string_view announce_url,
     const core::InfoHash& info_hash,
@@ -150,28 +288,9 @@ asio::awaitable<std::expected<TrackerResponse, TrackerError>> HttpTracker::annou
         auto target = url.encoded_target();
         spdlog::debug("Announcing to tracker: {}:{}{}", host, port_str, target);
 
-        tcp::resolver resolver(io_context_);
-        auto endpoints = co_await resolver.async_resolve(host, port_str, asio::use_awaitable);
-
-        beast::tcp_stream stream(io_context_);
-        stream.expires_after(std::chrono::seconds(30));
-
-        co_await stream.async_connect(endpoints, asio::use_awaitable);
-
-        http::request<http::string_body> req{http::verb::get, target, 11};
-        req.set(http::field::host, host);
-        req.set(http::field::user_agent, "bittorrent-cpp23/1.0");
-        req.set(http::field::connection, "close");
-        co_await http::async_write(stream, req, asio::use_awaitable);
-
-        beast::flat_buffer buffer;
-        http::response<http::string_body> res;
-        co_await http::async_read(stream, buffer, res, asio::use_awaitable);
+        auto res = co_await fetch(pool_, host, port_str, std::string(target));
         spdlog::debug("Received tracker response: {} bytes, status={}", res.body().size(), res.result_int());
 
-        beast::error_code ec;
-        stream.socket().shutdown(tcp::socket::shutdown_both, ec);
-
         if (res.result() != http::status::ok) {
             spdlog::error("Tracker returned HTTP {}", res.result_int());
             co_return std::unexpected(TrackerError::TrackerFailure);
@@ -185,4 +304,63 @@ asio::awaitable<std::expected<TrackerResponse, TrackerError>> HttpTracker::annou
     }
 }
 
+asio::awaitable<std::expected<ScrapeResponse, TrackerError>>
+HttpTracker::scrape(std::string_view announce_url, std::span<const core::InfoHash> info_hashes) {
+    const auto target_url = scrape_url(announce_url);
+    if (!target_url) {
+        spdlog::error("Tracker does not support scrape: {}", announce_url);
+        co_return std::unexpected(TrackerError::InvalidResponse);
+    }
+
+    auto parsed = boost::urls::parse_uri(*target_url);
+    if (!parsed) {
+        spdlog::error("Failed to parse tracker URL: {}", *target_url);
+        co_return std::unexpected(TrackerError::InvalidResponse);
+    }
+
+    // Batches that succeeded are kept if a later one fails.
+    ScrapeResponse response;
+    std::size_t offset = 0;
+    std::expected<void, TrackerError> failure;
+    try {
+        for (; offset < info_hashes.size(); offset += kMaxScrapeHashes) {
+            boost::urls::url url = *parsed;
+            std::string host{url.host()};
+            std::string port_str = url.has_port() ? std::string{url.port()} : "80";
+
+            boost::urls::params_ref params = url.params();
+            const auto batch = info_hashes.subspan(offset, std::min(kMaxScrapeHashes, info_hashes.size() - offset));
+            for (const auto& info_hash : batch) {
+                params.append({"info_hash", std::string_view(reinterpret_cast<const char*>(info_hash.data()), 20)});
+            }
+
+            auto res = co_await fetch(pool_, host, port_str, std::string(url.encoded_target()));
+            if (res.result() != http::status::ok) {
+                spdlog::error("Tracker returned HTTP {} to scrape", res.result_int());
+                failure = std::unexpected(TrackerError::TrackerFailure);
+                break;
+            }
+
+            auto stats = parse_scrape_response(res.body());
+            if (!stats) {
+                failure = std::unexpected(stats.error());
+                break;
+            }
+            response.merge(*stats);
+        }
+    } catch (const std::exception& e) {
+        spdlog::error("Tracker scrape failed: {}", e.what());
+        failure = std::unexpected(TrackerError::ConnectionFailed);
+    }
+
+    if (!failure) {
+        if (offset == 0) {
+            co_return std::unexpected(failure.error());
+        }
+        spdlog::warn("Scrape of {} stopped after {} of {} torrents", *target_url, offset, info_hashes.size());
+    }
+    spdlog::debug("Scraped {} of {} torrents from {}", response.size(), info_hashes.size(), *target_url);
+    co_return response;
+}
+
 }  // namespace bittorrent::network
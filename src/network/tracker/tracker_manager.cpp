@@ -0,0 +1,272 @@
+#include "bittorrent/network/tracker_manager.hpp"
+#include <spdlog/spdlog.h>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <random>
+#include <unordered_set>
+
+namespace asio = boost::asio;
+
+namespace bittorrent::network {
+
+// One call to `announce`: its parameters, and what the trackers asked so far have answered. Announces that are
+// still running when the call returns keep it alive but no longer add peers.
+struct TrackerManager::Round {
+    explicit Round(const asio::any_io_executor& executor) : wake(executor) {}
+
+    core::InfoHash info_hash;
+    core::PeerID peer_id;
+    std::uint16_t port{0};
+    std::int64_t uploaded{0};
+    std::int64_t downloaded{0};
+    std::int64_t left{0};
+    TrackerEvent event{TrackerEvent::None};
+
+    asio::steady_timer wake;                  // cancelled whenever a tracker finishes
+    std::vector<std::size_t> outstanding;     // per tier
+    std::vector<bool> tier_answered;
+    std::size_t running{0};
+    std::optional<TrackerResponse> response;  // merged
+    std::unordered_set<std::uint64_t> seen_peers;
+    std::chrono::steady_clock::time_point first_answer;
+    TrackerError last_error{TrackerError::ConnectionFailed};
+    bool finished{false};
+};
+
+// One call to `scrape`: the trackers still running and the counts merged so far.
+struct TrackerManager::ScrapeRound {
+    explicit ScrapeRound(const asio::any_io_executor& executor) : wake(executor) {}
+
+    asio::steady_timer wake;  // cancelled whenever a tracker finishes
+    std::size_t running{0};
+    ScrapeResponse stats;
+};
+
+TrackerManager::TrackerManager(HttpTracker& http, UdpTracker& udp, Tiers tiers, const Options& options)
+    : http_(http), udp_(udp), tiers_(std::make_shared<Tiers>(std::move(tiers))), options_(options) {}
+
+TrackerManager::Tiers TrackerManager::tiers_of(const core::TorrentInfo& torrent) {
+    Tiers tiers = torrent.announce_list();
+    if (tiers.empty() && !torrent.announce().empty()) {
+        tiers.push_back({torrent.announce()});
+    }
+
+    // BEP 12: trackers within a tier are tried in random order, so clients spread over them.
+    std::mt19937 rng(std::random_device{}());
+    for (auto& tier : tiers) {
+        std::shuffle(tier.begin(), tier.end(), rng);
+    }
+    return tiers;
+}
+
+asio::awaitable<std::expected<TrackerResponse, TrackerError>> TrackerManager::announce(
+    const core::InfoHash& info_hash,
+    const core::PeerID& peer_id,
+    std::uint16_t port,
+    std::int64_t uploaded,
+    std::int64_t downloaded,
+    std::int64_t left,
+    TrackerEvent event
+) {
+    auto executor = co_await asio::this_coro::executor;
+    auto round = std::make_shared<Round>(executor);
+    round->info_hash = info_hash;
+    round->peer_id = peer_id;
+    round->port = port;
+    round->uploaded = uploaded;
+    round->downloaded = downloaded;
+    round->left = left;
+    round->event = event;
+
+    const auto tier_count = tiers_->size();
+    round->outstanding.assign(tier_count, 0);
+    round->tier_answered.assign(tier_count, false);
+
+    std::size_t launched = 0;
+    std::chrono::steady_clock::time_point next_tier_at;
+    auto launch_next_tier = [&] {
+        // Copied: answers reorder the tier while its announces run.
+        for (auto url : (*tiers_)[launched]) {
+            ++round->outstanding[launched];
+            ++round->running;
+            asio::co_spawn(
+                executor, announce_one(http_, udp_, tiers_, round, launched, std::move(url)), asio::detached
+            );
+        }
+        ++launched;
+        next_tier_at = std::chrono::steady_clock::now() + options_.tier_fallback_delay;
+    };
+
+    // Trackers report back only while this coroutine waits, so the state is always rechecked before waiting again.
+    while (launched < tier_count || round->running > 0) {
+        const auto now = std::chrono::steady_clock::now();
+        auto wake_at = std::chrono::steady_clock::time_point::max();
+        if (round->response) {
+            wake_at = round->first_answer + options_.merge_window;
+            if (round->running == 0 || now >= wake_at) {
+                break;
+            }
+        } else if (launched < tier_count) {
+            if (launched == 0 || round->outstanding[launched - 1] == 0 || now >= next_tier_at) {
+                launch_next_tier();
+                continue;
+            }
+            wake_at = next_tier_at;
+        }
+
+        boost::system::error_code ec;
+        round->wake.expires_at(wake_at);
+        co_await round->wake.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+    }
+    round->finished = true;
+
+    if (!round->response) {
+        spdlog::error("No tracker answered out of {} tiers", tier_count);
+        co_return std::unexpected(round->last_error);
+    }
+
+    spdlog::info(
+        "Tracker announce gathered {} peers, {} tracker(s) still running",
+        round->response->peers.size(),
+        round->running
+    );
+    co_return std::move(*round->response);
+}
+
+asio::awaitable<void> TrackerManager::announce_one(
+    HttpTracker& http,
+    UdpTracker& udp,
+    std::shared_ptr<Tiers> tiers,
+    std::shared_ptr<Round> round,
+    std::size_t tier,
+    std::string url
+) {
+    std::expected<TrackerResponse, TrackerError> result = std::unexpected(TrackerError::InvalidResponse);
+    if (url.starts_with("udp://")) {
+        result = co_await udp.announce(
+            url, round->info_hash, round->peer_id, round->port, round->uploaded, round->downloaded, round->left,
+            round->event
+        );
+    } else if (url.starts_with("http://")) {
+        result = co_await http.announce(
+            url, round->info_hash, round->peer_id, round->port, round->uploaded, round->downloaded, round->left,
+            round->event
+        );
+    } else {
+        spdlog::warn("Unsupported tracker URL: {}", url);
+    }
+
+    --round->outstanding[tier];
+    --round->running;
+    round->wake.cancel();
+
+    if (!result) {
+        spdlog::warn("Tracker {} failed: {}", url, to_string(result.error()));
+        round->last_error = result.error();
+        co_return;
+    }
+
+    if (!round->tier_answered[tier]) {
+        round->tier_answered[tier] = true;
+        auto& trackers = (*tiers)[tier];
+        if (auto it = std::ranges::find(trackers, url); it != trackers.end()) {
+            std::rotate(trackers.begin(), it, it + 1);
+        }
+    }
+
+    if (round->finished) {
+        co_return;
+    }
+
+    auto peers = std::move(result->peers);
+    if (!round->response) {
+        round->response = std::move(*result);
+        round->response->peers.clear();
+        round->first_answer = std::chrono::steady_clock::now();
+    } else {
+        round->response->complete = std::max(round->response->complete, result->complete);
+        round->response->incomplete = std::max(round->response->incomplete, result->incomplete);
+    }
+
+    for (const auto& peer : peers) {
+        const auto key = std::uint64_t{peer.ip[0]} << 40 | std::uint64_t{peer.ip[1]} << 32 |
+                         std::uint64_t{peer.ip[2]} << 24 | std::uint64_t{peer.ip[3]} << 16 | peer.port;
+        if (round->seen_peers.insert(key).second) {
+            round->response->peers.push_back(peer);
+        }
+    }
+}
+
+asio::awaitable<ScrapeResponse>
+TrackerManager::scrape(HttpTracker& http, UdpTracker& udp, std::span<const ScrapeTarget> targets) {
+    // A UDP tracker is one endpoint whatever the path; an HTTP tracker's path may carry a passkey, so it stays.
+    std::map<std::string, std::vector<core::InfoHash>> by_tracker;
+    for (const auto& target : targets) {
+        const auto& url = target.announce_url;
+        if (url.starts_with("udp://")) {
+            by_tracker[url.substr(0, url.find('/', std::string_view("udp://").size()))].push_back(target.info_hash);
+        } else {
+            by_tracker[target.announce_url].push_back(target.info_hash);
+        }
+    }
+
+    auto executor = co_await asio::this_coro::executor;
+    auto round = std::make_shared<ScrapeRound>(executor);
+    for (auto& [url, info_hashes] : by_tracker) {
+        ++round->running;
+        asio::co_spawn(executor, scrape_one(http, udp, round, url, std::move(info_hashes)), asio::detached);
+    }
+
+    while (round->running > 0) {
+        boost::system::error_code ec;
+        round->wake.expires_at(std::chrono::steady_clock::time_point::max());
+        co_await round->wake.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+    }
+
+    spdlog::info(
+        "Scraped {} trackers: counts for {} of {} targets", by_tracker.size(), round->stats.size(), targets.size()
+    );
+    co_return std::move(round->stats);
+}
+
+asio::awaitable<void> TrackerManager::scrape_one(
+    HttpTracker& http,
+    UdpTracker& udp,
+    std::shared_ptr<ScrapeRound> round,
+    std::string url,
+    std::vector<core::InfoHash> info_hashes
+) {
+    std::expected<ScrapeResponse, TrackerError> result = std::unexpected(TrackerError::InvalidResponse);
+    if (url.starts_with("udp://")) {
+        result = co_await udp.scrape(url, info_hashes);
+    } else if (url.starts_with("http://")) {
+        result = co_await http.scrape(url, info_hashes);
+    } else {
+        spdlog::warn("Unsupported tracker URL: {}", url);
+    }
+
+    --round->running;
+    round->wake.cancel();
+
+    if (!result) {
+        spdlog::warn("Scrape of {} torrents from {} failed: {}", info_hashes.size(), url, to_string(result.error()));
+        co_return;
+    }
+
+    for (const auto& [info_hash, stats] : *result) {
+        auto [it, inserted] = round->stats.try_emplace(info_hash, stats);
+        if (!inserted) {
+            it->second.complete = std::max(it->second.complete, stats.complete);
+            it->second.downloaded = std::max(it->second.downloaded, stats.downloaded);
+            it->second.incomplete = std::max(it->second.incomplete, stats.incomplete);
+        }
+    }
+}
+
+}  // namespace bittorrent::network
@@ -0,0 +1,467 @@
+#include "bittorrent/network/udp_tracker.hpp"
+#include <spdlog/spdlog.h>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/system/system_error.hpp>
+#include <boost/url.hpp>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <exception>
+
+namespace asio = boost::asio;
+using udp = asio::ip::udp;
+
+namespace bittorrent::network {
+
+namespace {
+
+constexpr std::uint64_t kProtocolId = 0x41727101980;
+constexpr std::uint32_t kActionConnect = 0;
+constexpr std::uint32_t kActionAnnounce = 1;
+constexpr std::uint32_t kActionScrape = 2;
+constexpr std::uint32_t kActionError = 3;
+
+constexpr std::size_t kRequestHeaderSize = 16;  // connection ID, action, transaction ID; also a connect reply
+constexpr std::size_t kAnnounceRequestSize = 98;
+constexpr std::size_t kAnnounceHeaderSize = 20;
+constexpr std::size_t kReplyHeaderSize = 8;
+constexpr std::size_t kScrapeEntrySize = 12;
+constexpr std::size_t kMaxPacketSize = 65536;
+
+// All integers on the wire are big-endian.
+void write_u16(std::uint8_t* out, std::uint16_t value) {
+    out[0] = static_cast<std::uint8_t>(value >> 8);
+    out[1] = static_cast<std::uint8_t>(value);
+}
+
+void write_u32(std::uint8_t* out, std::uint32_t value) {
+    for (int i = 3; i >= 0; --i, value >>= 8) {
+        out[i] = static_cast<std::uint8_t>(value);
+    }
+}
+
+void write_u64(std::uint8_t* out, std::uint64_t value) {
+    for (int i = 7; i >= 0; --i, value >>= 8) {
+        out[i] = static_cast<std::uint8_t>(value);
+    }
+}
+
+std::uint32_t read_u32(const std::uint8_t* in) {
+    return std::uint32_t{in[0]} << 24 | std::uint32_t{in[1]} << 16 | std::uint32_t{in[2]} << 8 | in[3];
+}
+
+std::uint64_t read_u64(const std::uint8_t* in) {
+    return std::uint64_t{read_u32(in)} << 32 | read_u32(in + 4);
+}
+
+bool is_error_reply(std::span<const std::uint8_t> packet) {
+    return packet.size() >= kReplyHeaderSize && read_u32(packet.data()) == kActionError;
+}
+
+// Whether an error reply blames the connection ID, as trackers word it ("Connection ID mismatch", "invalid
+// connection id", ...), rather than the request.
+bool is_connection_error(std::span<const std::uint8_t> packet) {
+    std::string message(reinterpret_cast<const char*>(packet.data() + 8), packet.size() - 8);
+    std::ranges::transform(message, message.begin(), [](unsigned char c) { return std::tolower(c); });
+    return message.find("connection") != std::string::npos;
+}
+
+TrackerError error_reply(std::span<const std::uint8_t> packet) {
+    std::string_view message(reinterpret_cast<const char*>(packet.data() + 8), packet.size() - 8);
+    spdlog::error("Tracker failure: {}", message);
+    return TrackerError::TrackerFailure;
+}
+
+std::uint32_t event_code(TrackerEvent event) {
+    switch (event) {
+        case TrackerEvent::None:
+            return 0;
+        case TrackerEvent::Completed:
+            return 1;
+        case TrackerEvent::Started:
+            return 2;
+        case TrackerEvent::Stopped:
+            return 3;
+    }
+    return 0;
+}
+
+}  // anonymous namespace
+
+struct UdpTracker::Transaction {
+    udp::endpoint endpoint;
+    asio::steady_timer timer;
+    std::optional<std::vector<std::uint8_t>> reply;
+};
+
+UdpTracker::Channel::Channel(asio::io_context& io_context)
+    : socket(io_context, udp::endpoint(udp::v4(), 0)), buffer(kMaxPacketSize) {}
+
+UdpTracker::Tracker::Tracker(asio::io_context& io_context)
+    : connect_done(io_context, std::chrono::steady_clock::time_point::max()) {}
+
+UdpTracker::UdpTracker(asio::io_context& io_context, const Options& options)
+    : io_context_(io_context),
+      options_(options),
+      channel_(std::make_shared<Channel>(io_context)),
+      rng_(std::random_device{}()),
+      key_(static_cast<std::uint32_t>(rng_())) {}
+
+std::expected<TrackerResponse, TrackerError> UdpTracker::parse_response(std::span<const std::uint8_t> packet) {
+    if (is_error_reply(packet)) {
+        return std::unexpected(error_reply(packet));
+    }
+
+    if (packet.size() < kAnnounceHeaderSize || read_u32(packet.data()) != kActionAnnounce ||
+        (packet.size() - kAnnounceHeaderSize) % 6 != 0) {
+        spdlog::error("Invalid UDP tracker response: {} bytes", packet.size());
+        return std::unexpected(TrackerError::InvalidResponse);
+    }
+
+    TrackerResponse response{};
+    response.interval = std::chrono::seconds(read_u32(packet.data() + 8));
+    response.incomplete = read_u32(packet.data() + 12);
+    response.complete = read_u32(packet.data() + 16);
+
+    response.peers.reserve((packet.size() - kAnnounceHeaderSize) / 6);
+    for (std::size_t i = kAnnounceHeaderSize; i < packet.size(); i += 6) {
+        const auto* entry = packet.data() + i;
+        PeerInfo peer;
+        peer.ip = {entry[0], entry[1], entry[2], entry[3]};
+        peer.port = static_cast<std::uint16_t>((entry[4] << 8) | entry[5]);
+        response.peers.push_back(peer);
+    }
+
+    spdlog::info(
+        "Parsed tracker response: interval={}s, peers={}, seeders={}, leechers={}",
+        response.interval.count(),
+        response.peers.size(),
+        response.complete,
+        response.incomplete
+    );
+
+    return response;
+}
+
+std::expected<ScrapeResponse, TrackerError>
+UdpTracker::parse_scrape_response(std::span<const std::uint8_t> packet, std::span<const core::InfoHash> info_hashes) {
+    if (is_error_reply(packet)) {
+        return std::unexpected(error_reply(packet));
+    }
+
+    // Entries come back in request order; a tracker may stop early, but not add any.
+    if (packet.size() < kReplyHeaderSize || read_u32(packet.data()) != kActionScrape ||
+        (packet.size() - kReplyHeaderSize) % kScrapeEntrySize != 0 ||
+        (packet.size() - kReplyHeaderSize) / kScrapeEntrySize > info_hashes.size()) {
+        spdlog::error("Invalid UDP scrape response: {} bytes for {} info-hashes", packet.size(), info_hashes.size());
+        return std::unexpected(TrackerError::InvalidResponse);
+    }
+
+    ScrapeResponse response;
+    for (std::size_t i = 0; kReplyHeaderSize + i * kScrapeEntrySize < packet.size(); ++i) {
+        const auto* entry = packet.data() + kReplyHeaderSize + i * kScrapeEntrySize;
+        response[info_hashes[i]] = {read_u32(entry), read_u32(entry + 4), read_u32(entry + 8)};
+    }
+    return response;
+}
+
+asio::awaitable<std::expected<TrackerResponse, TrackerError>> UdpTracker::announce(
+    std::string_view announce_url,
+    const core::InfoHash& info_hash,
+    const core::PeerID& peer_id,
+    std::uint16_t port,
+    std::int64_t uploaded,
+    std::int64_t downloaded,
+    std::int64_t left,
+    TrackerEvent event
+) {
+    std::array<std::uint8_t, kAnnounceRequestSize> packet{};
+    std::memcpy(packet.data() + 16, info_hash.data(), info_hash.size());
+    std::memcpy(packet.data() + 36, peer_id.data(), peer_id.size());
+    write_u64(packet.data() + 56, static_cast<std::uint64_t>(downloaded));
+    write_u64(packet.data() + 64, static_cast<std::uint64_t>(left));
+    write_u64(packet.data() + 72, static_cast<std::uint64_t>(uploaded));
+    write_u32(packet.data() + 80, event_code(event));
+    write_u32(packet.data() + 88, key_);
+    write_u32(packet.data() + 92, static_cast<std::uint32_t>(-1));  // num_want: tracker default
+    write_u16(packet.data() + 96, port);
+
+    auto reply = co_await request(announce_url, packet, kActionAnnounce);
+    if (!reply) {
+        co_return std::unexpected(reply.error());
+    }
+    co_return parse_response(*reply);
+}
+
+asio::awaitable<std::expected<ScrapeResponse, TrackerError>>
+UdpTracker::scrape(std::string_view announce_url, std::span<const core::InfoHash> info_hashes) {
+    ScrapeResponse response;
+    for (std::size_t offset = 0; offset < info_hashes.size(); offset += kMaxScrapeHashes) {
+        const auto batch = info_hashes.subspan(offset, std::min(kMaxScrapeHashes, info_hashes.size() - offset));
+        std::vector<std::uint8_t> packet(kRequestHeaderSize + batch.size() * sizeof(core::InfoHash));
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            std::memcpy(packet.data() + kRequestHeaderSize + i * batch[i].size(), batch[i].data(), batch[i].size());
+        }
+
+        // Batches that succeeded are kept if a later one fails.
+        auto reply = co_await request(announce_url, packet, kActionScrape);
+        std::expected<ScrapeResponse, TrackerError> stats = std::unexpected(TrackerError::InvalidResponse);
+        if (reply) {
+            stats = parse_scrape_response(*reply, batch);
+        } else {
+            stats = std::unexpected(reply.error());
+        }
+        if (!stats) {
+            if (offset == 0) {
+                co_return std::unexpected(stats.error());
+            }
+            spdlog::warn(
+                "Scrape of {} stopped after {} of {} torrents: {}",
+                announce_url,
+                offset,
+                info_hashes.size(),
+                to_string(stats.error())
+            );
+            break;
+        }
+        response.merge(*stats);
+    }
+    co_return response;
+}
+
+void UdpTracker::shutdown() {
+    shut_down_ = true;
+    boost::system::error_code ec;
+    channel_->socket.close(ec);
+    for (auto& [id, transaction] : channel_->transactions) {
+        transaction->timer.cancel();
+    }
+    for (auto& [key, tracker] : trackers_) {
+        tracker.connect_done.cancel();
+    }
+}
+
+asio::awaitable<std::expected<std::vector<std::uint8_t>, TrackerError>>
+UdpTracker::request(std::string_view tracker_url, std::span<std::uint8_t> packet, std::uint32_t action) {
+    if (shut_down_) {
+        co_return std::unexpected(TrackerError::ConnectionFailed);
+    }
+    try {
+        auto parsed = boost::urls::parse_uri(tracker_url);
+        if (!parsed || !parsed->has_port()) {
+            spdlog::error("Failed to parse tracker URL: {}", tracker_url);
+            co_return std::unexpected(TrackerError::InvalidResponse);
+        }
+
+        const std::string host{parsed->host()};
+        const std::string port_str{parsed->port()};
+        auto* tracker = co_await lookup(host, port_str);
+
+        // A retransmission reuses its transaction ID, so a reply to an earlier copy still counts.
+        const auto connect_id = next_transaction_id();
+        const auto request_id = next_transaction_id();
+        write_u32(packet.data() + 8, action);
+        write_u32(packet.data() + 12, request_id);
+
+        for (int attempt = 0; attempt <= options_.max_retransmits; ++attempt) {
+            if (shut_down_) {
+                co_return std::unexpected(TrackerError::ConnectionFailed);
+            }
+            const auto timeout = options_.initial_timeout * (1 << attempt);
+
+            if (std::chrono::steady_clock::now() >= tracker->connection_expires) {
+                auto connected = co_await connect(*tracker, connect_id, timeout);
+                if (!connected && connected.error() == TrackerError::Timeout) {
+                    spdlog::debug("No connect reply from {}:{} within {}ms", host, port_str, timeout.count());
+                    continue;
+                }
+                if (!connected) {
+                    co_return std::unexpected(connected.error());
+                }
+            }
+
+            write_u64(packet.data(), tracker->connection_id);
+            const auto sent_expires = tracker->connection_expires;
+            const bool near_expiry =
+                sent_expires - std::chrono::steady_clock::now() < options_.connection_id_lifetime / 4;
+            auto reply = co_await exchange(tracker->endpoint, packet, request_id, timeout);
+            if (!reply) {
+                spdlog::debug("No reply from {}:{} within {}ms", host, port_str, timeout.count());
+                continue;
+            }
+            if (is_error_reply(*reply)) {
+                // The tracker may have expired an ID that was about to expire here anyway, or say it did; otherwise
+                // the error is about this request (an unregistered torrent, say) and the ID stays good for others.
+                if ((near_expiry || is_connection_error(*reply)) && tracker->connection_expires == sent_expires) {
+                    tracker->connection_expires = {};
+                }
+                co_return std::unexpected(error_reply(*reply));
+            }
+            co_return std::move(*reply);
+        }
+
+        // The tracker may have moved; resolve its name again next time.
+        tracker->connection_expires = {};
+        tracker->endpoint_expires = {};
+        spdlog::error("UDP tracker {}:{} did not answer", host, port_str);
+        co_return std::unexpected(TrackerError::Timeout);
+
+    } catch (const std::exception& e) {
+        spdlog::error("UDP tracker request failed: {}", e.what());
+        co_return std::unexpected(TrackerError::ConnectionFailed);
+    }
+}
+
+asio::awaitable<std::expected<void, TrackerError>>
+UdpTracker::connect(Tracker& tracker, std::uint32_t transaction_id, std::chrono::milliseconds timeout) {
+    if (tracker.connecting) {
+        boost::system::error_code ec;
+        co_await tracker.connect_done.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+        if (std::chrono::steady_clock::now() < tracker.connection_expires) {
+            co_return std::expected<void, TrackerError>{};
+        }
+        co_return std::unexpected(TrackerError::Timeout);
+    }
+
+    // The waiters are woken however the connect ends, exceptions included, and find the new ID or go on to retry.
+    // Not from a destructor: a frame destroyed with its io_context, rather than resumed, may outlive the tracker.
+    tracker.connecting = true;
+    std::expected<void, TrackerError> result = std::unexpected(TrackerError::Timeout);
+    std::exception_ptr failure;
+    try {
+        result = co_await send_connect(tracker, transaction_id, timeout);
+    } catch (...) {
+        failure = std::current_exception();
+    }
+    tracker.connecting = false;
+    tracker.connect_done.cancel();
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+    co_return result;
+}
+
+asio::awaitable<std::expected<void, TrackerError>>
+UdpTracker::send_connect(Tracker& tracker, std::uint32_t transaction_id, std::chrono::milliseconds timeout) {
+    std::array<std::uint8_t, kRequestHeaderSize> packet{};
+    write_u64(packet.data(), kProtocolId);
+    write_u32(packet.data() + 8, kActionConnect);
+    write_u32(packet.data() + 12, transaction_id);
+
+    ++connects_;
+    auto reply = co_await exchange(tracker.endpoint, packet, transaction_id, timeout);
+    if (!reply) {
+        co_return std::unexpected(TrackerError::Timeout);
+    }
+    if (is_error_reply(*reply)) {
+        co_return std::unexpected(error_reply(*reply));
+    }
+    if (reply->size() < kRequestHeaderSize || read_u32(reply->data()) != kActionConnect) {
+        spdlog::error("Invalid UDP tracker connect reply: {} bytes", reply->size());
+        co_return std::unexpected(TrackerError::InvalidResponse);
+    }
+    tracker.connection_id = read_u64(reply->data() + 8);
+    tracker.connection_expires = std::chrono::steady_clock::now() + options_.connection_id_lifetime;
+    co_return std::expected<void, TrackerError>{};
+}
+
+asio::awaitable<UdpTracker::Tracker*> UdpTracker::lookup(const std::string& host, const std::string& port) {
+    auto& tracker = trackers_.try_emplace(host + ":" + port, io_context_).first->second;
+    if (std::chrono::steady_clock::now() < tracker.endpoint_expires) {
+        co_return &tracker;
+    }
+
+    udp::resolver resolver(io_context_);
+    auto results = co_await resolver.async_resolve(udp::v4(), host, port, asio::use_awaitable);
+    const auto endpoint = results.begin()->endpoint();
+    if (endpoint != tracker.endpoint) {
+        tracker.endpoint = endpoint;
+        tracker.connection_expires = {};
+    }
+    tracker.endpoint_expires = std::chrono::steady_clock::now() + options_.dns_ttl;
+    co_return &tracker;
+}
+
+asio::awaitable<std::optional<std::vector<std::uint8_t>>> UdpTracker::exchange(
+    const udp::endpoint& endpoint,
+    std::span<const std::uint8_t> packet,
+    std::uint32_t transaction_id,
+    std::chrono::milliseconds timeout
+) {
+    Transaction transaction{endpoint, asio::steady_timer(io_context_), std::nullopt};
+    channel_->transactions[transaction_id] = &transaction;
+    if (!channel_->receiving) {
+        channel_->receiving = true;
+        asio::co_spawn(io_context_, receive_loop(channel_), asio::detached);
+    }
+
+    boost::system::error_code ec;
+    co_await channel_->socket.async_send_to(
+        asio::buffer(packet.data(), packet.size()), endpoint, asio::redirect_error(asio::use_awaitable, ec)
+    );
+    // The reply may already be in if the send completed late.
+    if (!ec && !transaction.reply) {
+        boost::system::error_code timer_ec;
+        transaction.timer.expires_after(timeout);
+        co_await transaction.timer.async_wait(asio::redirect_error(asio::use_awaitable, timer_ec));
+    }
+
+    channel_->transactions.erase(transaction_id);
+    if (channel_->transactions.empty()) {
+        // Nothing is waiting any more; wake the receive loop so it can stop holding the io_context open.
+        boost::system::error_code cancel_ec;
+        channel_->socket.cancel(cancel_ec);
+    }
+    if (ec) {
+        throw boost::system::system_error(ec);
+    }
+    co_return std::move(transaction.reply);
+}
+
+asio::awaitable<void> UdpTracker::receive_loop(std::shared_ptr<Channel> channel) {
+    udp::endpoint sender;
+    while (!channel->transactions.empty()) {
+        boost::system::error_code ec;
+        const auto size = co_await channel->socket.async_receive_from(
+            asio::buffer(channel->buffer), sender, asio::redirect_error(asio::use_awaitable, ec)
+        );
+        if (ec == asio::error::operation_aborted) {
+            continue;
+        }
+        if (ec) {
+            // ICMP errors for earlier sends surface here; the request they belong to times out on its own.
+            spdlog::debug("UDP tracker socket: {}", ec.message());
+            if (!channel->socket.is_open()) {
+                break;
+            }
+            continue;
+        }
+        if (size < 8) {
+            continue;
+        }
+
+        auto it = channel->transactions.find(read_u32(channel->buffer.data() + 4));
+        if (it == channel->transactions.end() || it->second->endpoint != sender) {
+            spdlog::debug("Dropping unexpected {} byte packet from {}", size, sender.address().to_string());
+            continue;
+        }
+        it->second->reply.emplace(channel->buffer.begin(), channel->buffer.begin() + size);
+        it->second->timer.cancel();
+    }
+    channel->receiving = false;
+}
+
+std::uint32_t UdpTracker::next_transaction_id() {
+    std::uint32_t id;
+    do {
+        id = static_cast<std::uint32_t>(rng_());
+    } while (channel_->transactions.contains(id));
+    return id;
+}
+
+}  // namespace bittorrent::network
@@ -1,18 +1,514 @@
 #include "bittorrent/utils/crypto.hpp"
 #include <openssl/sha.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define BITTORRENT_SHA1_X86 1
+#endif
 
 namespace bittorrent::utils {
 
+namespace {
+
+constexpr std::size_t kBlockSize = 64;
+
+constexpr std::array<std::uint32_t, 5> kInitialState = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+struct Kernel {
+    Sha1Kernel kind;
+    core::SHA1Hash (*hash)(std::string_view data) noexcept;
+    void (*hash_batch)(std::span<const std::string_view> inputs, std::span<core::SHA1Hash> digests) noexcept;
+    // Single-stream block function behind Sha1Hasher.
+    void (*compress)(std::uint32_t (&state)[5], const std::byte* blocks, std::size_t count) noexcept;
+};
+
+// The bytes after the last whole block: the remainder of the message, the 0x80 terminator, zero fill and the
+// big-endian bit length. One block, or two when the length no longer fits behind the remainder.
+struct PaddedTail {
+    alignas(32) std::array<std::byte, 2 * kBlockSize> bytes{};
+    std::size_t blocks;
+
+    explicit PaddedTail(std::string_view data) noexcept
+        : PaddedTail(data.substr(data.size() - data.size() % kBlockSize), data.size()) {}
+
+    // `remainder` is the partial block at the end of a `message_size`-byte message.
+    PaddedTail(std::string_view remainder, std::uint64_t message_size) noexcept {
+        std::copy(remainder.begin(), remainder.end(), reinterpret_cast<char*>(bytes.data()));
+        bytes[remainder.size()] = std::byte{0x80};
+        blocks = remainder.size() + 9 > kBlockSize ? 2 : 1;
+
+        auto bits = message_size * 8;
+        for (std::size_t i = 0; i < 8; ++i, bits >>= 8) {
+            bytes[blocks * kBlockSize - 1 - i] = static_cast<std::byte>(bits & 0xFF);
+        }
+    }
+};
+
+core::SHA1Hash to_digest(const std::uint32_t (&state)[5]) noexcept {
+    core::SHA1Hash digest;
+    for (std::size_t i = 0; i < 5; ++i) {
+        for (std::size_t j = 0; j < 4; ++j) {
+            digest[i * 4 + j] = static_cast<std::byte>(state[i] >> (24 - 8 * j));
+        }
+    }
+    return digest;
+}
+
+// Portable block function for Sha1Hasher on CPUs without the SHA extensions.
+void scalar_compress(std::uint32_t (&state)[5], const std::byte* blocks, std::size_t count) noexcept {
+    for (; count > 0; --count, blocks += kBlockSize) {
+        std::uint32_t w[16];
+        for (std::size_t i = 0; i < 16; ++i) {
+            w[i] = static_cast<std::uint32_t>(blocks[4 * i]) << 24 | static_cast<std::uint32_t>(blocks[4 * i + 1]) << 16 |
+                   static_cast<std::uint32_t>(blocks[4 * i + 2]) << 8 | static_cast<std::uint32_t>(blocks[4 * i + 3]);
+        }
+
+        std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        for (int t = 0; t < 80; ++t) {
+            if (t >= 16) {
+                w[t % 16] = std::rotl(w[(t - 3) % 16] ^ w[(t - 8) % 16] ^ w[(t - 14) % 16] ^ w[t % 16], 1);
+            }
+
+            std::uint32_t f;
+            std::uint32_t k;
+            if (t < 20) {
+                f = d ^ (b & (c ^ d));
+                k = 0x5A827999;
+            } else if (t < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (t < 60) {
+                f = (b & c) | (d & (b | c));
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+
+            const std::uint32_t temp = std::rotl(a, 5) + f + e + k + w[t % 16];
+            e = d;
+            d = c;
+            c = std::rotl(b, 30);
+            b = a;
+            a = temp;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+}
+
+core::SHA1Hash openssl_hash(std::string_view data) noexcept {
+    core::SHA1Hash digest;
+    static_assert(sizeof(digest) == SHA_DIGEST_LENGTH);
+    SHA1(reinterpret_cast<const unsigned char*>(data.data()), data.size(), reinterpret_cast<unsigned char*>(digest.data()));
+    return digest;
+}
+
+template <auto Hash>
+void hash_each(std::span<const std::string_view> inputs, std::span<core::SHA1Hash> digests) noexcept {
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        digests[i] = Hash(inputs[i]);
+    }
+}
+
+constexpr Kernel kOpenSsl{Sha1Kernel::OpenSsl, openssl_hash, hash_each<openssl_hash>, scalar_compress};
+
+#ifdef BITTORRENT_SHA1_X86
+
+// SHA extensions: each sha1rnds4 performs four rounds, with sha1msg1/sha1msg2 extending the message schedule
+// alongside. Step G covers rounds 4G..4G+3; the schedule for the last few steps is already complete, so their
+// message updates are dropped.
+template <int G>
+[[gnu::always_inline, gnu::target("sha,sse4.1,ssse3")]] inline void
+sha_ni_step(__m128i& abcd, __m128i (&e)[2], __m128i (&m)[4]) noexcept {
+    constexpr int cur = G % 4;
+    auto& next_e = e[G % 2];
+    if constexpr (G == 0) {
+        next_e = _mm_add_epi32(next_e, m[cur]);
+    } else {
+        next_e = _mm_sha1nexte_epu32(next_e, m[cur]);
+    }
+    e[(G + 1) % 2] = abcd;
+    if constexpr (G >= 3 && G <= 18) {
+        m[(G + 1) % 4] = _mm_sha1msg2_epu32(m[(G + 1) % 4], m[cur]);
+    }
+    abcd = _mm_sha1rnds4_epu32(abcd, next_e, G / 5);
+    if constexpr (G >= 1 && G <= 16) {
+        m[(G + 3) % 4] = _mm_sha1msg1_epu32(m[(G + 3) % 4], m[cur]);
+    }
+    if constexpr (G >= 2 && G <= 17) {
+        m[(G + 2) % 4] = _mm_xor_si128(m[(G + 2) % 4], m[cur]);
+    }
+}
+
+template <int... G>
+[[gnu::always_inline, gnu::target("sha,sse4.1,ssse3")]] inline void
+sha_ni_steps(__m128i& abcd, __m128i (&e)[2], __m128i (&m)[4], std::integer_sequence<int, G...>) noexcept {
+    (sha_ni_step<G + 4>(abcd, e, m), ...);
+}
+
+[[gnu::target("sha,sse4.1,ssse3")]] void
+sha_ni_compress(std::uint32_t (&state)[5], const std::byte* blocks, std::size_t count) noexcept {
+    const __m128i byte_swap = _mm_set_epi64x(0x0001020304050607LL, 0x08090A0B0C0D0E0FLL);
+
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1B);
+    __m128i e[2] = {_mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0), _mm_setzero_si128()};
+
+    for (; count > 0; --count, blocks += kBlockSize) {
+        const __m128i abcd_saved = abcd;
+        const __m128i e_saved = e[0];
+
+        __m128i m[4];
+        for (int i = 0; i < 4; ++i) {
+            m[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 16 * i)), byte_swap);
+        }
+        sha_ni_step<0>(abcd, e, m);
+        sha_ni_step<1>(abcd, e, m);
+        sha_ni_step<2>(abcd, e, m);
+        sha_ni_step<3>(abcd, e, m);
+        sha_ni_steps(abcd, e, m, std::make_integer_sequence<int, 16>{});
+
+        e[0] = _mm_sha1nexte_epu32(e[0], e_saved);
+        abcd = _mm_add_epi32(abcd, abcd_saved);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_shuffle_epi32(abcd, 0x1B));
+    state[4] = static_cast<std::uint32_t>(_mm_extract_epi32(e[0], 3));
+}
+
+core::SHA1Hash sha_ni_hash(std::string_view data) noexcept {
+    std::uint32_t state[5];
+    std::copy(kInitialState.begin(), kInitialState.end(), state);
+
+    const PaddedTail tail(data);
+    sha_ni_compress(state, reinterpret_cast<const std::byte*>(data.data()), data.size() / kBlockSize);
+    sha_ni_compress(state, tail.bytes.data(), tail.blocks);
+    return to_digest(state);
+}
+
+constexpr Kernel kShaNi{Sha1Kernel::ShaNi, sha_ni_hash, hash_each<sha_ni_hash>, sha_ni_compress};
+
+constexpr std::size_t kLanes = 8;
+
+template <int N>
+[[gnu::always_inline, gnu::target("avx2")]] inline __m256i rotl_lanes(__m256i x) noexcept {
+    return _mm256_or_si256(_mm256_slli_epi32(x, N), _mm256_srli_epi32(x, 32 - N));
+}
+
+// Turns eight rows of eight 32-bit words into eight columns, so word i of every lane ends up in rows[i].
+[[gnu::always_inline, gnu::target("avx2")]] inline void transpose(__m256i (&rows)[8]) noexcept {
+    __m256i t[8];
+    for (int i = 0; i < 4; ++i) {
+        t[2 * i] = _mm256_unpacklo_epi32(rows[2 * i], rows[2 * i + 1]);
+        t[2 * i + 1] = _mm256_unpackhi_epi32(rows[2 * i], rows[2 * i + 1]);
+    }
+    __m256i u[8] = {
+        _mm256_unpacklo_epi64(t[0], t[2]),
+        _mm256_unpackhi_epi64(t[0], t[2]),
+        _mm256_unpacklo_epi64(t[1], t[3]),
+        _mm256_unpackhi_epi64(t[1], t[3]),
+        _mm256_unpacklo_epi64(t[4], t[6]),
+        _mm256_unpackhi_epi64(t[4], t[6]),
+        _mm256_unpacklo_epi64(t[5], t[7]),
+        _mm256_unpackhi_epi64(t[5], t[7]),
+    };
+    for (int i = 0; i < 4; ++i) {
+        rows[i] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+        rows[i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+    }
+}
+
+// One block from each lane; lanes outside `active` run on whatever they are given and keep their state.
+[[gnu::target("avx2")]] void
+avx2_compress(__m256i (&state)[5], const std::byte* const (&blocks)[kLanes], __m256i active) noexcept {
+    const __m256i byte_swap = _mm256_set_epi8(
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3, 12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3
+    );
+
+    __m256i w[16];
+    for (int half = 0; half < 2; ++half) {
+        __m256i rows[8];
+        for (std::size_t lane = 0; lane < kLanes; ++lane) {
+            rows[lane] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blocks[lane] + 32 * half));
+        }
+        transpose(rows);
+        for (int i = 0; i < 8; ++i) {
+            w[8 * half + i] = _mm256_shuffle_epi8(rows[i], byte_swap);
+        }
+    }
+
+    __m256i a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+    for (int t = 0; t < 80; ++t) {
+        if (t >= 16) {
+            w[t % 16] = rotl_lanes<1>(_mm256_xor_si256(
+                _mm256_xor_si256(w[(t - 3) % 16], w[(t - 8) % 16]), _mm256_xor_si256(w[(t - 14) % 16], w[t % 16])
+            ));
+        }
+
+        __m256i f;
+        std::uint32_t k;
+        if (t < 20) {
+            f = _mm256_xor_si256(d, _mm256_and_si256(b, _mm256_xor_si256(c, d)));
+            k = 0x5A827999;
+        } else if (t < 40) {
+            f = _mm256_xor_si256(_mm256_xor_si256(b, c), d);
+            k = 0x6ED9EBA1;
+        } else if (t < 60) {
+            f = _mm256_or_si256(_mm256_and_si256(b, c), _mm256_and_si256(d, _mm256_or_si256(b, c)));
+            k = 0x8F1BBCDC;
+        } else {
+            f = _mm256_xor_si256(_mm256_xor_si256(b, c), d);
+            k = 0xCA62C1D6;
+        }
+
+        const __m256i temp = _mm256_add_epi32(
+            _mm256_add_epi32(rotl_lanes<5>(a), f),
+            _mm256_add_epi32(_mm256_add_epi32(e, _mm256_set1_epi32(static_cast<int>(k))), w[t % 16])
+        );
+        e = d;
+        d = c;
+        c = rotl_lanes<30>(b);
+        b = a;
+        a = temp;
+    }
+
+    const __m256i updated[5] = {a, b, c, d, e};
+    for (int i = 0; i < 5; ++i) {
+        state[i] = _mm256_blendv_epi8(state[i], _mm256_add_epi32(state[i], updated[i]), active);
+    }
+}
+
+// Hashes eight inputs in lockstep. Each lane walks its own whole blocks and then its padded tail; a lane that
+// has finished is masked off until the longest input is done.
+[[gnu::target("avx2")]] void avx2_hash_group(
+    std::span<const std::string_view> inputs,
+    std::span<core::SHA1Hash> digests
+) noexcept {
+    alignas(32) static constexpr std::array<std::byte, kBlockSize> kIdleBlock{};
+
+    struct Lane {
+        const std::byte* data{nullptr};
+        std::size_t whole_blocks{0};
+        std::size_t total_blocks{0};
+    };
+    std::array<Lane, kLanes> lanes;
+    std::array<std::optional<PaddedTail>, kLanes> tails;
+    std::size_t rounds = 0;
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        const auto& tail = tails[i].emplace(inputs[i]);
+        lanes[i].data = reinterpret_cast<const std::byte*>(inputs[i].data());
+        lanes[i].whole_blocks = inputs[i].size() / kBlockSize;
+        lanes[i].total_blocks = lanes[i].whole_blocks + tail.blocks;
+        rounds = std::max(rounds, lanes[i].total_blocks);
+    }
+
+    __m256i state[5];
+    for (int i = 0; i < 5; ++i) {
+        state[i] = _mm256_set1_epi32(static_cast<int>(kInitialState[i]));
+    }
+
+    for (std::size_t round = 0; round < rounds; ++round) {
+        const std::byte* blocks[kLanes];
+        alignas(32) std::int32_t active[kLanes];
+        for (std::size_t i = 0; i < kLanes; ++i) {
+            const auto& lane = lanes[i];
+            if (round < lane.whole_blocks) {
+                blocks[i] = lane.data + round * kBlockSize;
+            } else if (round < lane.total_blocks) {
+                blocks[i] = tails[i]->bytes.data() + (round - lane.whole_blocks) * kBlockSize;
+            } else {
+                blocks[i] = kIdleBlock.data();
+            }
+            active[i] = round < lane.total_blocks ? -1 : 0;
+        }
+        avx2_compress(state, blocks, _mm256_load_si256(reinterpret_cast<const __m256i*>(active)));
+    }
+
+    alignas(32) std::uint32_t words[5][kLanes];
+    for (int i = 0; i < 5; ++i) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(words[i]), state[i]);
+    }
+    for (std::size_t lane = 0; lane < inputs.size(); ++lane) {
+        std::uint32_t lane_state[5];
+        for (int i = 0; i < 5; ++i) {
+            lane_state[i] = words[i][lane];
+        }
+        digests[lane] = to_digest(lane_state);
+    }
+}
+
+// Each lane runs at a fraction of single-buffer speed, so only full groups of eight pay off; the leftovers and lone
+// buffers go to OpenSSL, which uses the SHA extensions itself when the CPU has them.
+void avx2_hash_batch(std::span<const std::string_view> inputs, std::span<core::SHA1Hash> digests) noexcept {
+    std::size_t first = 0;
+    for (; inputs.size() - first >= kLanes; first += kLanes) {
+        avx2_hash_group(inputs.subspan(first, kLanes), digests.subspan(first, kLanes));
+    }
+    hash_each<openssl_hash>(inputs.subspan(first), digests.subspan(first));
+}
+
+bool cpu_has_sha_extensions() noexcept {
+    unsigned eax, ebx, ecx, edx;
+    return __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & bit_SHA) != 0 &&
+           __builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("ssse3");
+}
+
+// Lanes only help across buffers; a single stream takes the SHA extensions when the CPU has them.
+void single_stream_compress(std::uint32_t (&state)[5], const std::byte* blocks, std::size_t count) noexcept {
+    static const auto compress = cpu_has_sha_extensions() ? sha_ni_compress : scalar_compress;
+    compress(state, blocks, count);
+}
+
+constexpr Kernel kAvx2{Sha1Kernel::Avx2, openssl_hash, avx2_hash_batch, single_stream_compress};
+
+#endif
+
+const Kernel* kernel_for(Sha1Kernel kind) noexcept {
+    switch (kind) {
+        case Sha1Kernel::OpenSsl:
+            return &kOpenSsl;
+#ifdef BITTORRENT_SHA1_X86
+        case Sha1Kernel::ShaNi:
+            return cpu_has_sha_extensions() ? &kShaNi : nullptr;
+        case Sha1Kernel::Avx2:
+            return __builtin_cpu_supports("avx2") ? &kAvx2 : nullptr;
+#else
+        default:
+            return nullptr;
+#endif
+    }
+    return nullptr;
+}
+
+// Eight AVX2 lanes out-run a single SHA-NI stream on full batches, and fall back to it for everything else.
+const Kernel* select_kernel() noexcept {
+    for (auto kind : {Sha1Kernel::Avx2, Sha1Kernel::ShaNi}) {
+        if (const auto* kernel = kernel_for(kind)) {
+            return kernel;
+        }
+    }
+    return &kOpenSsl;
+}
+
+std::atomic<const Kernel*>& active_kernel() noexcept {
+    static std::atomic<const Kernel*> kernel{select_kernel()};
+    return kernel;
+}
+
+}  // anonymous namespace
+
+Sha1Hasher::Sha1Hasher() noexcept : compress_(active_kernel().load(std::memory_order_relaxed)->compress) {
+    reset();
+}
+
+void Sha1Hasher::reset() noexcept {
+    std::copy(kInitialState.begin(), kInitialState.end(), state_);
+    size_ = 0;
+}
+
+Sha1Hasher& Sha1Hasher::update(std::span<const std::byte> data) noexcept {
+    auto buffered = static_cast<std::size_t>(size_ % kBlockSize);
+    size_ += data.size();
+
+    if (buffered > 0) {
+        const auto take = std::min(kBlockSize - buffered, data.size());
+        std::copy_n(data.begin(), take, buffer_.begin() + buffered);
+        data = data.subspan(take);
+        if (buffered + take < kBlockSize) {
+            return *this;
+        }
+        compress_(state_, buffer_.data(), 1);
+    }
+
+    // Whole blocks are hashed straight from the caller's memory.
+    const auto blocks = data.size() / kBlockSize;
+    compress_(state_, data.data(), blocks);
+    data = data.subspan(blocks * kBlockSize);
+    std::copy(data.begin(), data.end(), buffer_.begin());
+    return *this;
+}
+
+Sha1Hasher& Sha1Hasher::update(std::string_view data) noexcept {
+    return update(std::as_bytes(std::span(data)));
+}
+
+core::SHA1Hash Sha1Hasher::finalize() const noexcept {
+    std::uint32_t state[5];
+    std::copy(state_, state_ + 5, state);
+
+    const PaddedTail tail(
+        {reinterpret_cast<const char*>(buffer_.data()), static_cast<std::size_t>(size_ % kBlockSize)}, size_
+    );
+    compress_(state, tail.bytes.data(), tail.blocks);
+    return to_digest(state);
+}
+
 core::SHA1Hash sha1(std::string_view data) {
-    unsigned char hash[SHA_DIGEST_LENGTH];
-    SHA1(reinterpret_cast<const unsigned char*>(data.data()), data.size(), hash);
+    return active_kernel().load(std::memory_order_relaxed)->hash(data);
+}
+
+void sha1_batch(std::span<const std::string_view> inputs, std::span<core::SHA1Hash> digests) {
+    active_kernel().load(std::memory_order_relaxed)->hash_batch(inputs, digests.first(inputs.size()));
+}
+
+std::vector<core::SHA1Hash> sha1_batch(std::span<const std::string_view> inputs) {
+    std::vector<core::SHA1Hash> digests(inputs.size());
+    sha1_batch(inputs, digests);
+    return digests;
+}
+
+core::SHA256Hash sha256(std::string_view data) {
+    core::SHA256Hash digest;
+    static_assert(sizeof(digest) == SHA256_DIGEST_LENGTH);
+    SHA256(
+        reinterpret_cast<const unsigned char*>(data.data()),
+        data.size(),
+        reinterpret_cast<unsigned char*>(digest.data())
+    );
+    return digest;
+}
 
-    core::SHA1Hash result;
-    for (size_t i = 0; i < SHA_DIGEST_LENGTH; ++i) {
-        result[i] = static_cast<std::byte>(hash[i]);
+void sha256_batch(std::span<const std::string_view> inputs, std::span<core::SHA256Hash> digests) {
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        digests[i] = sha256(inputs[i]);
     }
+}
 
-    return result;
+core::SHA256Hash sha256_pair(const core::SHA256Hash& left, const core::SHA256Hash& right) {
+    std::array<std::byte, 2 * sizeof(core::SHA256Hash)> joined;
+    std::copy(left.begin(), left.end(), joined.begin());
+    std::copy(right.begin(), right.end(), joined.begin() + left.size());
+    return sha256({reinterpret_cast<const char*>(joined.data()), joined.size()});
+}
+
+Sha1Kernel active_sha1_kernel() noexcept {
+    return active_kernel().load(std::memory_order_relaxed)->kind;
+}
+
+bool is_sha1_kernel_supported(Sha1Kernel kernel) noexcept {
+    return kernel_for(kernel) != nullptr;
+}
+
+bool force_sha1_kernel(Sha1Kernel kernel) noexcept {
+    const auto* selected = kernel_for(kernel);
+    if (!selected) {
+        return false;
+    }
+    active_kernel().store(selected, std::memory_order_relaxed);
+    return true;
 }
 
 }  // namespace bittorrent::utils
@@ -0,0 +1,125 @@
+#include "bittorrent/utils/mapped_file.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <utility>
+
+namespace bittorrent::utils {
+
+namespace {
+
+std::error_code last_error() noexcept {
+    return {errno, std::generic_category()};
+}
+
+// Closes the descriptor on every exit path; a mapping outlives it.
+class FileDescriptor {
+public:
+    explicit FileDescriptor(int fd) noexcept : fd_(fd) {}
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+    ~FileDescriptor() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    int get() const noexcept { return fd_; }
+
+private:
+    int fd_;
+};
+
+std::expected<void, std::error_code> read_all(int fd, std::vector<char>& buffer, std::size_t size_hint) {
+    buffer.resize(std::max<std::size_t>(size_hint, 4096));
+    std::size_t used = 0;
+    while (true) {
+        if (used == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+        }
+        const ssize_t count = ::read(fd, buffer.data() + used, buffer.size() - used);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return std::unexpected(last_error());
+        }
+        if (count == 0) {
+            break;
+        }
+        used += static_cast<std::size_t>(count);
+    }
+    buffer.resize(used);
+    return {};
+}
+
+}  // anonymous namespace
+
+std::expected<MappedFile, std::error_code> MappedFile::open(const std::filesystem::path& path) {
+    FileDescriptor fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    if (fd.get() < 0) {
+        return std::unexpected(last_error());
+    }
+
+    struct stat info {};
+    if (::fstat(fd.get(), &info) != 0) {
+        return std::unexpected(last_error());
+    }
+
+    MappedFile file;
+    const auto size = static_cast<std::size_t>(info.st_size);
+
+    if (!S_ISREG(info.st_mode) || size < kMapThreshold) {
+        if (auto result = read_all(fd.get(), file.buffer_, size + 1); !result) {
+            return std::unexpected(result.error());
+        }
+        return file;
+    }
+
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif
+    void* mapping = ::mmap(nullptr, size, PROT_READ, flags, fd.get(), 0);
+    if (mapping == MAP_FAILED) {
+        return std::unexpected(last_error());
+    }
+    // Advisory only; a failure leaves the mapping usable.
+    ::madvise(mapping, size, MADV_SEQUENTIAL);
+
+    file.mapping_ = mapping;
+    file.size_ = size;
+    return file;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : mapping_(std::exchange(other.mapping_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      buffer_(std::move(other.buffer_)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        mapping_ = std::exchange(other.mapping_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        buffer_ = std::move(other.buffer_);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    unmap();
+}
+
+void MappedFile::unmap() noexcept {
+    if (mapping_) {
+        ::munmap(mapping_, size_);
+        mapping_ = nullptr;
+        size_ = 0;
+    }
+}
+
+}  // namespace bittorrent::utils
@@ -0,0 +1,88 @@
+#include "bittorrent/utils/timer_wheel.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace bittorrent::utils {
+
+void TimerWheel::schedule(Id id, std::uint64_t delay) {
+    if (id >= nodes_.size()) {
+        nodes_.resize(static_cast<std::size_t>(id) + 1);
+    }
+    if (scheduled(id)) {
+        unlink(id);
+    } else {
+        ++size_;
+    }
+    nodes_[id].expires = now_ + std::clamp<std::uint64_t>(delay, 1, kMaxDelay);
+    link(id);
+}
+
+void TimerWheel::cancel(Id id) noexcept {
+    if (scheduled(id)) {
+        unlink(id);
+        --size_;
+    }
+}
+
+void TimerWheel::advance(std::vector<Id>& due) {
+    ++now_;
+
+    // At the start of each block of a coarser level, its timers for that block move down; coarsest first, so a
+    // timer can fall through several levels in one tick.
+    for (std::size_t level = kLevels - 1; level > 0; --level) {
+        const auto shift = kSlotBits * level;
+        if ((now_ & ((std::uint64_t{1} << shift) - 1)) != 0) {
+            continue;
+        }
+        const auto slot = level * kSlots + ((now_ >> shift) & (kSlots - 1));
+        auto id = std::exchange(heads_[slot], kNone);
+        while (id != kNone) {
+            const auto next = nodes_[id].next;
+            link(id);
+            id = next;
+        }
+    }
+
+    auto id = std::exchange(heads_[now_ & (kSlots - 1)], kNone);
+    while (id != kNone) {
+        auto& node = nodes_[id];
+        const auto next = node.next;
+        node.slot = kNone;
+        --size_;
+        due.push_back(id);
+        id = next;
+    }
+}
+
+void TimerWheel::link(Id id) noexcept {
+    auto& node = nodes_[id];
+    const auto delta = node.expires - now_;
+    std::size_t level = 0;
+    while (level + 1 < kLevels && delta >= (std::uint64_t{1} << (kSlotBits * (level + 1)))) {
+        ++level;
+    }
+
+    const auto slot = static_cast<Id>(level * kSlots + ((node.expires >> (kSlotBits * level)) & (kSlots - 1)));
+    node.slot = slot;
+    node.prev = kNone;
+    node.next = heads_[slot];
+    if (node.next != kNone) {
+        nodes_[node.next].prev = id;
+    }
+    heads_[slot] = id;
+}
+
+void TimerWheel::unlink(Id id) noexcept {
+    auto& node = nodes_[id];
+    if (node.prev != kNone) {
+        nodes_[node.prev].next = node.next;
+    } else {
+        heads_[node.slot] = node.next;
+    }
+    if (node.next != kNone) {
+        nodes_[node.next].prev = node.prev;
+    }
+    node.prev = node.next = node.slot = kNone;
+}
+
+}  // namespace bittorrent::utils
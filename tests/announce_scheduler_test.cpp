@@ -0,0 +1,278 @@
+#include <gtest/gtest.h>
+#include <boost/asio/io_context.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "bittorrent/core.hpp"
+#include "bittorrent/network.hpp"
+#include "local_udp_tracker.hpp"
+
+using namespace bittorrent;
+
+namespace {
+
+namespace asio = boost::asio;
+using test::LocalUdpTracker;
+using test::run;
+
+// Nothing listens on port 1, so connecting there fails at once.
+constexpr std::string_view kRefusingTracker = "http://127.0.0.1:1/announce";
+
+network::AnnounceScheduler::Options fast_options() {
+    auto options = network::AnnounceScheduler::kDefaultOptions;
+    options.tick = std::chrono::milliseconds(5);
+    options.jitter = 0.0;
+    options.min_reannounce = std::chrono::milliseconds(100);
+    return options;
+}
+
+core::InfoHash info_hash(std::size_t n) {
+    core::InfoHash hash{};
+    hash[0] = static_cast<std::byte>(n);
+    return hash;
+}
+
+}  // anonymous namespace
+
+TEST(AnnounceSchedulerTest, AnnouncesToOneHostShareAConnection) {
+    asio::io_context io_context;
+    LocalUdpTracker server(io_context);
+    network::HttpTracker http(io_context);
+    network::UdpTracker udp(io_context);
+    auto options = fast_options();
+    options.max_in_flight_per_host = 1;
+
+    std::size_t succeeded = 0;
+    std::size_t failed = 0;
+    network::AnnounceScheduler* scheduler_ptr = nullptr;
+    network::AnnounceScheduler scheduler(
+        io_context, http, udp,
+        [&](network::AnnounceScheduler::TorrentId, const network::AnnounceScheduler::Result& result) {
+            ++(result ? succeeded : failed);
+            if (succeeded + failed == 20) {
+                scheduler_ptr->stop();
+            }
+        },
+        options
+    );
+    scheduler_ptr = &scheduler;
+    for (std::size_t i = 0; i < 20; ++i) {
+        scheduler.add(server.url(), info_hash(i), core::PeerID{}, 6881, 1000);
+    }
+
+    run(io_context, scheduler.run());
+
+    EXPECT_EQ(succeeded, 20);
+    EXPECT_EQ(server.announces(), 20);
+    EXPECT_EQ(udp.connects_sent(), 1);
+}
+
+TEST(AnnounceSchedulerTest, ReannouncesAfterInterval) {
+    asio::io_context io_context;
+    LocalUdpTracker server(io_context);
+    server.set_interval(1);
+    network::HttpTracker http(io_context);
+    network::UdpTracker udp(io_context);
+
+    std::vector<std::chrono::steady_clock::time_point> answers;
+    network::AnnounceScheduler* scheduler_ptr = nullptr;
+    network::AnnounceScheduler scheduler(
+        io_context, http, udp,
+        [&](network::AnnounceScheduler::TorrentId, const network::AnnounceScheduler::Result& result) {
+            EXPECT_TRUE(result.has_value());
+            answers.push_back(std::chrono::steady_clock::now());
+            if (answers.size() == 2) {
+                scheduler_ptr->stop();
+            }
+        },
+        fast_options()
+    );
+    scheduler_ptr = &scheduler;
+    scheduler.add(server.url(), info_hash(1), core::PeerID{}, 6881, 1000);
+
+    run(io_context, scheduler.run());
+
+    ASSERT_EQ(answers.size(), 2);
+    EXPECT_GE(answers[1] - answers[0], std::chrono::milliseconds(990));
+    EXPECT_EQ(server.last_event(), 0);  // started only once
+}
+
+TEST(AnnounceSchedulerTest, SendsCompletedWithoutWaitingForInterval) {
+    asio::io_context io_context;
+    LocalUdpTracker server(io_context);
+    network::HttpTracker http(io_context);
+    network::UdpTracker udp(io_context);
+
+    std::size_t answers = 0;
+    network::AnnounceScheduler* scheduler_ptr = nullptr;
+    network::AnnounceScheduler scheduler(
+        io_context, http, udp,
+        [&](network::AnnounceScheduler::TorrentId id, const network::AnnounceScheduler::Result&) {
+            if (++answers == 1) {
+                scheduler_ptr->update(id, 0, 1000, 0);
+                scheduler_ptr->completed(id);
+            } else {
+                scheduler_ptr->stop();
+            }
+        },
+        fast_options()
+    );
+    scheduler_ptr = &scheduler;
+    scheduler.add(server.url(), info_hash(1), core::PeerID{}, 6881, 1000);
+
+    run(io_context, scheduler.run());
+
+    EXPECT_EQ(answers, 2);
+    EXPECT_EQ(server.last_event(), 1);
+}
+
+TEST(AnnounceSchedulerTest, HoldsCompletedUntilStartedGoesThrough) {
+    asio::io_context io_context;
+    LocalUdpTracker server(io_context);
+    network::HttpTracker http(io_context);
+    network::UdpTracker udp(io_context);
+
+    std::vector<std::uint32_t> events;
+    network::AnnounceScheduler* scheduler_ptr = nullptr;
+    network::AnnounceScheduler scheduler(
+        io_context, http, udp,
+        [&](network::AnnounceScheduler::TorrentId, const network::AnnounceScheduler::Result&) {
+            events.push_back(server.last_event());
+            if (events.size() == 2) {
+                scheduler_ptr->stop();
+            }
+        },
+        fast_options()
+    );
+    scheduler_ptr = &scheduler;
+    const auto id = scheduler.add(server.url(), info_hash(1), core::PeerID{}, 6881, 0);
+    scheduler.completed(id);
+
+    run(io_context, scheduler.run());
+
+    EXPECT_EQ(events, (std::vector<std::uint32_t>{2, 1}));  // started, then completed
+}
+
+TEST(AnnounceSchedulerTest, BacksOffUnreachableHostAsAWhole) {
+    asio::io_context io_context;
+    network::HttpTracker http(io_context);
+    network::UdpTracker udp(io_context);
+    auto options = fast_options();
+    options.max_in_flight_per_host = 1;
+    options.initial_backoff = std::chrono::milliseconds(20);
+    options.max_backoff = std::chrono::milliseconds(80);
+
+    std::size_t failures = 0;
+    network::AnnounceScheduler* scheduler_ptr = nullptr;
+    network::AnnounceScheduler scheduler(
+        io_context, http, udp,
+        [&](network::AnnounceScheduler::TorrentId, const network::AnnounceScheduler::Result& result) {
+            EXPECT_FALSE(result.has_value());
+            if (++failures == 4) {
+                scheduler_ptr->stop();
+            }
+        },
+        options
+    );
+    scheduler_ptr = &scheduler;
+    scheduler.add(std::string(kRefusingTracker), info_hash(1), core::PeerID{}, 6881, 1000);
+    scheduler.add(std::string(kRefusingTracker), info_hash(2), core::PeerID{}, 6881, 1000);
+
+    // One failure per backoff, whichever torrent goes first: 20 + 40 + 80 ms between the four.
+    const auto start = std::chrono::steady_clock::now();
+    run(io_context, scheduler.run());
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(failures, 4);
+    EXPECT_GE(elapsed, std::chrono::milliseconds(140));
+}
+
+TEST(AnnounceSchedulerTest, RemoveSendsStopped) {
+    asio::io_context io_context;
+    LocalUdpTracker server(io_context);
+    network::HttpTracker http(io_context);
+    network::UdpTracker udp(io_context);
+
+    network::AnnounceScheduler* scheduler_ptr = nullptr;
+    network::AnnounceScheduler scheduler(
+        io_context, http, udp,
+        [&](network::AnnounceScheduler::TorrentId id, const network::AnnounceScheduler::Result&) {
+            scheduler_ptr->remove(id);
+            scheduler_ptr->stop();
+        },
+        fast_options()
+    );
+    scheduler_ptr = &scheduler;
+    const auto never_announced = scheduler.add(server.url(), info_hash(2), core::PeerID{}, 6881, 1000);
+    scheduler.remove(never_announced);
+    scheduler.add(server.url(), info_hash(1), core::PeerID{}, 6881, 1000);
+
+    run(io_context, scheduler.run());
+
+    EXPECT_EQ(server.announces(), 2);
+    EXPECT_EQ(server.last_event(), 3);
+    EXPECT_EQ(scheduler.size(), 0);
+}
+
+TEST(AnnounceSchedulerTest, ReannounceDelayHonoursMinInterval) {
+    using network::AnnounceScheduler;
+    constexpr auto floor = std::chrono::seconds(60);
+    network::TrackerResponse response;
+    response.interval = std::chrono::seconds(1800);
+    EXPECT_EQ(AnnounceScheduler::reannounce_delay(response, 0.0, floor), std::chrono::seconds(1800));
+    EXPECT_EQ(AnnounceScheduler::reannounce_delay(response, 0.1, floor), std::chrono::seconds(1620));
+
+    response.min_interval = std::chrono::seconds(1700);
+    EXPECT_EQ(AnnounceScheduler::reannounce_delay(response, 0.1, floor), std::chrono::seconds(1700));
+}
+
+TEST(AnnounceSchedulerTest, ReannounceDelayIsBounded) {
+    using network::AnnounceScheduler;
+    constexpr auto floor = std::chrono::seconds(60);
+    network::TrackerResponse response;
+    response.interval = std::chrono::seconds(0);
+    EXPECT_EQ(AnnounceScheduler::reannounce_delay(response, 0.0, floor), floor);
+
+    response.interval = std::chrono::seconds(-5);
+    EXPECT_EQ(AnnounceScheduler::reannounce_delay(response, 0.1, floor), floor);
+
+    response.interval = std::chrono::seconds(std::numeric_limits<std::int64_t>::max());
+    EXPECT_EQ(AnnounceScheduler::reannounce_delay(response, 0.0, floor), AnnounceScheduler::kMaxReannounce);
+
+    response.interval = std::chrono::seconds(0);
+    response.min_interval = std::chrono::seconds(std::numeric_limits<std::int64_t>::max());
+    EXPECT_EQ(AnnounceScheduler::reannounce_delay(response, 0.0, floor), AnnounceScheduler::kMaxReannounce);
+}
+
+TEST(AnnounceSchedulerTest, ZeroIntervalDoesNotFloodTracker) {
+    asio::io_context io_context;
+    LocalUdpTracker server(io_context);
+    server.set_interval(0);
+    network::HttpTracker http(io_context);
+    network::UdpTracker udp(io_context);
+
+    std::size_t answers = 0;
+    network::AnnounceScheduler* scheduler_ptr = nullptr;
+    network::AnnounceScheduler scheduler(
+        io_context, http, udp,
+        [&](network::AnnounceScheduler::TorrentId, const network::AnnounceScheduler::Result&) {
+            if (++answers == 3) {
+                scheduler_ptr->stop();
+            }
+        },
+        fast_options()
+    );
+    scheduler_ptr = &scheduler;
+    scheduler.add(server.url(), info_hash(1), core::PeerID{}, 6881, 1000);
+
+    // Held to the 100 ms floor rather than re-announcing every 5 ms tick.
+    const auto start = std::chrono::steady_clock::now();
+    run(io_context, scheduler.run());
+
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(200));
+    EXPECT_EQ(server.announces(), 3);
+}
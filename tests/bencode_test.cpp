@@ -1,5 +1,9 @@
 #include "bittorrent/bencode.hpp"
 #include <gtest/gtest.h>
+#include <iterator>
+#include <optional>
+#include <sstream>
+#include <vector>
 
 using namespace bittorrent::bencode;
 
@@ -262,6 +266,54 @@ TEST(BencodeEncoder, EncodeEmptyDictionary) {
     EXPECT_EQ(Encoder::encode(value), "de");
 }
 
+TEST(BencodeEncoder, EncodedSizeIsExact) {
+    for (std::string_view original : {"i0e", "i-9223372036854775808e", "0:", "le", "de",
+                                      "d4:listli1ei-22ee6:nestedd3:key10:0123456789e6:numberi42ee"}) {
+        auto parsed = Parser::parse_view(original);
+        ASSERT_TRUE(parsed.has_value()) << original;
+        EXPECT_EQ(Encoder::encoded_size(*parsed), original.size()) << original;
+    }
+}
+
+TEST(BencodeEncoder, EncodeToBufferTargets) {
+    const std::string original = "d4:listli1ei2ee6:nestedd3:key5:valuee6:numberi42ee";
+    auto parsed = Parser::parse(original);
+    ASSERT_TRUE(parsed.has_value());
+
+    std::string appended = "prefix";
+    Encoder::encode_to(appended, *parsed);
+    EXPECT_EQ(appended, "prefix" + original);
+
+    std::string buffer(original.size(), '\0');
+    auto written = Encoder::encode_to(std::span<char>(buffer), *parsed);
+    ASSERT_TRUE(written.has_value());
+    EXPECT_EQ(*written, original.size());
+    EXPECT_EQ(buffer, original);
+
+    std::string small(original.size() - 1, '#');
+    auto failed = Encoder::encode_to(std::span<char>(small), *parsed);
+    ASSERT_FALSE(failed.has_value());
+    EXPECT_EQ(failed.error(), EncodeError::BufferTooSmall);
+    EXPECT_EQ(small, std::string(original.size() - 1, '#'));
+
+    std::vector<char> chars;
+    Encoder::encode_to(std::back_inserter(chars), *parsed);
+    EXPECT_EQ(std::string_view(chars.data(), chars.size()), original);
+}
+
+TEST(BencodeEncoder, EncodeToStreamSpillsLargeStrings) {
+    List list;
+    list.emplace_back(String(10000, 'x'));
+    list.emplace_back(Integer{7});
+    list.emplace_back(String(4090, 'y'));
+    Value value{std::move(list)};
+
+    std::ostringstream stream;
+    Encoder::encode_to(stream, value);
+    EXPECT_EQ(stream.str(), Encoder::encode(value));
+    EXPECT_EQ(stream.str().size(), Encoder::encoded_size(value));
+}
+
 TEST(BencodeRoundTrip, IntegerRoundTrip) {
     std::string original = "i12345e";
     auto parsed = Parser::parse(original);
@@ -319,3 +371,390 @@ TEST(BencodeParser, HandleUTF8String) {
     ASSERT_TRUE(result->is_string());
     EXPECT_EQ(result->as_string(), "Hello 世界");
 }
+
+TEST(BencodeParserView, StringsBorrowFromInput) {
+    std::string input = "l4:spam4:eggse";
+    auto result = Parser::parse_view(input);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_TRUE(result->is_list());
+    const auto& list = result->as_list();
+    ASSERT_EQ(list.size(), 2);
+    EXPECT_EQ(list[0].as_string(), "spam");
+    EXPECT_EQ(list[0].as_string().data(), input.data() + 3);
+    EXPECT_EQ(list[1].as_string().data(), input.data() + 9);
+}
+
+TEST(BencodeParserView, ParseNestedDictionary) {
+    std::string input = "d4:infod4:name4:Johne5:valuei42ee";
+    auto result = Parser::parse_view(input);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_TRUE(result->is_dictionary());
+    const auto& dict = result->as_dictionary();
+    ASSERT_TRUE(dict.at("info").is_dictionary());
+    EXPECT_EQ(dict.at("info").as_dictionary().at("name").as_string(), "John");
+    EXPECT_EQ(dict.at("value").as_integer(), 42);
+}
+
+TEST(BencodeParserView, RejectsSameErrorsAsOwningParser) {
+    EXPECT_EQ(Parser::parse_view("i042e").error(), ParseError::InvalidInteger);
+    EXPECT_EQ(Parser::parse_view("10:spam").error(), ParseError::UnexpectedEnd);
+    EXPECT_EQ(Parser::parse_view("d4:spam4:eggs3:cow3:mooe").error(), ParseError::InvalidFormat);
+}
+
+TEST(BencodeParserView, RoundTrip) {
+    std::string original = "d4:listli1ei2ee6:nestedd3:key5:valuee6:numberi42e6:string4:teste";
+    auto parsed = Parser::parse_view(original);
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_EQ(Encoder::encode(*parsed), original);
+}
+
+TEST(BencodeTape, ParseScalars) {
+    auto integer = Tape::parse("i-42e");
+    ASSERT_TRUE(integer.has_value());
+    EXPECT_TRUE(integer->root().is_integer());
+    EXPECT_EQ(integer->root().as_integer(), -42);
+
+    auto string = Tape::parse("4:spam");
+    ASSERT_TRUE(string.has_value());
+    EXPECT_EQ(string->root().as_string(), "spam");
+    EXPECT_EQ(string->root().encoded(), "4:spam");
+}
+
+TEST(BencodeTape, NavigateNestedContainers) {
+    std::string input = "d4:infod6:lengthi10e4:name4:Johne4:listli1e3:fooee";
+    auto tape = Tape::parse(input);
+    ASSERT_TRUE(tape.has_value());
+    EXPECT_EQ(tape->tokens().size(), 11);
+
+    auto root = tape->root();
+    ASSERT_TRUE(root.is_dictionary());
+    EXPECT_EQ(root.size(), 2);
+
+    auto info = root.find("info");
+    ASSERT_TRUE(info.has_value());
+    EXPECT_EQ(info->encoded(), "d6:lengthi10e4:name4:Johne");
+    EXPECT_EQ(info->find("name")->as_string(), "John");
+    EXPECT_EQ(info->find("length")->as_integer(), 10);
+    EXPECT_FALSE(info->find("missing").has_value());
+
+    auto list = root.find("list");
+    ASSERT_TRUE(list.has_value() && list->is_list());
+    std::vector<std::string_view> encoded;
+    for (auto item : list->as_list()) {
+        encoded.push_back(item.encoded());
+    }
+    EXPECT_EQ(encoded, (std::vector<std::string_view>{"i1e", "3:foo"}));
+}
+
+TEST(BencodeTape, SkipIndexJumpsOverSubtree) {
+    auto tape = Tape::parse("lld1:ai1eeei7ee");
+    ASSERT_TRUE(tape.has_value());
+    const auto tokens = tape->tokens();
+    ASSERT_EQ(tokens.size(), 6);
+    EXPECT_EQ(tokens[1].next, 5);
+    EXPECT_EQ(tokens[5].type, TokenType::Integer);
+    EXPECT_EQ(tape->root().size(), 2);
+}
+
+TEST(BencodeTape, RejectsSameErrorsAsParser) {
+    EXPECT_EQ(Tape::parse("").error(), ParseError::UnexpectedEnd);
+    EXPECT_EQ(Tape::parse("i042e").error(), ParseError::InvalidInteger);
+    EXPECT_EQ(Tape::parse("i-0e").error(), ParseError::InvalidInteger);
+    EXPECT_EQ(Tape::parse("10:spam").error(), ParseError::UnexpectedEnd);
+    EXPECT_EQ(Tape::parse("li1ei2e").error(), ParseError::UnexpectedEnd);
+    EXPECT_EQ(Tape::parse("d4:spam4:eggs3:cow3:mooe").error(), ParseError::InvalidFormat);
+    EXPECT_EQ(Tape::parse("di42e5:valuee").error(), ParseError::InvalidFormat);
+    EXPECT_EQ(Tape::parse("d3:cowe").error(), ParseError::UnexpectedCharacter);
+}
+
+TEST(BencodeTape, TypeMismatchThrows) {
+    auto tape = Tape::parse("i1e");
+    ASSERT_TRUE(tape.has_value());
+    EXPECT_THROW(tape->root().as_string(), std::bad_variant_access);
+}
+
+TEST(BencodeScan, KernelsAgreeWithScalar) {
+    std::string input;
+    for (int i = 0; i < 300; ++i) {
+        input += std::to_string(i * 7919);
+        input += (i % 3 == 0) ? ':' : 'e';
+        input += std::string(static_cast<std::size_t>(i % 37), 'x');
+    }
+
+    const auto original = active_scan_kernel();
+    for (auto kernel : {ScanKernel::Scalar, ScanKernel::Sse2, ScanKernel::Avx2}) {
+        if (!force_scan_kernel(kernel)) {
+            continue;
+        }
+        for (std::size_t pos = 0; pos <= input.size(); ++pos) {
+            std::size_t digits = pos;
+            while (digits < input.size() && input[digits] >= '0' && input[digits] <= '9') {
+                ++digits;
+            }
+            ASSERT_EQ(scan_digits(input, pos), digits) << to_string(kernel) << " at " << pos;
+            ASSERT_EQ(scan_for(input, pos, 'e'), std::min(input.find('e', pos), input.size()))
+                << to_string(kernel) << " at " << pos;
+        }
+    }
+    force_scan_kernel(original);
+}
+
+TEST(BencodeScan, LongDigitRunsAcrossVectorWidth) {
+    std::string input = "i" + std::string(70, '7') + "e";
+    EXPECT_EQ(scan_digits(input, 1), 71);
+    EXPECT_EQ(scan_for(input, 0, 'e'), 71);
+    EXPECT_EQ(Parser::parse(input).error(), ParseError::InvalidInteger);
+}
+
+namespace {
+
+class CountingResource : public std::pmr::memory_resource {
+public:
+    std::size_t allocations{0};
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+}  // anonymous namespace
+
+TEST(BencodeParserArena, AllNodesComeFromResource) {
+    std::string original = "d4:listli1ei2ee6:nestedd3:key29:a string too long for the SSOe6:numberi42ee";
+
+    CountingResource counting;
+    auto parsed = Parser::parse(original, &counting);
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_GT(counting.allocations, 0);
+
+    const auto& dict = parsed->as_dictionary();
+    EXPECT_EQ(dict.get_allocator().resource(), &counting);
+    EXPECT_EQ(dict.at("list").as_list().get_allocator().resource(), &counting);
+    EXPECT_EQ(dict.at("nested").as_dictionary().at("key").as_string().get_allocator().resource(), &counting);
+    EXPECT_EQ(Encoder::encode(*parsed), original);
+}
+
+TEST(BencodeParserArena, MonotonicArenaNeedsFewUpstreamAllocations) {
+    std::string input = "l";
+    for (int i = 0; i < 1000; ++i) {
+        input += "d3:key26:value-that-defeats-the-SSO4:sizei" + std::to_string(i) + "ee";
+    }
+    input += "e";
+
+    CountingResource upstream;
+    {
+        std::pmr::monotonic_buffer_resource arena(&upstream);
+        auto parsed = Parser::parse(input, &arena);
+        ASSERT_TRUE(parsed.has_value());
+        EXPECT_EQ(parsed->as_list().size(), 1000);
+    }
+    EXPECT_LT(upstream.allocations, 20);
+
+    std::pmr::monotonic_buffer_resource arena;
+    auto view = Parser::parse_view(input, &arena);
+    ASSERT_TRUE(view.has_value());
+    EXPECT_EQ(view->as_list()[999].as_dictionary().at("size").as_integer(), 999);
+}
+
+TEST(BencodeFlatDictionary, KeepsKeysSortedOnOutOfOrderInsert) {
+    Dictionary dict;
+    dict["spam"] = Value{Integer{1}};
+    dict["cow"] = Value{Integer{2}};
+    dict["moo"] = Value{Integer{3}};
+
+    std::vector<std::string> keys;
+    for (const auto& [key, value] : dict) {
+        keys.push_back(key);
+    }
+    EXPECT_EQ(keys, (std::vector<std::string>{"cow", "moo", "spam"}));
+    EXPECT_EQ(dict.at("moo").as_integer(), 3);
+    EXPECT_FALSE(dict.emplace("cow", Value{Integer{9}}).second);
+    EXPECT_EQ(dict.at("cow").as_integer(), 2);
+    EXPECT_THROW(dict.at("missing"), std::out_of_range);
+}
+
+TEST(BencodeFlatDictionary, BinarySearchBeyondLinearLimit) {
+    std::string input = "d";
+    for (int i = 0; i < 64; ++i) {
+        auto key = "key" + std::string(i < 10 ? "0" : "") + std::to_string(i);
+        input += std::to_string(key.size()) + ":" + key + "i" + std::to_string(i) + "e";
+    }
+    input += "e";
+
+    auto parsed = Parser::parse_view(input);
+    ASSERT_TRUE(parsed.has_value());
+    const auto& dict = parsed->as_dictionary();
+    ASSERT_EQ(dict.size(), 64);
+    for (int i = 0; i < 64; ++i) {
+        auto key = "key" + std::string(i < 10 ? "0" : "") + std::to_string(i);
+        ASSERT_TRUE(dict.contains(key));
+        EXPECT_EQ(dict.at(key).as_integer(), i);
+    }
+    EXPECT_FALSE(dict.contains("key64"));
+    EXPECT_FALSE(dict.contains("a"));
+}
+
+namespace {
+
+// Rebuilds a canonical encoding from the event stream, so any chunking must reproduce the input exactly.
+struct EchoHandler {
+    std::string out;
+    std::size_t keys{0};
+
+    void on_integer(Integer value) { out += "i" + std::to_string(value) + "e"; }
+    void on_string_begin(std::size_t length, bool is_key) {
+        out += std::to_string(length) + ":";
+        keys += is_key ? 1 : 0;
+    }
+    void on_string_data(std::string_view bytes) { out += bytes; }
+    void on_string_end() {}
+    void on_list_begin() { out += "l"; }
+    void on_list_end() { out += "e"; }
+    void on_dictionary_begin() { out += "d"; }
+    void on_dictionary_end() { out += "e"; }
+};
+
+}  // anonymous namespace
+
+TEST(BencodeStreamParser, AnyChunkingProducesSameEvents) {
+    const std::string input = "d4:listli1ei-22ee6:nestedd3:key5:valuee6:numberi42e6:string0:e";
+
+    for (std::size_t chunk_size : {1UL, 2UL, 3UL, 7UL, input.size()}) {
+        EchoHandler handler;
+        StreamParser parser(handler);
+        for (std::size_t pos = 0; pos < input.size(); pos += chunk_size) {
+            ASSERT_TRUE(parser.feed(std::string_view(input).substr(pos, chunk_size)).has_value());
+        }
+        EXPECT_TRUE(parser.done());
+        EXPECT_TRUE(parser.finish().has_value());
+        EXPECT_EQ(handler.out, input) << "chunk size " << chunk_size;
+        EXPECT_EQ(handler.keys, 5);
+    }
+}
+
+TEST(BencodeStreamParser, StringPayloadArrivesInSlices) {
+    struct Collect : EchoHandler {
+        std::size_t slices{0};
+        void on_string_data(std::string_view bytes) {
+            EchoHandler::on_string_data(bytes);
+            ++slices;
+        }
+    } handler;
+
+    StreamParser parser(handler);
+    ASSERT_TRUE(parser.feed("10:abc").has_value());
+    ASSERT_TRUE(parser.feed("defg").has_value());
+    EXPECT_FALSE(parser.done());
+    EXPECT_EQ(parser.finish().error(), ParseError::UnexpectedEnd);
+    ASSERT_TRUE(parser.feed("hijTRAILING").has_value());
+    EXPECT_TRUE(parser.done());
+    EXPECT_EQ(handler.out, "10:abcdefghij");
+    EXPECT_EQ(handler.slices, 3);
+}
+
+TEST(BencodeStreamParser, RejectsMalformedInput) {
+    auto parse = [](std::string_view input) {
+        EchoHandler handler;
+        StreamParser parser(handler);
+        auto result = parser.feed(input);
+        return result ? parser.finish() : result;
+    };
+
+    EXPECT_EQ(parse("i042e").error(), ParseError::InvalidInteger);
+    EXPECT_EQ(parse("i-0e").error(), ParseError::InvalidInteger);
+    EXPECT_EQ(parse("i12").error(), ParseError::UnexpectedEnd);
+    EXPECT_EQ(parse("3x:abc").error(), ParseError::InvalidString);
+    EXPECT_EQ(parse("di42e5:valuee").error(), ParseError::InvalidFormat);
+    EXPECT_EQ(parse("d3:cowe").error(), ParseError::UnexpectedCharacter);
+    EXPECT_EQ(parse("x").error(), ParseError::UnexpectedCharacter);
+    EXPECT_EQ(parse(std::string(100, 'l')).error(), ParseError::NestingTooDeep);
+}
+
+namespace {
+
+struct TestFileEntry {
+    std::int64_t length{0};
+    std::vector<std::string_view> path;
+};
+
+struct TestInfo {
+    std::string name;
+    std::uint32_t piece_length{0};
+    std::optional<std::vector<TestFileEntry>> files;
+    std::optional<std::int64_t> length;
+};
+
+}  // anonymous namespace
+
+template <>
+struct bittorrent::bencode::Schema<TestFileEntry> {
+    static constexpr auto fields = std::tuple{
+        required_field("path", &TestFileEntry::path),
+        required_field("length", &TestFileEntry::length),
+    };
+};
+
+template <>
+struct bittorrent::bencode::Schema<TestInfo> {
+    static constexpr auto fields = std::tuple{
+        required_field("name", &TestInfo::name),
+        required_field("piece length", &TestInfo::piece_length),
+        field("files", &TestInfo::files),
+        field("length", &TestInfo::length),
+    };
+};
+
+TEST(BencodeDecode, DecodesNestedSchemaAndSkipsUnknownKeys) {
+    auto info = decode<TestInfo>(
+        "d5:filesld6:lengthi3e4:pathl1:a1:beed6:lengthi5e4:pathl1:ceee4:name4:root12:piece lengthi16384e"
+        "6:pieces0:7:privatei1ee"
+    );
+    ASSERT_TRUE(info.has_value()) << to_string(info.error());
+    EXPECT_EQ(info->name, "root");
+    EXPECT_EQ(info->piece_length, 16384u);
+    EXPECT_FALSE(info->length.has_value());
+    ASSERT_TRUE(info->files.has_value());
+    ASSERT_EQ(info->files->size(), 2u);
+    EXPECT_EQ((*info->files)[0].length, 3);
+    EXPECT_EQ((*info->files)[0].path, (std::vector<std::string_view>{"a", "b"}));
+    EXPECT_EQ((*info->files)[1].path, (std::vector<std::string_view>{"c"}));
+}
+
+TEST(BencodeDecode, ReportsPreciseErrors) {
+    auto mismatch = decode<TestInfo>("d5:filesld6:lengthi3e4:path1:aee4:name1:x12:piece lengthi1eee");
+    ASSERT_FALSE(mismatch.has_value());
+    EXPECT_EQ(mismatch.error().kind, DecodeError::Kind::TypeMismatch);
+    EXPECT_EQ(mismatch.error().field, "path");
+    EXPECT_EQ(mismatch.error().expected, TokenType::List);
+    EXPECT_EQ(mismatch.error().actual, TokenType::String);
+    EXPECT_EQ(mismatch.error().offset, 27u);
+    EXPECT_EQ(to_string(mismatch.error()), "Expected list, found string for key 'path' at offset 27");
+
+    auto missing = decode<TestInfo>("d4:name1:xe");
+    ASSERT_FALSE(missing.has_value());
+    EXPECT_EQ(missing.error().kind, DecodeError::Kind::MissingField);
+    EXPECT_EQ(missing.error().field, "piece length");
+
+    auto out_of_range = decode<TestInfo>("d4:name1:x12:piece lengthi-1ee");
+    ASSERT_FALSE(out_of_range.has_value());
+    EXPECT_EQ(out_of_range.error().kind, DecodeError::Kind::InvalidValue);
+    EXPECT_EQ(out_of_range.error().field, "piece length");
+
+    auto unsorted = decode<TestInfo>("d12:piece lengthi1e4:name1:xe");
+    ASSERT_FALSE(unsorted.has_value());
+    EXPECT_EQ(unsorted.error().kind, DecodeError::Kind::Syntax);
+    EXPECT_EQ(unsorted.error().syntax, ParseError::InvalidFormat);
+
+    auto truncated = decode<TestInfo>("d4:name1:x12:piece lengthi1e7:privateli1e");
+    ASSERT_FALSE(truncated.has_value());
+    EXPECT_EQ(truncated.error().kind, DecodeError::Kind::Syntax);
+    EXPECT_EQ(truncated.error().syntax, ParseError::UnexpectedEnd);
+}
@@ -1,5 +1,7 @@
 #include "bittorrent/utils/crypto.hpp"
 #include <gtest/gtest.h>
+#include <string>
+#include <vector>
 #include "bittorrent/core/types.hpp"
 
 using namespace bittorrent;
@@ -33,3 +35,90 @@ TEST(CryptoTest, SHA1WithNullBytes) {
     auto hex = core::to_hex_string(hash);
     EXPECT_EQ(hex.length(), 40);
 }
+
+TEST(CryptoTest, SHA1KernelsMatchOpenSsl) {
+    // Lengths around the one- and two-block padding boundaries, plus whole pieces of unequal size.
+    std::vector<std::string> buffers;
+    for (std::size_t size : {0, 1, 55, 56, 63, 64, 65, 119, 120, 128, 1000, 16384, 16391, 262144}) {
+        std::string buffer(size, '\0');
+        for (std::size_t i = 0; i < size; ++i) {
+            buffer[i] = static_cast<char>((i * 131 + size) % 251);
+        }
+        buffers.push_back(std::move(buffer));
+    }
+    const std::vector<std::string_view> inputs(buffers.begin(), buffers.end());
+
+    const auto original = utils::active_sha1_kernel();
+    ASSERT_TRUE(utils::force_sha1_kernel(utils::Sha1Kernel::OpenSsl));
+    const auto expected = utils::sha1_batch(inputs);
+    EXPECT_EQ(core::to_hex_string(expected[0]), "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+
+    for (auto kernel : {utils::Sha1Kernel::ShaNi, utils::Sha1Kernel::Avx2}) {
+        if (!utils::force_sha1_kernel(kernel)) {
+            continue;
+        }
+        SCOPED_TRACE(std::string(utils::to_string(kernel)));
+        EXPECT_EQ(utils::sha1_batch(inputs), expected);
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            EXPECT_EQ(utils::sha1(inputs[i]), expected[i]) << "size " << inputs[i].size();
+        }
+    }
+    utils::force_sha1_kernel(original);
+}
+
+TEST(CryptoTest, SHA1HasherMatchesOneShot) {
+    std::string data(3 * 16384 + 77, '\0');
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>(i * 7 % 253);
+    }
+    const auto expected = utils::sha1(data);
+
+    const auto original = utils::active_sha1_kernel();
+    for (auto kernel : {utils::Sha1Kernel::OpenSsl, utils::Sha1Kernel::ShaNi, utils::Sha1Kernel::Avx2}) {
+        if (!utils::force_sha1_kernel(kernel)) {
+            continue;
+        }
+        SCOPED_TRACE(std::string(utils::to_string(kernel)));
+
+        // Uneven chunk sizes exercise the partial-block buffering on both sides of a block boundary.
+        utils::Sha1Hasher hasher;
+        std::size_t pos = 0;
+        for (std::size_t chunk : {1, 62, 3, 64, 200, 16384}) {
+            hasher.update(std::string_view(data).substr(pos, chunk));
+            pos += chunk;
+        }
+        const auto forked = hasher;
+        hasher.update(std::string_view(data).substr(pos));
+        EXPECT_EQ(hasher.size(), data.size());
+        EXPECT_EQ(hasher.finalize(), expected);
+        EXPECT_EQ(hasher.finalize(), expected);
+
+        EXPECT_EQ(forked.finalize(), utils::sha1(std::string_view(data).substr(0, pos)));
+
+        hasher.reset();
+        EXPECT_EQ(core::to_hex_string(hasher.update("abc").finalize()), "a9993e364706816aba3e25717850c26c9cd0d89d");
+    }
+    utils::force_sha1_kernel(original);
+}
+
+TEST(CryptoTest, SHA256KnownVectors) {
+    EXPECT_EQ(
+        core::to_hex_string(utils::sha256("")), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"
+    );
+    EXPECT_EQ(
+        core::to_hex_string(utils::sha256("abc")), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"
+    );
+
+    const auto left = utils::sha256("left");
+    const auto right = utils::sha256("right");
+    std::string joined(reinterpret_cast<const char*>(left.data()), left.size());
+    joined.append(reinterpret_cast<const char*>(right.data()), right.size());
+    EXPECT_EQ(utils::sha256_pair(left, right), utils::sha256(joined));
+
+    const std::vector<std::string_view> inputs = {"a", "", "abc"};
+    std::vector<core::SHA256Hash> digests(inputs.size());
+    utils::sha256_batch(inputs, digests);
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        EXPECT_EQ(digests[i], utils::sha256(inputs[i]));
+    }
+}
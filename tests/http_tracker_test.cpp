@@ -2,11 +2,137 @@
 #include <boost/asio/co_spawn.hpp>
 #include <boost/asio/detached.hpp>
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <cstring>
+#include <set>
+#include <string>
 #include "bittorrent/core.hpp"
 #include "bittorrent/network.hpp"
 
 using namespace bittorrent;
 
+namespace {
+
+namespace asio = boost::asio;
+namespace http = boost::beast::http;
+using tcp = asio::ip::tcp;
+
+// The info-hashes in a scrape target's query, percent-decoded and sorted as bencode wants its keys.
+std::set<std::string> scraped_hashes(std::string_view target) {
+    std::set<std::string> hashes;
+    constexpr std::string_view key = "info_hash=";
+    for (auto pos = target.find(key); pos != std::string_view::npos; pos = target.find(key, pos)) {
+        pos += key.size();
+        std::string hash;
+        while (pos < target.size() && target[pos] != '&') {
+            if (target[pos] == '%') {
+                hash += static_cast<char>(std::stoi(std::string(target.substr(pos + 1, 2)), nullptr, 16));
+                pos += 3;
+            } else {
+                hash += target[pos++];
+            }
+        }
+        hashes.insert(std::move(hash));
+    }
+    return hashes;
+}
+
+// An HTTP tracker on 127.0.0.1 that answers every announce with one peer. Scrapes report the first two bytes of each
+// info-hash as its seeders and leechers. With `close_after_reply` it drops each connection right after replying
+// while still advertising keep-alive, as a server reaching its idle limit would.
+class LocalTracker {
+public:
+    explicit LocalTracker(asio::io_context& io_context, bool close_after_reply = false)
+        : acceptor_(io_context, {asio::ip::address_v4::loopback(), 0}), close_after_reply_(close_after_reply) {
+        asio::co_spawn(io_context, accept_loop(), asio::detached);
+    }
+
+    std::string url(std::string_view path = "/announce") const {
+        return "http://127.0.0.1:" + std::to_string(acceptor_.local_endpoint().port()) + std::string(path);
+    }
+
+    std::size_t connections() const { return connections_; }
+
+    std::size_t requests() const { return requests_; }
+
+    const std::string& last_target() const { return last_target_; }
+
+private:
+    asio::awaitable<void> accept_loop() {
+        for (;;) {
+            auto socket = co_await acceptor_.async_accept(asio::use_awaitable);
+            ++connections_;
+            asio::co_spawn(acceptor_.get_executor(), serve(std::move(socket)), asio::detached);
+        }
+    }
+
+    asio::awaitable<void> serve(tcp::socket socket) {
+        boost::beast::flat_buffer buffer;
+        for (;;) {
+            http::request<http::string_body> req;
+            boost::system::error_code ec;
+            co_await http::async_read(socket, buffer, req, asio::redirect_error(asio::use_awaitable, ec));
+            if (ec) {
+                co_return;
+            }
+            ++requests_;
+            last_target_ = std::string(req.target());
+
+            http::response<http::string_body> res{http::status::ok, 11};
+            if (last_target_.starts_with("/scrape")) {
+                res.body() = "d5:filesd";
+                for (const auto& hash : scraped_hashes(last_target_)) {
+                    res.body() += "20:" + hash + "d8:completei" + std::to_string(std::uint8_t(hash[0])) +
+                                  "e10:downloadedi5e10:incompletei" + std::to_string(std::uint8_t(hash[1])) + "ee";
+                }
+                res.body() += "ee";
+            } else {
+                res.body() = std::string("d8:intervali1800e5:peers6:\x7F\x00\x00\x01\x1A\xE1" "e", 33);
+            }
+            res.keep_alive(true);
+            res.prepare_payload();
+            co_await http::async_write(socket, res, asio::redirect_error(asio::use_awaitable, ec));
+            if (ec || close_after_reply_) {
+                co_return;
+            }
+        }
+    }
+
+    tcp::acceptor acceptor_;
+    bool close_after_reply_;
+    std::size_t connections_{0};
+    std::size_t requests_{0};
+    std::string last_target_;
+};
+
+// Runs `count` announces one after another, then stops the io_context, which the local tracker's accept loop would
+// otherwise keep running.
+std::vector<std::expected<network::TrackerResponse, network::TrackerError>>
+announce_sequentially(asio::io_context& io_context, network::HttpTracker& tracker, const std::string& url, int count) {
+    std::vector<std::expected<network::TrackerResponse, network::TrackerError>> results;
+    asio::co_spawn(
+        io_context,
+        [&]() -> asio::awaitable<void> {
+            core::InfoHash info_hash{};
+            core::PeerID peer_id{};
+            for (int i = 0; i < count; ++i) {
+                results.push_back(co_await tracker.announce(url, info_hash, peer_id, 6881, 0, 0, 1000));
+            }
+            io_context.stop();
+        },
+        asio::detached
+    );
+    io_context.run();
+    return results;
+}
+
+}  // anonymous namespace
+
 TEST(HttpTrackerTest, ParseCompactPeers) {
     std::string response = "d8:intervali1800e5:peers6:";
 
@@ -69,3 +195,175 @@ TEST(HttpTrackerTest, ParseMissingInterval) {
     EXPECT_FALSE(result.has_value());
     EXPECT_EQ(result.error(), network::TrackerError::InvalidResponse);
 }
+
+// Test parsing response with a wrongly typed field
+TEST(HttpTrackerTest, ParseWrongFieldType) {
+    std::string response = "d8:interval4:soon5:peers0:e";
+
+    auto result = network::HttpTracker::parse_response(response);
+
+    EXPECT_FALSE(result.has_value());
+    EXPECT_EQ(result.error(), network::TrackerError::InvalidResponse);
+}
+
+// Informational keys of the wrong type are ignored, and do not hide a failure reason
+TEST(HttpTrackerTest, ParseIgnoresMistypedInformationalFields) {
+    auto result = network::HttpTracker::parse_response("d8:complete4:many8:intervali900e5:peers0:10:tracker idi7ee");
+
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->interval.count(), 900);
+    EXPECT_EQ(result->complete, 0);
+    EXPECT_FALSE(result->tracker_id.has_value());
+
+    auto failure = network::HttpTracker::parse_response("d8:complete4:many14:failure reason6:bannede");
+
+    ASSERT_FALSE(failure.has_value());
+    EXPECT_EQ(failure.error(), network::TrackerError::TrackerFailure);
+}
+
+TEST(HttpTrackerTest, ReusesPooledConnections) {
+    asio::io_context io_context;
+    LocalTracker server(io_context);
+    network::HttpTracker tracker(io_context);
+
+    const auto results = announce_sequentially(io_context, tracker, server.url(), 3);
+    ASSERT_EQ(results.size(), 3);
+    for (const auto& result : results) {
+        ASSERT_TRUE(result.has_value());
+        ASSERT_EQ(result->peers.size(), 1);
+        EXPECT_EQ(result->peers[0].ip_string(), "127.0.0.1");
+    }
+    EXPECT_EQ(server.connections(), 1);
+    EXPECT_EQ(server.requests(), 3);
+    EXPECT_EQ(tracker.connection_pool().connections_opened(), 1);
+    EXPECT_EQ(tracker.connection_pool().connections_reused(), 2);
+    EXPECT_EQ(tracker.connection_pool().idle_count(), 1);
+    EXPECT_EQ(tracker.connection_pool().resolver().misses(), 1);
+}
+
+TEST(HttpTrackerTest, ReconnectsWhenServerClosesPooledConnection) {
+    asio::io_context io_context;
+    LocalTracker server(io_context, /* close_after_reply */ true);
+    network::HttpTracker tracker(io_context);
+
+    const auto results = announce_sequentially(io_context, tracker, server.url(), 3);
+    ASSERT_EQ(results.size(), 3);
+    for (const auto& result : results) {
+        EXPECT_TRUE(result.has_value());
+    }
+    EXPECT_EQ(server.requests(), 3);
+    EXPECT_EQ(server.connections(), 3);
+}
+
+TEST(HttpTrackerTest, ShutdownAbortsRequestsInFlight) {
+    asio::io_context io_context;
+    // Connections complete in the listen backlog, but nothing ever answers them.
+    tcp::acceptor silent(io_context, {asio::ip::address_v4::loopback(), 0});
+    const auto url = "http://127.0.0.1:" + std::to_string(silent.local_endpoint().port()) + "/announce";
+    network::HttpTracker tracker(io_context);
+
+    std::optional<std::expected<network::TrackerResponse, network::TrackerError>> result;
+    auto announce_once = [&]() -> asio::awaitable<void> {
+        core::InfoHash info_hash{};
+        core::PeerID peer_id{};
+        result = co_await tracker.announce(url, info_hash, peer_id, 6881, 0, 0, 1000);
+    };
+    asio::co_spawn(io_context, announce_once(), asio::detached);
+    asio::steady_timer delay(io_context, std::chrono::milliseconds(20));
+    delay.async_wait([&](boost::system::error_code) { tracker.shutdown(); });
+
+    // Returns by itself once the aborted announce has finished.
+    io_context.run_for(std::chrono::seconds(5));
+
+    ASSERT_TRUE(result.has_value());
+    ASSERT_FALSE(result->has_value());
+    EXPECT_EQ(result->error(), network::TrackerError::ConnectionFailed);
+    EXPECT_EQ(tracker.connection_pool().idle_count(), 0);
+}
+
+TEST(HttpTrackerTest, PoolingCanBeDisabled) {
+    asio::io_context io_context;
+    LocalTracker server(io_context);
+    auto options = network::ConnectionPool::kDefaultOptions;
+    options.max_idle_per_host = 0;
+    network::HttpTracker tracker(io_context, options);
+
+    const auto results = announce_sequentially(io_context, tracker, server.url(), 2);
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_TRUE(results[1].has_value());
+    EXPECT_EQ(server.connections(), 2);
+    EXPECT_EQ(tracker.connection_pool().idle_count(), 0);
+    EXPECT_EQ(tracker.connection_pool().resolver().hits(), 1);
+}
+
+TEST(HttpTrackerTest, ScrapeUrl) {
+    using network::HttpTracker;
+    EXPECT_EQ(HttpTracker::scrape_url("http://example.com/announce"), "http://example.com/scrape");
+    EXPECT_EQ(HttpTracker::scrape_url("http://example.com/x/announce.php?k=1"), "http://example.com/x/scrape.php?k=1");
+    EXPECT_EQ(HttpTracker::scrape_url("http://example.com/a"), std::nullopt);
+    EXPECT_EQ(HttpTracker::scrape_url("http://example.com/announce/x"), std::nullopt);
+    EXPECT_EQ(HttpTracker::scrape_url("http://example.com"), std::nullopt);
+}
+
+TEST(HttpTrackerTest, ParseScrapeFiles) {
+    const std::string first(20, 'a');
+    const std::string second(20, 'b');
+    std::string response = "d5:filesd";
+    response += "20:" + first + "d8:completei5e10:downloadedi50e10:incompletei10ee";
+    response += "20:" + second + "d8:completei1e10:downloaded3:lote";  // mistyped count, ignored
+    response += "2:zzi0e";  // not an info-hash, skipped
+    response += "ee";
+
+    auto result = network::HttpTracker::parse_scrape_response(response);
+
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(result->size(), 2);
+    core::InfoHash hash;
+    std::memcpy(hash.data(), first.data(), hash.size());
+    EXPECT_EQ(result->at(hash).complete, 5);
+    EXPECT_EQ(result->at(hash).downloaded, 50);
+    EXPECT_EQ(result->at(hash).incomplete, 10);
+    std::memcpy(hash.data(), second.data(), hash.size());
+    EXPECT_EQ(result->at(hash).complete, 1);
+    EXPECT_EQ(result->at(hash).incomplete, 0);
+}
+
+TEST(HttpTrackerTest, ParseScrapeFailureReason) {
+    auto result = network::HttpTracker::parse_scrape_response("d14:failure reason18:scrape not alloweee");
+
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(result.error(), network::TrackerError::TrackerFailure);
+}
+
+TEST(HttpTrackerTest, ScrapesInBatchesOverOneConnection) {
+    asio::io_context io_context;
+    LocalTracker server(io_context);
+    network::HttpTracker tracker(io_context);
+
+    std::vector<core::InfoHash> info_hashes(120);
+    for (std::size_t i = 0; i < info_hashes.size(); ++i) {
+        info_hashes[i].fill(std::byte{0x20});
+        info_hashes[i][0] = static_cast<std::byte>(i);
+        info_hashes[i][1] = static_cast<std::byte>(i + 1);
+    }
+
+    std::optional<std::expected<network::ScrapeResponse, network::TrackerError>> result;
+    asio::co_spawn(
+        io_context,
+        [&]() -> asio::awaitable<void> {
+            result = co_await tracker.scrape(server.url(), info_hashes);
+            io_context.stop();
+        },
+        asio::detached
+    );
+    io_context.run();
+
+    ASSERT_TRUE(result.has_value());
+    ASSERT_TRUE(result->has_value());
+    ASSERT_EQ((*result)->size(), 120);
+    EXPECT_EQ((*result)->at(info_hashes[7]).complete, 7);
+    EXPECT_EQ((*result)->at(info_hashes[7]).downloaded, 5);
+    EXPECT_EQ((*result)->at(info_hashes[7]).incomplete, 8);
+    EXPECT_EQ(server.requests(), 3);
+    EXPECT_EQ(server.connections(), 1);
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "bittorrent/core/types.hpp"
+
+namespace bittorrent::test {
+
+namespace asio = boost::asio;
+using udp = asio::ip::udp;
+
+inline void put_u32(std::vector<std::uint8_t>& out, std::uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<std::uint8_t>(value >> shift));
+    }
+}
+
+inline std::uint32_t get_u32(const std::uint8_t* in) {
+    return std::uint32_t{in[0]} << 24 | std::uint32_t{in[1]} << 16 | std::uint32_t{in[2]} << 8 | in[3];
+}
+
+// A BEP 15 tracker on 127.0.0.1. Every connect gets a new connection ID and announces carrying any other ID are
+// refused. Announces are answered with 7 seeders, 3 leechers and a single peer at 127.0.0.<peer_host> on the port
+// the client announced, so a reply can be traced back to its request.
+class LocalUdpTracker {
+public:
+    explicit LocalUdpTracker(asio::io_context& io_context, std::uint8_t peer_host = 1)
+        : socket_(io_context, {asio::ip::address_v4::loopback(), 0}), peer_host_(peer_host) {
+        asio::co_spawn(io_context, serve(), asio::detached);
+    }
+
+    std::string url() const {
+        return "udp://127.0.0.1:" + std::to_string(socket_.local_endpoint().port()) + "/announce";
+    }
+
+    // Ignores the next `count` packets, as a lossy network would.
+    void drop(std::size_t count) { drop_ = count; }
+
+    // Holds announce replies until `count` are ready, then sends them newest first.
+    void hold_announces(std::size_t count) { hold_ = count; }
+
+    // Answers announces with an error reply, as for a torrent the tracker does not know.
+    void reject_announces(bool reject) { reject_announces_ = reject; }
+
+    // Answers only the first `count` scrapes and ignores the rest.
+    void answer_scrapes(std::size_t count) { scrape_limit_ = count; }
+
+    // Re-announce interval sent with every announce reply, in seconds.
+    void set_interval(std::uint32_t seconds) { interval_ = seconds; }
+
+    std::size_t connects() const { return connects_; }
+
+    std::size_t announces() const { return announces_; }
+
+    std::size_t scrapes() const { return scrapes_; }
+
+    const core::InfoHash& last_info_hash() const { return last_info_hash_; }
+
+    // Event of the last announce: 0 none, 1 completed, 2 started, 3 stopped.
+    std::uint32_t last_event() const { return last_event_; }
+
+private:
+    asio::awaitable<void> serve() {
+        std::array<std::uint8_t, 2048> packet;
+        udp::endpoint sender;
+        std::vector<std::pair<udp::endpoint, std::vector<std::uint8_t>>> held;
+        for (;;) {
+            const auto size = co_await socket_.async_receive_from(asio::buffer(packet), sender, asio::use_awaitable);
+            if (drop_ > 0) {
+                --drop_;
+                continue;
+            }
+
+            std::vector<std::uint8_t> reply;
+            const auto action = get_u32(packet.data() + 8);
+            const bool connected = size >= 16 && get_u32(packet.data() + 4) == connection_id_;
+            if (size == 16 && action == 0) {
+                ++connects_;
+                ++connection_id_;
+                put_u32(reply, 0);
+                reply.insert(reply.end(), packet.begin() + 12, packet.begin() + 16);
+                put_u32(reply, 0);
+                put_u32(reply, connection_id_);
+            } else if (size == 98 && action == 1 && connected) {
+                ++announces_;
+                std::memcpy(last_info_hash_.data(), packet.data() + 16, last_info_hash_.size());
+                last_event_ = get_u32(packet.data() + 80);
+                if (reject_announces_) {
+                    put_u32(reply, 3);
+                    reply.insert(reply.end(), packet.begin() + 12, packet.begin() + 16);
+                    const std::string_view message = "Torrent not registered";
+                    reply.insert(reply.end(), message.begin(), message.end());
+                    co_await socket_.async_send_to(asio::buffer(reply), sender, asio::use_awaitable);
+                    continue;
+                }
+                put_u32(reply, 1);
+                reply.insert(reply.end(), packet.begin() + 12, packet.begin() + 16);
+                put_u32(reply, interval_);
+                put_u32(reply, 3);
+                put_u32(reply, 7);
+                reply.insert(reply.end(), {127, 0, 0, peer_host_, packet[96], packet[97]});
+                if (hold_ > 0) {
+                    held.emplace_back(sender, std::move(reply));
+                    if (held.size() < hold_) {
+                        continue;
+                    }
+                    for (auto it = held.rbegin(); it != held.rend(); ++it) {
+                        co_await socket_.async_send_to(asio::buffer(it->second), it->first, asio::use_awaitable);
+                    }
+                    held.clear();
+                    continue;
+                }
+            } else if (size > 16 && (size - 16) % 20 == 0 && action == 2 && connected) {
+                // Seeders and leechers are the first two bytes of each info-hash, completed downloads always 5.
+                if (scrapes_ == scrape_limit_) {
+                    continue;
+                }
+                ++scrapes_;
+                put_u32(reply, 2);
+                reply.insert(reply.end(), packet.begin() + 12, packet.begin() + 16);
+                for (std::size_t offset = 16; offset < size; offset += 20) {
+                    put_u32(reply, packet[offset]);
+                    put_u32(reply, 5);
+                    put_u32(reply, packet[offset + 1]);
+                }
+            } else {
+                put_u32(reply, 3);
+                reply.insert(reply.end(), packet.begin() + 12, packet.begin() + 16);
+                const std::string_view message = "Connection ID mismatch";
+                reply.insert(reply.end(), message.begin(), message.end());
+            }
+            co_await socket_.async_send_to(asio::buffer(reply), sender, asio::use_awaitable);
+        }
+    }
+
+    udp::socket socket_;
+    std::uint8_t peer_host_;
+    std::size_t drop_{0};
+    std::size_t hold_{0};
+    bool reject_announces_{false};
+    std::size_t connects_{0};
+    std::size_t announces_{0};
+    std::size_t scrapes_{0};
+    std::size_t scrape_limit_{std::numeric_limits<std::size_t>::max()};
+    std::uint32_t connection_id_{0};
+    std::uint32_t interval_{1800};
+    core::InfoHash last_info_hash_{};
+    std::uint32_t last_event_{0};
+};
+
+// Runs `task` to completion, then stops the io_context, which a stand-in tracker would otherwise keep running.
+inline void run(asio::io_context& io_context, asio::awaitable<void> task) {
+    asio::co_spawn(io_context, std::move(task), [&](std::exception_ptr) { io_context.stop(); });
+    io_context.run();
+}
+
+}  // namespace bittorrent::test
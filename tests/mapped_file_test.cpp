@@ -0,0 +1,71 @@
+#include "bittorrent/utils/mapped_file.hpp"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace bittorrent;
+
+namespace {
+
+class MappedFileTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = std::filesystem::temp_directory_path() /
+               ("mapped_file_test_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) + "_" +
+                ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        std::filesystem::create_directories(dir_);
+    }
+
+    void TearDown() override { std::filesystem::remove_all(dir_); }
+
+    std::filesystem::path write_file(const std::string& name, const std::string& content) {
+        auto path = dir_ / name;
+        std::ofstream(path, std::ios::binary) << content;
+        return path;
+    }
+
+    static std::string pattern(std::size_t size) {
+        std::string content(size, '\0');
+        for (std::size_t i = 0; i < size; ++i) {
+            content[i] = static_cast<char>(i * 131 % 251);
+        }
+        return content;
+    }
+
+    std::filesystem::path dir_;
+};
+
+}  // anonymous namespace
+
+TEST_F(MappedFileTest, ReadsSmallFiles) {
+    auto file = utils::MappedFile::open(write_file("small", "d4:spam4:eggse"));
+    ASSERT_TRUE(file.has_value());
+    EXPECT_FALSE(file->is_mapped());
+    EXPECT_EQ(file->view(), "d4:spam4:eggse");
+}
+
+TEST_F(MappedFileTest, MapsLargeFiles) {
+    const std::string content = pattern(utils::MappedFile::kMapThreshold * 4 + 17);
+    auto file = utils::MappedFile::open(write_file("large", content));
+    ASSERT_TRUE(file.has_value());
+    EXPECT_TRUE(file->is_mapped());
+    EXPECT_EQ(file->size(), content.size());
+    EXPECT_EQ(file->view(), content);
+
+    utils::MappedFile moved = std::move(*file);
+    EXPECT_EQ(moved.view(), content);
+    EXPECT_TRUE(file->view().empty());
+}
+
+TEST_F(MappedFileTest, HandlesEmptyFiles) {
+    auto file = utils::MappedFile::open(write_file("empty", ""));
+    ASSERT_TRUE(file.has_value());
+    EXPECT_TRUE(file->view().empty());
+}
+
+TEST_F(MappedFileTest, ReportsMissingFile) {
+    auto file = utils::MappedFile::open(dir_ / "missing");
+    ASSERT_FALSE(file.has_value());
+    EXPECT_EQ(file.error(), std::errc::no_such_file_or_directory);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace bittorrent::test {
+
+// A fresh directory under the system temp directory, named after `prefix` and the test run's random seed, and
+// removed with everything in it when the test ends, whether or not its assertions passed.
+class TempDir {
+public:
+    explicit TempDir(std::string_view prefix)
+        : path_(std::filesystem::temp_directory_path() /
+                (std::string(prefix) + "_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()))) {
+        std::filesystem::remove_all(path_);
+        std::filesystem::create_directories(path_);
+    }
+
+    ~TempDir() {
+        std::error_code ec;
+        std::filesystem::remove_all(path_, ec);
+    }
+
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    const std::filesystem::path& path() const noexcept { return path_; }
+
+private:
+    std::filesystem::path path_;
+};
+
+}  // namespace bittorrent::test
@@ -0,0 +1,96 @@
+#include "bittorrent/utils/timer_wheel.hpp"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+
+using namespace bittorrent;
+
+namespace {
+
+using Id = utils::TimerWheel::Id;
+
+// Advances `wheel` by `ticks` and returns every id that fired, with the tick it fired on.
+std::vector<std::pair<Id, std::uint64_t>> advance(utils::TimerWheel& wheel, std::uint64_t ticks) {
+    std::vector<std::pair<Id, std::uint64_t>> fired;
+    std::vector<Id> due;
+    for (std::uint64_t i = 0; i < ticks; ++i) {
+        due.clear();
+        wheel.advance(due);
+        for (auto id : due) {
+            fired.emplace_back(id, wheel.now());
+        }
+    }
+    return fired;
+}
+
+}  // anonymous namespace
+
+TEST(TimerWheelTest, FiresExactlyOnTimeAcrossLevels) {
+    const std::vector<std::uint64_t> delays{1, 2, 63, 64, 65, 127, 4095, 4096, 4097, 262143, 262144, 300000};
+    utils::TimerWheel wheel;
+    for (Id id = 0; id < delays.size(); ++id) {
+        wheel.schedule(id, delays[id]);
+    }
+    EXPECT_EQ(wheel.size(), delays.size());
+
+    const auto fired = advance(wheel, 300001);
+    ASSERT_EQ(fired.size(), delays.size());
+    for (const auto& [id, tick] : fired) {
+        EXPECT_EQ(tick, delays[id]) << "timer " << id;
+    }
+    EXPECT_EQ(wheel.size(), 0);
+}
+
+TEST(TimerWheelTest, FiresOnTimeWhenScheduledMidway) {
+    utils::TimerWheel wheel;
+    advance(wheel, 4000);
+    wheel.schedule(0, 100);   // crosses a level-1 boundary
+    wheel.schedule(1, 5000);  // crosses a level-2 boundary
+    const auto fired = advance(wheel, 5000);
+    ASSERT_EQ(fired.size(), 2);
+    EXPECT_EQ(fired[0], std::make_pair(Id{0}, std::uint64_t{4100}));
+    EXPECT_EQ(fired[1], std::make_pair(Id{1}, std::uint64_t{9000}));
+}
+
+TEST(TimerWheelTest, ZeroDelayFiresOnNextTick) {
+    utils::TimerWheel wheel;
+    wheel.schedule(3, 0);
+    const auto fired = advance(wheel, 1);
+    ASSERT_EQ(fired.size(), 1);
+    EXPECT_EQ(fired[0].first, 3);
+}
+
+TEST(TimerWheelTest, CancelledTimerNeverFires) {
+    utils::TimerWheel wheel;
+    wheel.schedule(0, 10);
+    wheel.schedule(1, 10);
+    wheel.schedule(2, 10);
+    wheel.cancel(1);
+    wheel.cancel(1);
+    wheel.cancel(42);
+    EXPECT_FALSE(wheel.scheduled(1));
+    EXPECT_EQ(wheel.size(), 2);
+
+    const auto fired = advance(wheel, 20);
+    ASSERT_EQ(fired.size(), 2);
+    EXPECT_NE(fired[0].first, 1);
+    EXPECT_NE(fired[1].first, 1);
+}
+
+TEST(TimerWheelTest, RescheduleReplacesEarlierDeadline) {
+    utils::TimerWheel wheel;
+    wheel.schedule(0, 5000);
+    wheel.schedule(0, 7);
+    EXPECT_EQ(wheel.size(), 1);
+
+    const auto fired = advance(wheel, 6000);
+    ASSERT_EQ(fired.size(), 1);
+    EXPECT_EQ(fired[0].second, 7);
+}
+
+TEST(TimerWheelTest, CapsLongDelays) {
+    utils::TimerWheel wheel;
+    wheel.schedule(0, utils::TimerWheel::kMaxDelay * 2);
+    EXPECT_TRUE(wheel.scheduled(0));
+    EXPECT_TRUE(advance(wheel, 1000).empty());
+}
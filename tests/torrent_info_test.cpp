@@ -1,6 +1,11 @@
 #include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <map>
 #include "bittorrent/bencode.hpp"
 #include "bittorrent/core.hpp"
+#include "bittorrent/utils/crypto.hpp"
+#include "temp_dir.hpp"
 
 using namespace bittorrent::core;
 using namespace bittorrent::bencode;
@@ -141,6 +146,49 @@ TEST(TorrentInfo, ParseWithOptionalFields) {
     EXPECT_EQ(torrent.announce_list()[0].size(), 2);
 }
 
+TEST(TorrentInfo, ParseFromValueView) {
+    Dictionary root;
+    root["announce"] = Value{String{"http://tracker.example.com:8080/announce"}};
+
+    Dictionary info;
+    info["name"] = Value{String{"test.txt"}};
+    info["length"] = Value{Integer{1024}};
+    info["piece length"] = Value{Integer{512}};
+    info["pieces"] = Value{String(40, '\x01')};
+    root["info"] = Value{std::move(info)};
+    Value torrent_value{std::move(root)};
+
+    std::string encoded = Encoder::encode(torrent_value);
+    auto view = Parser::parse_view(encoded);
+    ASSERT_TRUE(view.has_value());
+
+    auto from_view = TorrentInfo::from_bencode(*view);
+    auto from_value = TorrentInfo::from_bencode(torrent_value);
+    ASSERT_TRUE(from_view.has_value());
+    ASSERT_TRUE(from_value.has_value());
+
+    EXPECT_EQ(from_view->name(), "test.txt");
+    EXPECT_EQ(from_view->total_size(), 1024);
+    EXPECT_EQ(from_view->piece_count(), 2);
+    EXPECT_EQ(from_view->info_hash(), from_value->info_hash());
+}
+
+TEST(TorrentInfo, InfoHashCoversOriginalBytes) {
+    // "04:name" is a valid but non-canonical length prefix; re-encoding would write "4:name".
+    const std::string info =
+        "d6:lengthi1024e04:name8:test.txt12:piece lengthi512e6:pieces40:" + std::string(40, '\x01') + "e";
+    const std::string torrent = "d8:announce35:http://tracker.example.com/announce4:info" + info + "e";
+
+    auto result = TorrentInfo::from_bytes(torrent);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->name(), "test.txt");
+    EXPECT_EQ(result->info_hash(), bittorrent::utils::sha1(info));
+
+    auto canonical = Parser::parse(info);
+    ASSERT_TRUE(canonical.has_value());
+    EXPECT_NE(result->info_hash(), bittorrent::utils::sha1(Encoder::encode(*canonical)));
+}
+
 TEST(TorrentInfo, PieceSizeCalculation) {
     Dictionary root;
     root["announce"] = Value{String{"http://tracker.example.com:8080/announce"}};
@@ -172,6 +220,33 @@ TEST(TorrentInfo, PieceSizeCalculation) {
     EXPECT_EQ(torrent.piece_size(4), 0);
 }
 
+TEST(TorrentInfo, VerifyPiecesInBatch) {
+    std::string pieces;
+    for (int i = 0; i < 3; ++i) {
+        pieces += std::string(20, static_cast<char>('a' + i));
+    }
+    auto result = TorrentInfo::from_bytes(
+        "d8:announce4:http4:infod6:lengthi600e4:name1:f12:piece lengthi256e6:pieces60:" + pieces + "ee"
+    );
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(result->piece_hash_bytes().size(), 60);
+    EXPECT_EQ(static_cast<char>(result->piece_hash_bytes()[40]), 'c');
+
+    std::vector<SHA1Hash> hashes = result->piece_hashes();
+    hashes[1][19] ^= std::byte{1};
+    hashes.push_back(hashes[0]);
+    const std::vector<std::size_t> indices = {0, 1, 2, 7};
+
+    bool matches[4] = {};
+    EXPECT_EQ(result->verify_pieces(indices, hashes, matches), 2);
+    EXPECT_TRUE(matches[0]);
+    EXPECT_FALSE(matches[1]);
+    EXPECT_TRUE(matches[2]);
+    EXPECT_FALSE(matches[3]);
+    EXPECT_TRUE(result->verify_piece_hash(2, hashes[2]));
+    EXPECT_FALSE(result->verify_piece_hash(1, hashes[1]));
+}
+
 TEST(TorrentInfo, RejectInvalidTorrent) {
     {
         Dictionary root;
@@ -233,6 +308,545 @@ TEST(TorrentInfo, RejectInvalidTorrent) {
     }
 }
 
+TEST(TorrentInfo, LoadDirectoryReportsEveryFile) {
+    const bittorrent::test::TempDir temp("torrent_info_load");
+    const auto& dir = temp.path();
+
+    constexpr int kTorrents = 24;
+    for (int i = 0; i < kTorrents; ++i) {
+        const std::string name = "file" + std::to_string(i);
+        const std::string torrent = "d8:announce35:http://tracker.example.com/announce4:infod6:lengthi1000e4:name" +
+                                    std::to_string(name.size()) + ":" + name +
+                                    "12:piece lengthi512e6:pieces40:" + std::string(40, 'x') + "ee";
+        std::ofstream(dir / (name + ".torrent"), std::ios::binary) << torrent;
+    }
+    std::ofstream(dir / "broken.torrent", std::ios::binary) << "d8:announce";
+    std::ofstream(dir / "notes.txt", std::ios::binary) << "not a torrent";
+
+    std::map<std::string, std::expected<TorrentInfo, TorrentError>> results;
+    auto count = TorrentInfo::load_directory(
+        dir,
+        [&](const std::filesystem::path& path, std::expected<TorrentInfo, TorrentError> result) {
+            results.emplace(path.filename().string(), std::move(result));
+        },
+        4
+    );
+
+    ASSERT_TRUE(count.has_value());
+    EXPECT_EQ(*count, kTorrents + 1);
+    ASSERT_EQ(results.size(), kTorrents + 1);
+    EXPECT_FALSE(results.at("broken.torrent").has_value());
+    EXPECT_EQ(results.at("broken.torrent").error(), TorrentError::InvalidFormat);
+    ASSERT_TRUE(results.at("file7.torrent").has_value());
+    EXPECT_EQ(results.at("file7.torrent")->name(), "file7");
+
+    auto missing = TorrentInfo::load_directory(dir / "missing", [](const auto&, auto) {});
+    ASSERT_FALSE(missing.has_value());
+}
+
+TEST(MetadataCache, RoundTripsSnapshotsAndTracksSourceChanges) {
+    const bittorrent::test::TempDir temp("metadata_cache");
+    const auto& dir = temp.path();
+
+    const std::string torrent =
+        "d8:announce27:http://tracker.example.com/13:announce-listll27:http://tracker.example.com/"
+        "22:udp://backup.example:1ee7:comment4:test13:creation datei1234567890e4:infod5:filesld6:lengthi300e4:pathl"
+        "1:a5:b.binee"
+        "d6:lengthi200e4:pathl1:ceee4:name4:root12:piece lengthi256e6:pieces40:" +
+        std::string(20, 'x') + std::string(20, 'y') + "ee";
+    const auto source = dir / "sample.torrent";
+    std::ofstream(source, std::ios::binary) << torrent;
+
+    MetadataCache cache(dir / "cache");
+    EXPECT_FALSE(cache.lookup(source).has_value());
+
+    auto loaded = TorrentInfo::from_file(source, cache);
+    ASSERT_TRUE(loaded.has_value());
+
+    auto cached = cache.lookup(source);
+    ASSERT_TRUE(cached.has_value());
+    EXPECT_EQ(cached->info_hash(), loaded->info_hash());
+    EXPECT_EQ(cached->name(), "root");
+    EXPECT_EQ(cached->piece_length(), 256);
+    EXPECT_EQ(cached->total_size(), 500);
+    EXPECT_EQ(cached->piece_hashes(), loaded->piece_hashes());
+    EXPECT_EQ(cached->announce(), loaded->announce());
+    EXPECT_EQ(cached->announce_list(), loaded->announce_list());
+    EXPECT_EQ(cached->comment(), loaded->comment());
+    EXPECT_FALSE(cached->created_by().has_value());
+    EXPECT_EQ(cached->creation_date(), loaded->creation_date());
+    ASSERT_EQ(cached->files().size(), 2);
+    EXPECT_EQ(cached->files()[1].path, loaded->files()[1].path);
+    EXPECT_EQ(cached->files()[1].offset, 300);
+    EXPECT_TRUE(cache.load(loaded->info_hash()).has_value());
+
+    std::ofstream(source, std::ios::binary | std::ios::app) << " ";
+    EXPECT_FALSE(cache.lookup(source).has_value());
+
+    // Metadata read before a rewrite is not indexed under the rewritten file.
+    const auto read_stamp = MetadataCache::stamp(source);
+    ASSERT_TRUE(read_stamp.has_value());
+    std::ofstream(source, std::ios::binary | std::ios::app) << " ";
+    ASSERT_TRUE(cache.store(*loaded, source, *read_stamp).has_value());
+    EXPECT_FALSE(cache.lookup(source).has_value());
+    ASSERT_TRUE(cache.store(*loaded, source, *MetadataCache::stamp(source)).has_value());
+    EXPECT_TRUE(cache.lookup(source).has_value());
+
+    const auto snapshot = dir / "cache" / (to_hex_string(loaded->info_hash()) + ".snapshot");
+    {
+        std::fstream file(snapshot, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(-1, std::ios::end);
+        file.put('!');
+    }
+    EXPECT_FALSE(cache.load(loaded->info_hash()).has_value());
+
+    // A damaged count in the header is a miss too, not an allocation sized by it.
+    ASSERT_TRUE(cache.store(*loaded).has_value());
+    ASSERT_TRUE(cache.load(loaded->info_hash()).has_value());
+    {
+        std::fstream file(snapshot, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(124);  // piece_count
+        file.write("\xff\xff\xff\x7f", 4);
+    }
+    EXPECT_FALSE(cache.load(loaded->info_hash()).has_value());
+}
+
+TEST(FileStorage, InternsComponentsAndBuildsPathsOnDemand) {
+    FileStorage::Builder builder;
+    const std::vector<std::vector<std::string_view>> paths = {
+        {"root", "docs", "index.html"},
+        {"root", "docs", "api", "index.html"},
+        {"root", "src", "main.cpp"},
+        {"root", "docs", "readme"},
+    };
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        builder.add_file(paths[i], static_cast<std::int64_t>(10 * (i + 1)));
+    }
+    const auto files = builder.finish();
+
+    ASSERT_EQ(files.size(), 4);
+    // root, docs, api and src as directories; their names plus index.html, main.cpp and readme as components.
+    EXPECT_EQ(files.directory_count(), 4);
+    EXPECT_EQ(files.name_count(), 7);
+    EXPECT_EQ(files.path(1), std::filesystem::path("root") / "docs" / "api" / "index.html");
+    EXPECT_EQ(files.file_name(2), "main.cpp");
+    EXPECT_EQ(files.offset(3), 60);
+    EXPECT_EQ(files.length(3), 40);
+
+    std::vector<std::filesystem::path> listed;
+    for (const auto& file : files) {
+        listed.push_back(file.path);
+    }
+    EXPECT_EQ(listed.back(), std::filesystem::path("root") / "docs" / "readme");
+    EXPECT_EQ(files[2].offset, 30);
+    EXPECT_EQ(std::ranges::distance(files), 4);
+
+    FileStorage::Builder single;
+    const std::string_view name = "movie.mkv";
+    const auto one = single.add_file(std::span(&name, 1), 5).finish();
+    EXPECT_EQ(one.front().path, std::filesystem::path("movie.mkv"));
+    EXPECT_EQ(one.directory_count(), 0);
+}
+
+TEST(PieceMap, MapsPieceRangesOntoFiles) {
+    // Files of 100, 0, 300, 50 and 0 bytes under 128-byte pieces: 450 bytes in 4 pieces.
+    const std::string torrent =
+        "d8:announce4:http4:infod5:filesl"
+        "d6:lengthi100e4:pathl1:aee"
+        "d6:lengthi0e4:pathl1:bee"
+        "d6:lengthi300e4:pathl1:cee"
+        "d6:lengthi50e4:pathl1:dee"
+        "d6:lengthi0e4:pathl1:eee"
+        "e4:name4:root12:piece lengthi128e6:pieces80:" +
+        std::string(80, 'x') + "ee";
+    auto info = TorrentInfo::from_bytes(torrent);
+    ASSERT_TRUE(info.has_value());
+
+    PieceMap map(*info);
+    EXPECT_EQ(map.piece_count(), 4);
+    EXPECT_EQ(map.file_count(), 5);
+    EXPECT_EQ(map.first_file(0), 0);
+    EXPECT_EQ(map.first_file(1), 2);
+    EXPECT_EQ(map.first_file(3), 2);
+
+    auto collect = [](PieceMap::Range range) { return std::vector<FileSlice>(range.begin(), range.end()); };
+
+    EXPECT_EQ(collect(map.slices(0)), (std::vector<FileSlice>{{0, 0, 100}, {2, 0, 28}}));
+    EXPECT_EQ(collect(map.slices(1, 10, 20)), (std::vector<FileSlice>{{2, 38, 20}}));
+    EXPECT_EQ(collect(map.slices(3)), (std::vector<FileSlice>{{2, 284, 16}, {3, 0, 50}}));
+    EXPECT_EQ(collect(map.slices(0, 90, 1000)), (std::vector<FileSlice>{{0, 90, 10}, {2, 0, 28}}));
+    EXPECT_TRUE(map.slices(3, 100, 10).empty());
+    EXPECT_TRUE(map.slices(4).empty());
+    EXPECT_TRUE(map.slices(0, -1, 10).empty());
+
+    std::vector<FileSlice> batch;
+    const std::vector<std::size_t> pieces = {0, 3};
+    EXPECT_EQ(map.append_slices(pieces, batch), 4);
+    EXPECT_EQ(batch[3], (FileSlice{3, 0, 50}));
+}
+
+TEST(TorrentBuilder, HashesDirectoryTreeAcrossChunks) {
+    const bittorrent::test::TempDir temp("torrent_builder");
+    const auto& dir = temp.path();
+    const auto root = dir / "dataset";
+    std::filesystem::create_directories(root / "sub");
+
+    // Enough data for several read chunks, with file boundaries falling inside pieces.
+    const std::vector<std::pair<std::string, std::size_t>> layout = {
+        {"b.bin", 5 * 1024 * 1024 + 3}, {"a.txt", 1000}, {"sub/c.bin", 0}, {"sub/d.bin", 6 * 1024 * 1024 + 11}};
+    std::map<std::string, std::string> contents;
+    for (const auto& [name, size] : layout) {
+        std::string data(size, '\0');
+        for (std::size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<char>((i * 31 + name.size()) % 251);
+        }
+        std::ofstream(root / name, std::ios::binary) << data;
+        contents[name] = std::move(data);
+    }
+
+    auto metainfo = TorrentBuilder(root)
+                        .set_piece_length(64 * 1024)
+                        .set_announce("http://tracker.example.com/announce")
+                        .set_comment("built")
+                        .set_threads(3)
+                        .build();
+    ASSERT_TRUE(metainfo.has_value());
+
+    auto info = TorrentInfo::from_bytes(*metainfo);
+    ASSERT_TRUE(info.has_value());
+    EXPECT_EQ(info->name(), "dataset");
+    EXPECT_EQ(info->comment(), "built");
+    ASSERT_EQ(info->files().size(), 4);
+    EXPECT_EQ(info->files()[0].path, std::filesystem::path("dataset") / "a.txt");
+    EXPECT_EQ(info->files()[1].offset, 1000);
+    EXPECT_EQ(info->files()[3].path, std::filesystem::path("dataset") / "sub" / "d.bin");
+
+    // Files in sorted order, laid end to end.
+    std::string all;
+    for (const auto& [name, data] : contents) {
+        all += data;
+    }
+    ASSERT_EQ(info->total_size(), static_cast<std::int64_t>(all.size()));
+    ASSERT_EQ(info->piece_count(), (all.size() + 64 * 1024 - 1) / (64 * 1024));
+    for (std::size_t i = 0; i < info->piece_count(); ++i) {
+        const auto piece = std::string_view(all).substr(i * 64 * 1024, 64 * 1024);
+        ASSERT_EQ(info->piece_hashes()[i], bittorrent::utils::sha1(piece)) << "piece " << i;
+    }
+
+    auto single = TorrentBuilder(root / "a.txt").build();
+    ASSERT_TRUE(single.has_value());
+    auto single_info = TorrentInfo::from_bytes(*single);
+    ASSERT_TRUE(single_info.has_value());
+    EXPECT_TRUE(single_info->is_single_file());
+    EXPECT_EQ(single_info->piece_length(), 16 * 1024);
+    EXPECT_EQ(single_info->piece_hashes().front(), bittorrent::utils::sha1(contents["a.txt"]));
+
+    EXPECT_FALSE(TorrentBuilder(dir / "missing").build().has_value());
+
+    // Only powers of two within bounds; anything else is refused before a buffer is sized by it.
+    for (const std::int64_t bad : {std::int64_t{1} << 32, std::int64_t{48 * 1024}, std::int64_t{8 * 1024}}) {
+        auto rejected = TorrentBuilder(root).set_piece_length(bad).build();
+        ASSERT_FALSE(rejected.has_value());
+        EXPECT_EQ(rejected.error(), std::errc::invalid_argument);
+    }
+}
+
+TEST(RecheckEngine, ReportsValidPiecesAndHonoursCancellation) {
+    const bittorrent::test::TempDir temp("recheck");
+    const auto& dir = temp.path();
+    const auto root = dir / "data";
+    std::filesystem::create_directories(root);
+
+    const std::size_t piece = 16 * 1024;
+    for (const auto& [name, size] : std::vector<std::pair<std::string, std::size_t>>{
+             {"a.bin", 40 * piece + 100}, {"b.bin", 30 * piece}, {"c.bin", 20 * piece + 7}}) {
+        std::string data(size, '\0');
+        for (std::size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<char>((i * 17 + name[0]) % 251);
+        }
+        std::ofstream(root / name, std::ios::binary) << data;
+    }
+
+    auto metainfo = TorrentBuilder(root).set_piece_length(piece).set_announce("http://t").build();
+    ASSERT_TRUE(metainfo.has_value());
+    auto info = TorrentInfo::from_bytes(*metainfo);
+    ASSERT_TRUE(info.has_value());
+    ASSERT_EQ(info->piece_count(), 91);
+
+    std::vector<RecheckProgress> reports;
+    RecheckEngine engine(*info, dir);
+    engine.set_threads(4).set_progress_callback([&](const RecheckProgress& progress) { reports.push_back(progress); });
+
+    auto intact = engine.run();
+    ASSERT_TRUE(intact.has_value());
+    EXPECT_TRUE(intact->all());
+    ASSERT_FALSE(reports.empty());
+    EXPECT_EQ(reports.back().pieces_checked, 91);
+    EXPECT_EQ(reports.back().pieces_valid, 91);
+
+    // Corrupt one byte of piece 50 (in b.bin) and drop c.bin, which also takes out the piece it shares with b.bin.
+    {
+        std::fstream file(root / "b.bin", std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(static_cast<std::streamoff>(50 * piece - (40 * piece + 100)));
+        file.put('!');
+    }
+    std::filesystem::remove(root / "c.bin");
+
+    auto damaged = engine.run();
+    ASSERT_TRUE(damaged.has_value());
+    EXPECT_EQ(damaged->size(), 91);
+    EXPECT_TRUE(damaged->test(49));
+    EXPECT_FALSE(damaged->test(50));
+    EXPECT_TRUE(damaged->test(69));
+    EXPECT_FALSE(damaged->test(70));
+    EXPECT_FALSE(damaged->test(90));
+    EXPECT_EQ(damaged->count(), 69);
+
+    std::stop_source stop;
+    stop.request_stop();
+    auto cancelled = engine.run(stop.get_token());
+    ASSERT_FALSE(cancelled.has_value());
+    EXPECT_EQ(cancelled.error(), std::errc::operation_canceled);
+}
+
+TEST(RecheckEngine, SplitsLargeTorrentsIntoRunsAcrossWorkers) {
+    const bittorrent::test::TempDir temp("recheck_runs");
+    const auto& dir = temp.path();
+    const auto root = dir / "data";
+    std::filesystem::create_directories(root);
+
+    // 512 KiB pieces make runs of eight, so 21 pieces take three runs.
+    const std::size_t piece = 512 * 1024;
+    for (const auto& [name, size] : std::vector<std::pair<std::string, std::size_t>>{
+             {"a.bin", 9 * piece + 1000}, {"b.bin", 12 * piece - 1000 - 5}}) {
+        std::string data(size, '\0');
+        for (std::size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<char>((i * 13 + name[0]) % 251);
+        }
+        std::ofstream(root / name, std::ios::binary) << data;
+    }
+
+    auto metainfo = TorrentBuilder(root).set_piece_length(piece).set_announce("http://t").build();
+    ASSERT_TRUE(metainfo.has_value());
+    auto info = TorrentInfo::from_bytes(*metainfo);
+    ASSERT_TRUE(info.has_value());
+    ASSERT_EQ(info->piece_count(), 21);
+
+    // Piece 18 lies in the last run; piece 9 spans both files.
+    for (const auto& [name, offset] : std::vector<std::pair<std::string, std::size_t>>{
+             {"b.bin", 18 * piece - (9 * piece + 1000)}, {"a.bin", 9 * piece + 10}}) {
+        std::fstream file(root / name, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekg(static_cast<std::streamoff>(offset));
+        const auto byte = static_cast<char>(file.get() ^ 0xff);
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.put(byte);
+    }
+
+    std::vector<RecheckProgress> reports;
+    RecheckEngine engine(*info, dir);
+    engine.set_threads(3).set_progress_callback([&](const RecheckProgress& progress) { reports.push_back(progress); });
+    auto checked = engine.run();
+
+    ASSERT_TRUE(checked.has_value());
+    EXPECT_EQ(reports.size(), 3);
+    EXPECT_EQ(reports.back().pieces_checked, 21);
+    EXPECT_EQ(checked->count(), 19);
+    EXPECT_FALSE(checked->test(9));
+    EXPECT_FALSE(checked->test(18));
+    EXPECT_TRUE(checked->test(8));
+    EXPECT_TRUE(checked->test(20));
+}
+
+TEST(RecheckEngine, SizesBuffersByDataRatherThanDeclaredPieceLength) {
+    const bittorrent::test::TempDir temp("recheck_huge_piece");
+    const std::string data(1000, 'z');
+    std::ofstream(temp.path() / "one.bin", std::ios::binary) << data;
+
+    // One 1000-byte piece in a torrent that claims 1 TiB pieces.
+    const auto hash = bittorrent::utils::sha1(data);
+    const std::string torrent =
+        "d8:announce8:http://t4:infod6:lengthi1000e4:name7:one.bin12:piece lengthi1099511627776e6:pieces20:" +
+        std::string(reinterpret_cast<const char*>(hash.data()), hash.size()) + "ee";
+    auto info = TorrentInfo::from_bytes(torrent);
+    ASSERT_TRUE(info.has_value());
+
+    auto checked = RecheckEngine(*info, temp.path()).run();
+    ASSERT_TRUE(checked.has_value());
+    EXPECT_TRUE(checked->test(0));
+}
+
+TEST(Bitfield, PacksHighBitFirst) {
+    Bitfield bits(10);
+    bits.set(0);
+    bits.set(9);
+    bits.set(3);
+    bits.set(3, false);
+    EXPECT_EQ(bits.count(), 2);
+    EXPECT_TRUE(bits.test(9));
+    EXPECT_FALSE(bits.test(3));
+    ASSERT_EQ(bits.bytes().size(), 2);
+    EXPECT_EQ(bits.bytes()[0], std::byte{0x80});
+    EXPECT_EQ(bits.bytes()[1], std::byte{0x40});
+}
+
+TEST(MerkleTree, PadsToPowerOfTwoAndChecksProofs) {
+    // Six blocks, the last one short, in a tree eight leaves wide.
+    std::string data(5 * MerkleTree::kBlockSize + 100, '\0');
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>(i * 7 / 3);
+    }
+    const auto tree = MerkleTree::from_data(data);
+    ASSERT_EQ(tree.leaf_count(), 6);
+    EXPECT_EQ(tree.width(), 8);
+    EXPECT_EQ(tree.depth(), 3);
+
+    const auto leaves = tree.layer(1);
+    ASSERT_EQ(leaves.size(), 6);
+    EXPECT_EQ(leaves[5], bittorrent::utils::sha256(std::string_view(data).substr(5 * MerkleTree::kBlockSize)));
+
+    using bittorrent::utils::sha256_pair;
+    const SHA256Hash zero{};
+    const auto left = sha256_pair(sha256_pair(leaves[0], leaves[1]), sha256_pair(leaves[2], leaves[3]));
+    const auto right = sha256_pair(sha256_pair(leaves[4], leaves[5]), sha256_pair(zero, zero));
+    EXPECT_EQ(tree.root(), sha256_pair(left, right));
+    EXPECT_EQ(MerkleTree::pad_hash(2), sha256_pair(zero, zero));
+    EXPECT_EQ(MerkleTree::root_of(leaves, 8), tree.root());
+    EXPECT_EQ(MerkleTree::root_of(tree.layer(2), 4, MerkleTree::pad_hash(2)), tree.root());
+
+    for (std::size_t i = 0; i < leaves.size(); ++i) {
+        EXPECT_EQ(MerkleTree::root_from_proof(leaves[i], i, tree.proof(i)), tree.root()) << "leaf " << i;
+    }
+    EXPECT_EQ(MerkleTree::root_from_proof(leaves[5], 5, tree.proof(5, 1)), tree.layer(2)[2]);
+    EXPECT_NE(MerkleTree::root_from_proof(leaves[4], 5, tree.proof(5)), tree.root());
+
+    const auto empty = MerkleTree::from_data({});
+    EXPECT_EQ(empty.leaf_count(), 0);
+    EXPECT_EQ(empty.root(), zero);
+}
+
+TEST(TorrentInfo, ParseHybridV2Torrent) {
+    // 32 KiB pieces of two blocks. "a.bin" spans seven blocks in four pieces and needs a piece layer; "dir/b.txt"
+    // fits in one block and "e" is empty.
+    constexpr std::int64_t kPieceLength = 2 * MerkleTree::kBlockSize;
+    std::string a_data(6 * MerkleTree::kBlockSize + 1000, '\0');
+    for (std::size_t i = 0; i < a_data.size(); ++i) {
+        a_data[i] = static_cast<char>(i % 251);
+    }
+    const std::string b_data = "small file";
+    const auto a_tree = MerkleTree::from_data(a_data);
+    const auto b_tree = MerkleTree::from_data(b_data);
+    const auto a_layer = a_tree.layer(2);
+    ASSERT_EQ(a_layer.size(), 4);
+
+    auto as_string = [](std::span<const SHA256Hash> hashes) {
+        return String(reinterpret_cast<const char*>(hashes.data()), hashes.size() * sizeof(SHA256Hash));
+    };
+    auto file_node = [&](std::int64_t length, const SHA256Hash* root) {
+        Dictionary leaf;
+        leaf["length"] = Value{Integer{length}};
+        if (root) {
+            leaf["pieces root"] = Value{as_string(std::span(root, 1))};
+        }
+        Dictionary node;
+        node[""] = Value{std::move(leaf)};
+        return Value{std::move(node)};
+    };
+
+    auto make_torrent = [&](std::int64_t piece_length, std::span<const SHA256Hash> layer) {
+        Dictionary dir;
+        dir["b.txt"] = file_node(static_cast<std::int64_t>(b_data.size()), &b_tree.root());
+        Dictionary tree;
+        tree["a.bin"] = file_node(static_cast<std::int64_t>(a_data.size()), &a_tree.root());
+        tree["dir"] = Value{std::move(dir)};
+        tree["e"] = file_node(0, nullptr);
+
+        List files;
+        for (auto [name, length] : {std::pair{"a.bin", a_data.size()}, std::pair{"b.txt", b_data.size()}}) {
+            Dictionary entry;
+            entry["length"] = Value{Integer{static_cast<std::int64_t>(length)}};
+            entry["path"] = Value{List{Value{String{name}}}};
+            files.emplace_back(std::move(entry));
+        }
+
+        Dictionary info;
+        info["file tree"] = Value{std::move(tree)};
+        info["files"] = Value{std::move(files)};
+        info["meta version"] = Value{Integer{2}};
+        info["name"] = Value{String{"root"}};
+        info["piece length"] = Value{Integer{piece_length}};
+        info["pieces"] = Value{String(5 * 20, 'x')};
+
+        Dictionary piece_layers;
+        piece_layers[as_string(std::span(&a_tree.root(), 1))] = Value{as_string(layer)};
+
+        Dictionary root;
+        root["announce"] = Value{String{"http://tracker.example.com/announce"}};
+        root["info"] = Value{std::move(info)};
+        root["piece layers"] = Value{std::move(piece_layers)};
+        return Value{std::move(root)};
+    };
+
+    const auto torrent_value = make_torrent(kPieceLength, a_layer);
+    auto result = TorrentInfo::from_bencode(torrent_value);
+    ASSERT_TRUE(result.has_value());
+    const auto& torrent = *result;
+
+    ASSERT_TRUE(torrent.has_v2());
+    const auto info_bytes = Encoder::encode(torrent_value.as_dictionary().at("info"));
+    EXPECT_EQ(*torrent.info_hash_v2(), bittorrent::utils::sha256(info_bytes));
+    EXPECT_EQ(torrent.info_hash(), bittorrent::utils::sha1(info_bytes));
+    EXPECT_EQ(torrent.piece_count(), 5);
+
+    ASSERT_EQ(torrent.v2_files().size(), 3);
+    EXPECT_EQ(torrent.v2_files()[0].path, std::filesystem::path("root") / "a.bin");
+    EXPECT_EQ(torrent.v2_files()[0].piece_layer, a_layer);
+    EXPECT_EQ(torrent.v2_files()[1].path, std::filesystem::path("root") / "dir" / "b.txt");
+    EXPECT_EQ(torrent.v2_files()[1].pieces_root, b_tree.root());
+    EXPECT_TRUE(torrent.v2_files()[1].piece_layer.empty());
+    EXPECT_EQ(torrent.v2_files()[2].length, 0);
+    EXPECT_FALSE(torrent.v2_files()[2].pieces_root.has_value());
+
+    const auto a_leaves = a_tree.layer(1);
+    for (std::size_t piece = 0; piece < 4; ++piece) {
+        const auto blocks = std::span(a_leaves).subspan(2 * piece, std::min<std::size_t>(2, 7 - 2 * piece));
+        EXPECT_TRUE(torrent.verify_v2_piece(0, piece, blocks)) << "piece " << piece;
+    }
+    EXPECT_FALSE(torrent.verify_v2_piece(0, 1, std::span(a_leaves).subspan(0, 2)));
+    EXPECT_FALSE(torrent.verify_v2_piece(0, 3, std::span(a_leaves).subspan(5, 2)));
+    EXPECT_FALSE(torrent.verify_v2_piece(0, 4, std::span(a_leaves).subspan(6, 1)));
+    EXPECT_TRUE(torrent.verify_v2_piece(1, 0, b_tree.layer(1)));
+
+    EXPECT_TRUE(torrent.verify_v2_block(0, 5, a_leaves[5], a_tree.proof(5, 1)));
+    EXPECT_TRUE(torrent.verify_v2_block(0, 5, a_leaves[5], a_tree.proof(5)));
+    EXPECT_FALSE(torrent.verify_v2_block(0, 4, a_leaves[5], a_tree.proof(5, 1)));
+    EXPECT_FALSE(torrent.verify_v2_block(0, 5, a_leaves[5], a_tree.proof(5, 2)));
+    EXPECT_TRUE(torrent.verify_v2_block(1, 0, b_tree.root(), {}));
+    EXPECT_FALSE(torrent.verify_v2_block(2, 0, SHA256Hash{}, {}));
+
+    // Snapshots carry the v2 metadata too.
+    const bittorrent::test::TempDir temp("hybrid_cache");
+    const auto& dir = temp.path();
+    MetadataCache cache(dir);
+    ASSERT_TRUE(cache.store(torrent).has_value());
+    auto cached = cache.load(torrent.info_hash());
+    ASSERT_TRUE(cached.has_value());
+    EXPECT_EQ(cached->info_hash_v2(), torrent.info_hash_v2());
+    ASSERT_EQ(cached->v2_files().size(), 3);
+    EXPECT_EQ(cached->v2_files()[1].path, torrent.v2_files()[1].path);
+    EXPECT_EQ(cached->v2_files()[0].piece_layer, a_layer);
+    EXPECT_FALSE(cached->v2_files()[2].pieces_root.has_value());
+
+    auto bad_layer = a_layer;
+    bad_layer[3][0] ^= std::byte{1};
+    auto corrupt = TorrentInfo::from_bencode(make_torrent(kPieceLength, bad_layer));
+    ASSERT_FALSE(corrupt.has_value());
+    EXPECT_EQ(corrupt.error(), TorrentError::InvalidPieceLayer);
+
+    auto odd_pieces = TorrentInfo::from_bencode(make_torrent(3 * MerkleTree::kBlockSize, a_layer));
+    ASSERT_FALSE(odd_pieces.has_value());
+    EXPECT_EQ(odd_pieces.error(), TorrentError::InvalidPieceLength);
+}
+
 TEST(Types, SHA1HexConversion) {
     SHA1Hash hash;
     for (int i = 0; i < 20; ++i) {
@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <boost/asio/io_context.hpp>
+#include <chrono>
+#include <optional>
+#include "bittorrent/core.hpp"
+#include "bittorrent/network.hpp"
+#include "local_udp_tracker.hpp"
+
+using namespace bittorrent;
+
+namespace {
+
+namespace asio = boost::asio;
+using test::LocalUdpTracker;
+using test::run;
+
+using AnnounceResult = std::expected<network::TrackerResponse, network::TrackerError>;
+
+// Nothing listens on port 1, so connecting there fails at once.
+constexpr std::string_view kRefusingTracker = "http://127.0.0.1:1/announce";
+
+asio::awaitable<void> announce(network::TrackerManager& manager, std::optional<AnnounceResult>& result) {
+    core::InfoHash info_hash{};
+    core::PeerID peer_id{};
+    result = co_await manager.announce(info_hash, peer_id, 6881, 0, 0, 1000, network::TrackerEvent::Started);
+}
+
+}  // anonymous namespace
+
+TEST(TrackerManagerTest, TakesFirstAnswerInTierAndPromotesIt) {
+    asio::io_context io_context;
+    LocalUdpTracker server(io_context);
+    network::HttpTracker http(io_context);
+    network::UdpTracker udp(io_context);
+    network::TrackerManager manager(http, udp, {{std::string(kRefusingTracker), server.url()}});
+
+    std::optional<AnnounceResult> result;
+    run(io_context, announce(manager, result));
+
+    ASSERT_TRUE(result.has_value());
+    ASSERT_TRUE(result->has_value());
+    ASSERT_EQ((*result)->peers.size(), 1);
+    EXPECT_EQ((*result)->peers[0].port, 6881);
+    EXPECT_EQ(manager.tiers()[0][0], server.url());
+    EXPECT_EQ(manager.tiers()[0][1], kRefusingTracker);
+}
+
+TEST(TrackerManagerTest, FailsOverToNextTierWithoutWaitingForTimeout) {
+    asio::io_context io_context;
+    LocalUdpTracker silent(io_context);
+    silent.drop(1000);
+    LocalUdpTracker working(io_context);
+    network::HttpTracker http(io_context);
+    network::UdpTracker udp(io_context);  // 15 s until the silent tracker would even be asked again
+    auto options = network::TrackerManager::kDefaultOptions;
+    options.tier_fallback_delay = std::chrono::milliseconds(50);
+    network::TrackerManager manager(http, udp, {{silent.url()}, {working.url()}}, options);
+
+    std::optional<AnnounceResult> result;
+    const auto start = std::chrono::steady_clock::now();
+    run(io_context, announce(manager, result));
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(result->has_value());
+    EXPECT_LT(elapsed, std::chrono::seconds(5));
+    EXPECT_EQ(working.announces(), 1);
+}
+
+TEST(TrackerManagerTest, SkipsFailedTierImmediately) {
+    asio::io_context io_context;
+    LocalUdpTracker working(io_context);
+    network::HttpTracker http(io_context);
+    network::UdpTracker udp(io_context);
+    auto options = network::TrackerManager::kDefaultOptions;
+    options.tier_fallback_delay = std::chrono::hours(1);
+    network::TrackerManager manager(http, udp, {{std::string(kRefusingTracker)}, {working.url()}}, options);
+
+    std::optional<AnnounceResult> result;
+    run(io_context, announce(manager, result));
+
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(result->has_value());
+}
+
+TEST(TrackerManagerTest, MergesPeersFromAllAnsweringTrackers) {
+    asio::io_context io_context;
+    LocalUdpTracker first(io_context, 1);
+    LocalUdpTracker second(io_context, 2);
+    LocalUdpTracker duplicate(io_context, 1);
+    network::HttpTracker http(io_context);
+    network::UdpTracker udp(io_context);
+    auto options = network::TrackerManager::kDefaultOptions;
+    options.merge_window = std::chrono::seconds(5);
+    network::TrackerManager manager(http, udp, {{first.url(), second.url(), duplicate.url()}}, options);
+
+    std::optional<AnnounceResult> result;
+    run(io_context, announce(manager, result));
+
+    ASSERT_TRUE(result.has_value());
+    ASSERT_TRUE(result->has_value());
+    ASSERT_EQ((*result)->peers.size(), 2);
+    EXPECT_NE((*result)->peers[0].ip[3], (*result)->peers[1].ip[3]);
+}
+
+TEST(TrackerManagerTest, ReportsFailureWhenNoTrackerAnswers) {
+    asio::io_context io_context;
+    network::HttpTracker http(io_context);
+    network::UdpTracker udp(io_context);
+    network::TrackerManager manager(http, udp, {{std::string(kRefusingTracker)}, {"wss://tracker.example/announce"}});
+
+    std::optional<AnnounceResult> result;
+    run(io_context, announce(manager, result));
+
+    ASSERT_TRUE(result.has_value());
+    EXPECT_FALSE(result->has_value());
+}
+
+TEST(TrackerManagerTest, ScrapeGroupsTargetsByTracker) {
+    asio::io_context io_context;
+    LocalUdpTracker first(io_context);
+    LocalUdpTracker second(io_context);
+    network::HttpTracker http(io_context);
+    network::UdpTracker udp(io_context);
+
+    auto info_hash = [](std::uint8_t seeders) {
+        core::InfoHash hash{};
+        hash[0] = static_cast<std::byte>(seeders);
+        return hash;
+    };
+    // The first tracker is named two ways; both must land in one request.
+    const auto first_bare = first.url().substr(0, first.url().rfind('/'));
+    const std::vector<network::ScrapeTarget> targets{
+        {first.url(), info_hash(1)},
+        {first_bare, info_hash(2)},
+        {second.url(), info_hash(2)},
+        {second.url(), info_hash(3)},
+        {std::string(kRefusingTracker), info_hash(4)},
+    };
+
+    network::ScrapeResponse stats;
+    run(io_context, [&]() -> asio::awaitable<void> {
+        stats = co_await network::TrackerManager::scrape(http, udp, targets);
+    }());
+
+    EXPECT_EQ(stats.size(), 3);
+    EXPECT_EQ(stats[info_hash(1)].complete, 1);
+    EXPECT_EQ(stats[info_hash(3)].complete, 3);
+    EXPECT_FALSE(stats.contains(info_hash(4)));
+    EXPECT_EQ(first.scrapes(), 1);
+    EXPECT_EQ(second.scrapes(), 1);
+}
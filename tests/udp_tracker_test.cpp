@@ -0,0 +1,325 @@
+#include <gtest/gtest.h>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <vector>
+#include "bittorrent/core.hpp"
+#include "bittorrent/network.hpp"
+#include "local_udp_tracker.hpp"
+
+using namespace bittorrent;
+
+namespace {
+
+namespace asio = boost::asio;
+using test::LocalUdpTracker;
+using test::put_u32;
+using test::run;
+
+using AnnounceResult = std::expected<network::TrackerResponse, network::TrackerError>;
+
+asio::awaitable<AnnounceResult>
+announce(network::UdpTracker& tracker, const std::string& url, std::uint16_t port = 6881) {
+    core::InfoHash info_hash{};
+    info_hash.fill(std::byte{0xAB});
+    core::PeerID peer_id{};
+    co_return co_await tracker.announce(url, info_hash, peer_id, port, 0, 0, 1000, network::TrackerEvent::Started);
+}
+
+network::UdpTracker::Options fast_options() {
+    auto options = network::UdpTracker::kDefaultOptions;
+    options.initial_timeout = std::chrono::milliseconds(20);
+    return options;
+}
+
+}  // anonymous namespace
+
+TEST(UdpTrackerTest, AnnouncesAndReusesConnectionId) {
+    asio::io_context io_context;
+    LocalUdpTracker server(io_context);
+    network::UdpTracker tracker(io_context, fast_options());
+
+    std::vector<AnnounceResult> results;
+    run(io_context, [&]() -> asio::awaitable<void> {
+        results.push_back(co_await announce(tracker, server.url()));
+        results.push_back(co_await announce(tracker, server.url()));
+    }());
+
+    ASSERT_EQ(results.size(), 2);
+    for (const auto& result : results) {
+        ASSERT_TRUE(result.has_value());
+        EXPECT_EQ(result->interval.count(), 1800);
+        EXPECT_EQ(result->complete, 7);
+        EXPECT_EQ(result->incomplete, 3);
+        ASSERT_EQ(result->peers.size(), 1);
+        EXPECT_EQ(result->peers[0].ip_string(), "127.0.0.1");
+        EXPECT_EQ(result->peers[0].port, 6881);
+    }
+    EXPECT_EQ(server.connects(), 1);
+    EXPECT_EQ(server.announces(), 2);
+    EXPECT_EQ(tracker.connects_sent(), 1);
+    EXPECT_EQ(server.last_info_hash()[0], std::byte{0xAB});
+}
+
+TEST(UdpTrackerTest, ReconnectsOnceConnectionIdExpires) {
+    asio::io_context io_context;
+    LocalUdpTracker server(io_context);
+    auto options = fast_options();
+    options.connection_id_lifetime = std::chrono::seconds(0);
+    network::UdpTracker tracker(io_context, options);
+
+    std::vector<AnnounceResult> results;
+    run(io_context, [&]() -> asio::awaitable<void> {
+        results.push_back(co_await announce(tracker, server.url()));
+        results.push_back(co_await announce(tracker, server.url()));
+    }());
+
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_TRUE(results[0].has_value());
+    EXPECT_TRUE(results[1].has_value());
+    EXPECT_EQ(server.connects(), 2);
+}
+
+TEST(UdpTrackerTest, KeepsConnectionIdAfterAnnounceIsRejected) {
+    asio::io_context io_context;
+    LocalUdpTracker server(io_context);
+    server.reject_announces(true);
+    network::UdpTracker tracker(io_context, fast_options());
+
+    std::vector<AnnounceResult> results;
+    run(io_context, [&]() -> asio::awaitable<void> {
+        results.push_back(co_await announce(tracker, server.url()));
+        results.push_back(co_await announce(tracker, server.url()));
+    }());
+
+    ASSERT_EQ(results.size(), 2);
+    for (const auto& result : results) {
+        ASSERT_FALSE(result.has_value());
+        EXPECT_EQ(result.error(), network::TrackerError::TrackerFailure);
+    }
+    EXPECT_EQ(tracker.connects_sent(), 1);
+    EXPECT_EQ(server.announces(), 2);
+}
+
+TEST(UdpTrackerTest, RetransmitsLostPackets) {
+    asio::io_context io_context;
+    LocalUdpTracker server(io_context);
+    server.drop(2);
+    network::UdpTracker tracker(io_context, fast_options());
+
+    std::optional<AnnounceResult> result;
+    run(io_context, [&]() -> asio::awaitable<void> { result = co_await announce(tracker, server.url()); }());
+
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(result->has_value());
+    EXPECT_EQ(tracker.connects_sent(), 3);
+    EXPECT_EQ(server.announces(), 1);
+}
+
+TEST(UdpTrackerTest, TimesOutWhenTrackerIsSilent) {
+    asio::io_context io_context;
+    LocalUdpTracker server(io_context);
+    server.drop(100);
+    auto options = fast_options();
+    options.initial_timeout = std::chrono::milliseconds(5);
+    options.max_retransmits = 2;
+    network::UdpTracker tracker(io_context, options);
+
+    std::optional<AnnounceResult> result;
+    run(io_context, [&]() -> asio::awaitable<void> { result = co_await announce(tracker, server.url()); }());
+
+    ASSERT_TRUE(result.has_value());
+    ASSERT_FALSE(result->has_value());
+    EXPECT_EQ(result->error(), network::TrackerError::Timeout);
+    EXPECT_EQ(tracker.connects_sent(), 3);
+}
+
+TEST(UdpTrackerTest, MatchesRepliesToConcurrentAnnounces) {
+    asio::io_context io_context;
+    LocalUdpTracker server(io_context);
+    network::UdpTracker tracker(io_context, fast_options());
+
+    // Connect first so both announces carry the same connection ID, then have the server answer them in reverse.
+    run(io_context, [&]() -> asio::awaitable<void> { co_await announce(tracker, server.url()); }());
+    io_context.restart();
+    server.hold_announces(2);
+
+    std::optional<AnnounceResult> first;
+    std::optional<AnnounceResult> second;
+    int pending = 2;
+    auto announce_into = [&](std::optional<AnnounceResult>& out, std::uint16_t port) -> asio::awaitable<void> {
+        out = co_await announce(tracker, server.url(), port);
+        if (--pending == 0) {
+            io_context.stop();
+        }
+    };
+    asio::co_spawn(io_context, announce_into(first, 1001), asio::detached);
+    asio::co_spawn(io_context, announce_into(second, 1002), asio::detached);
+    io_context.run();
+
+    ASSERT_TRUE(first.has_value() && first->has_value());
+    ASSERT_TRUE(second.has_value() && second->has_value());
+    EXPECT_EQ((*first)->peers[0].port, 1001);
+    EXPECT_EQ((*second)->peers[0].port, 1002);
+    EXPECT_EQ(tracker.connects_sent(), 1);
+}
+
+TEST(UdpTrackerTest, ConcurrentRequestsShareOneConnect) {
+    asio::io_context io_context;
+    LocalUdpTracker server(io_context);
+    network::UdpTracker tracker(io_context, fast_options());
+
+    constexpr int kAnnounces = 10;
+    int pending = kAnnounces;
+    int succeeded = 0;
+    auto announce_once = [&]() -> asio::awaitable<void> {
+        auto result = co_await announce(tracker, server.url());
+        succeeded += result.has_value();
+        if (--pending == 0) {
+            io_context.stop();
+        }
+    };
+    for (int i = 0; i < kAnnounces; ++i) {
+        asio::co_spawn(io_context, announce_once(), asio::detached);
+    }
+    io_context.run();
+
+    EXPECT_EQ(succeeded, kAnnounces);
+    EXPECT_EQ(tracker.connects_sent(), 1);
+    EXPECT_EQ(server.connects(), 1);
+}
+
+TEST(UdpTrackerTest, ShutdownFailsRequestsInFlight) {
+    asio::io_context io_context;
+    LocalUdpTracker server(io_context);
+    server.drop(100);
+    network::UdpTracker tracker(io_context);
+
+    // One announce sends the connect; the others wait for it.
+    constexpr int kAnnounces = 3;
+    int pending = kAnnounces;
+    std::vector<AnnounceResult> results;
+    auto announce_once = [&]() -> asio::awaitable<void> {
+        results.push_back(co_await announce(tracker, server.url()));
+        if (--pending == 0) {
+            io_context.stop();
+        }
+    };
+    for (int i = 0; i < kAnnounces; ++i) {
+        asio::co_spawn(io_context, announce_once(), asio::detached);
+    }
+    asio::steady_timer delay(io_context, std::chrono::milliseconds(20));
+    delay.async_wait([&](boost::system::error_code) { tracker.shutdown(); });
+    io_context.run_for(std::chrono::seconds(5));
+
+    ASSERT_EQ(results.size(), kAnnounces);
+    for (const auto& result : results) {
+        ASSERT_FALSE(result.has_value());
+        EXPECT_EQ(result.error(), network::TrackerError::ConnectionFailed);
+    }
+
+    // Later requests fail at once.
+    io_context.restart();
+    std::optional<AnnounceResult> late;
+    run(io_context, [&]() -> asio::awaitable<void> { late = co_await announce(tracker, server.url()); }());
+    ASSERT_TRUE(late.has_value());
+    ASSERT_FALSE(late->has_value());
+    EXPECT_EQ(late->error(), network::TrackerError::ConnectionFailed);
+    EXPECT_EQ(tracker.connects_sent(), 1);
+}
+
+TEST(UdpTrackerTest, ParseErrorReply) {
+    std::vector<std::uint8_t> packet;
+    put_u32(packet, 3);
+    put_u32(packet, 42);
+    const std::string_view message = "Torrent not registered";
+    packet.insert(packet.end(), message.begin(), message.end());
+
+    auto result = network::UdpTracker::parse_response(packet);
+
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(result.error(), network::TrackerError::TrackerFailure);
+}
+
+TEST(UdpTrackerTest, ParseTruncatedPeers) {
+    std::vector<std::uint8_t> packet;
+    put_u32(packet, 1);
+    put_u32(packet, 42);
+    put_u32(packet, 1800);
+    put_u32(packet, 0);
+    put_u32(packet, 0);
+    packet.insert(packet.end(), {10, 0, 0, 1, 0x1A});
+
+    auto result = network::UdpTracker::parse_response(packet);
+
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(result.error(), network::TrackerError::InvalidResponse);
+}
+
+TEST(UdpTrackerTest, ScrapesInBatchesOfSeventyFour) {
+    asio::io_context io_context;
+    LocalUdpTracker server(io_context);
+    network::UdpTracker tracker(io_context, fast_options());
+
+    std::vector<core::InfoHash> info_hashes(100);
+    for (std::size_t i = 0; i < info_hashes.size(); ++i) {
+        info_hashes[i].fill(std::byte{0});
+        info_hashes[i][0] = static_cast<std::byte>(i);
+        info_hashes[i][1] = static_cast<std::byte>(i + 1);
+    }
+
+    std::optional<std::expected<network::ScrapeResponse, network::TrackerError>> result;
+    run(io_context, [&]() -> asio::awaitable<void> { result = co_await tracker.scrape(server.url(), info_hashes); }());
+
+    ASSERT_TRUE(result.has_value());
+    ASSERT_TRUE(result->has_value());
+    ASSERT_EQ((*result)->size(), 100);
+    EXPECT_EQ((*result)->at(info_hashes[42]).complete, 42);
+    EXPECT_EQ((*result)->at(info_hashes[42]).downloaded, 5);
+    EXPECT_EQ((*result)->at(info_hashes[42]).incomplete, 43);
+    EXPECT_EQ(server.scrapes(), 2);
+    EXPECT_EQ(tracker.connects_sent(), 1);
+}
+
+TEST(UdpTrackerTest, ScrapeKeepsBatchesAnsweredBeforeAFailure) {
+    asio::io_context io_context;
+    LocalUdpTracker server(io_context);
+    server.answer_scrapes(1);
+    auto options = fast_options();
+    options.max_retransmits = 1;
+    network::UdpTracker tracker(io_context, options);
+
+    std::vector<core::InfoHash> info_hashes(100);
+    for (std::size_t i = 0; i < info_hashes.size(); ++i) {
+        info_hashes[i].fill(std::byte{0});
+        info_hashes[i][0] = static_cast<std::byte>(i);
+    }
+
+    std::optional<std::expected<network::ScrapeResponse, network::TrackerError>> result;
+    run(io_context, [&]() -> asio::awaitable<void> { result = co_await tracker.scrape(server.url(), info_hashes); }());
+
+    ASSERT_TRUE(result.has_value());
+    ASSERT_TRUE(result->has_value());
+    EXPECT_EQ((*result)->size(), network::UdpTracker::kMaxScrapeHashes);
+    EXPECT_TRUE((*result)->contains(info_hashes[0]));
+    EXPECT_FALSE((*result)->contains(info_hashes[99]));
+}
+
+TEST(UdpTrackerTest, ParseScrapeRejectsExtraEntries) {
+    std::vector<core::InfoHash> info_hashes(1);
+    std::vector<std::uint8_t> packet;
+    put_u32(packet, 2);
+    put_u32(packet, 42);
+    for (int entry = 0; entry < 2; ++entry) {
+        put_u32(packet, 1);
+        put_u32(packet, 2);
+        put_u32(packet, 3);
+    }
+
+    auto result = network::UdpTracker::parse_scrape_response(packet, info_hashes);
+
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(result.error(), network::TrackerError::InvalidResponse);
+}